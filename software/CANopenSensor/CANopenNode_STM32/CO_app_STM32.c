@@ -25,12 +25,14 @@
  * limitations under the License.
  */
 #include "CO_app_STM32.h"
+#include "CO_bitTiming_STM32.h"
 #include "CANopen.h"
 #include "main.h"
 #include <stdio.h>
 #include <inttypes.h>
 
 #include "CO_storageBlank.h"
+#include "CO_gatewayBin_STM32.h"
 #include "OD.h"
 
 CANopenNodeSTM32*
@@ -53,9 +55,47 @@ CANopenNodeSTM32*
 CO_t* CO = NULL; /* CANopen object */
 
 // Global variables
-uint32_t time_old, time_current;
 CO_ReturnError_t err;
 
+/* Timebase value at the previous CO_process() and canopen_app_interrupt() calls */
+static uint32_t time_old_us;
+static uint32_t timer_old_us;
+static bool_t timerPeriodValid;
+/* Set from the CAN receive interrupt when a frame waits for CO_process() */
+static volatile bool_t processPending;
+#if CO_CONFIG_STM32_PROFILE
+static volatile uint32_t processPendingStart;
+#endif
+
+/* Bit rate configured by LSS, used by the activate bit timing command. The node is silent for the switch delay
+ * before and after the switch (CiA 305), bitRateSwitch is the step in progress. */
+static uint16_t pendingBaudrate;
+static enum { BIT_RATE_SWITCH_NONE, BIT_RATE_SWITCH_BEFORE, BIT_RATE_SWITCH_AFTER } bitRateSwitch;
+static uint32_t bitRateSwitchStart_us;
+static uint32_t bitRateSwitchDelay_us;
+
+#if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
+/* Response callback of the gateway, NULL while it is disabled. Registered again after each communication reset. */
+static size_t (*gatewayRead)(void* object, const char* buf, size_t count, uint8_t* connectionOK);
+static void* gatewayObject;
+#endif
+
+#if (CO_CONFIG_SDO_CLI) & CO_CONFIG_SDO_CLI_ENABLE
+/* Binary gateway, given the CANopen objects again after each communication reset while it is enabled */
+static CO_GWB_t binaryGateway;
+static bool_t binaryGatewayOn;
+#endif
+
+#if (CO_CONFIG_PDO) & CO_CONFIG_RPDO_ENABLE
+/* Sequence counter of each RPDO, odd while canopen_app_interrupt() writes its mapped variables */
+static volatile uint32_t rpdoSequence[OD_CNT_RPDO];
+#endif
+
+#if (CO_CONFIG_TIME) & CO_CONFIG_TIME_ENABLE
+/* Receive timestamp of the last TIME message already applied by canopen_app_alignTIME() */
+static uint32_t timeRxApplied_us;
+#endif
+
 /* This function will basically setup the CANopen node */
 int
 canopen_app_init(CANopenNodeSTM32* _canopenNodeSTM32) {
@@ -87,6 +127,7 @@ canopen_app_init(CANopenNodeSTM32* _canopenNodeSTM32) {
 
     uint32_t heapMemoryUsed;
     CO = CO_new(config_ptr, &heapMemoryUsed);
+    CO_profile_bootMark(CO_PROFILE_BOOT_CO_NEW);
     if (CO == NULL) {
         log_printf("Error: Can't allocate memory\n");
         return 1;
@@ -96,6 +137,11 @@ canopen_app_init(CANopenNodeSTM32* _canopenNodeSTM32) {
 
     canopenNodeSTM32->canOpenStack = CO;
 
+    /* Free-running microsecond timebase, keeps counting across communication resets */
+    if (HAL_TIM_Base_GetState(canopenNodeSTM32->timebaseHandle) == HAL_TIM_STATE_READY) {
+        HAL_TIM_Base_Start(canopenNodeSTM32->timebaseHandle);
+    }
+
 #if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
     err = CO_storageBlank_init(&storage, CO->CANmodule, OD_ENTRY_H1010_storeParameters,
                                OD_ENTRY_H1011_restoreDefaultParameters, storageEntries, storageEntriesCount,
@@ -111,6 +157,164 @@ canopen_app_init(CANopenNodeSTM32* _canopenNodeSTM32) {
     return 0;
 }
 
+/* LSS configure bit timing: the bit rate must be obtained exactly from the CAN clock */
+static bool_t
+canopen_app_lssCheckBitRate(void* object, uint16_t bitRate) {
+    (void)object;
+#ifdef CO_STM32_FDCAN_Driver
+    (void)bitRate;
+    return false;
+#else
+    CO_bitTiming_t timing;
+    return CO_bitTiming_compute(HAL_RCC_GetPCLK1Freq(), bitRate, &timing);
+#endif
+}
+
+/* LSS activate bit timing, the switch is done by canopen_app_process() */
+static void
+canopen_app_lssActivateBitRate(void* object, uint16_t delay) {
+    (void)object;
+    bitRateSwitch = BIT_RATE_SWITCH_BEFORE;
+    bitRateSwitchStart_us = canopen_app_time_us();
+    bitRateSwitchDelay_us = (uint32_t)delay * 1000U;
+}
+
+/* LSS store configuration */
+static bool_t
+canopen_app_lssStore(void* object, uint8_t id, uint16_t bitRate) {
+    (void)object;
+    return canopenNodeSTM32->LSSstoreFunction(id, bitRate);
+}
+
+/* Steps of the bit rate switch, returns true while the switch is in progress */
+static bool_t
+canopen_app_processBitRateSwitch(void) {
+    if (bitRateSwitch == BIT_RATE_SWITCH_NONE) {
+        return false;
+    }
+    if (CO->CANmodule->CANnormal && bitRateSwitch == BIT_RATE_SWITCH_BEFORE) {
+        /* Stop transmitting, the PDOs are not processed either. The frames in the TX mailboxes are aborted, they
+         * would be sent at the new bit rate. */
+        CO->CANmodule->CANnormal = false;
+        CO_CANmodule_abortTx(CO->CANmodule);
+        CO_CANsetConfigurationMode((void*)canopenNodeSTM32);
+    }
+    if ((canopen_app_time_us() - bitRateSwitchStart_us) < bitRateSwitchDelay_us) {
+        return true;
+    }
+
+    if (bitRateSwitch == BIT_RATE_SWITCH_BEFORE) {
+        if (CO_CANmodule_setBitRate(CO->CANmodule, pendingBaudrate)) {
+            canopenNodeSTM32->baudrate = pendingBaudrate;
+            log_printf("CANopenNode - Bit rate %u kbit/s\n", pendingBaudrate);
+        }
+        bitRateSwitch = BIT_RATE_SWITCH_AFTER;
+        bitRateSwitchStart_us = canopen_app_time_us();
+        return true;
+    }
+
+    bitRateSwitch = BIT_RATE_SWITCH_NONE;
+    CO_CANsetNormalMode(CO->CANmodule);
+    return false;
+}
+
+/* Callback from the CANopen objects (CAN receive interrupt): a frame needs CO_process() */
+static void
+canopen_app_signal(void* object) {
+    (void)object;
+#if CO_CONFIG_STM32_PROFILE
+    if (!processPending) {
+        processPendingStart = CO_profile_now();
+    }
+#endif
+    processPending = true;
+}
+
+#if (CO_CONFIG_SYNC) & CO_CONFIG_SYNC_ENABLE
+/* A received SYNC restarts the SYNC timer when CO_SYNC_process() sees it, up to one timer period late. The timer is
+ * set to the age of the frame at now_us, from its start of frame timestamp, so the SYNC window (0x1007) and the
+ * timeout are measured from the frame on the bus. Called from canopen_app_interrupt(), the CAN receive interrupt
+ * has the same priority and cannot change the timestamp meanwhile. */
+static void
+canopen_app_alignSYNC(uint32_t now_us) {
+    uint32_t rx_us;
+#if (CO_CONFIG_SYNC) & CO_CONFIG_SYNC_PRODUCER
+    if (CO->SYNC->isProducer) {
+        return;
+    }
+#endif
+    if (CO_CANrxTimestamp(CO->CANmodule, CO->SYNC, &rx_us)) {
+        int32_t age_us = (int32_t)(now_us - rx_us);
+        if (age_us > 0) {
+            CO->SYNC->timer = (uint32_t)age_us;
+        }
+    }
+}
+#endif
+
+#if (CO_CONFIG_TIME) & CO_CONFIG_TIME_ENABLE
+/* CO_TIME_process() takes the received time as the time at start_us, the timebase value the next CO_process() time
+ * difference counts from. The frame was received earlier, the time is advanced by the age of the frame at start_us.
+ * A TIME message received after CO_TIME_process() (flag set again) is left for the next call. */
+static void
+canopen_app_alignTIME(uint32_t start_us) {
+    CO_TIME_t* TIME = CO->TIME;
+    CO_NMT_internalState_t NMTstate = CO_NMT_getInternalState(CO->NMT);
+    uint32_t rx_us;
+    bool_t received;
+
+    CO_LOCK_OD(CO->CANmodule);
+    received = !CO_FLAG_READ(TIME->CANrxNew) && CO_CANrxTimestamp(CO->CANmodule, TIME, &rx_us)
+               && rx_us != timeRxApplied_us;
+    CO_UNLOCK_OD(CO->CANmodule);
+    if (!received) {
+        return;
+    }
+    timeRxApplied_us = rx_us;
+    if (!TIME->isConsumer || (NMTstate != CO_NMT_PRE_OPERATIONAL && NMTstate != CO_NMT_OPERATIONAL)) {
+        return;
+    }
+
+    int32_t age_us = (int32_t)(start_us - rx_us);
+    if (age_us > 0) {
+        uint32_t us = (uint32_t)age_us + TIME->residual_us;
+        TIME->residual_us = us % 1000U;
+        TIME->ms += us / 1000U;
+        if (TIME->ms >= ((uint32_t)1000 * 60 * 60 * 24)) {
+            TIME->ms -= ((uint32_t)1000 * 60 * 60 * 24);
+            TIME->days += 1U;
+        }
+    }
+}
+#endif
+
+uint32_t
+canopen_app_time_us(void) {
+    return __HAL_TIM_GET_COUNTER(canopenNodeSTM32->timebaseHandle);
+}
+
+void
+canopen_app_resetTimerPeriod(void) {
+    canopenNodeSTM32->timerPeriodMin_us = UINT32_MAX;
+    canopenNodeSTM32->timerPeriodMax_us = 0;
+}
+
+bool_t
+canopen_app_isBusIdle(uint32_t idle_us) {
+    if ((canopen_app_time_us() - CO->CANmodule->lastRx_us) < idle_us) {
+        return false;
+    }
+    if (CO->CANmodule->CANtxCount != 0U) {
+        return false;
+    }
+#ifndef CO_STM32_FDCAN_Driver
+    if (HAL_CAN_GetTxMailboxesFreeLevel(canopenNodeSTM32->CANHandle) != 3U) {
+        return false;
+    }
+#endif
+    return (CO->SDOserver[0].state == CO_SDO_ST_IDLE);
+}
+
 int
 canopen_app_resetCommunication() {
     /* CANopen communication reset - initialize CANopen objects *******************/
@@ -123,22 +327,38 @@ canopen_app_resetCommunication() {
     CO_CANsetConfigurationMode((void*)canopenNodeSTM32);
     CO_CANmodule_disable(CO->CANmodule);
 
-    /* initialize CANopen */
-    err = CO_CANinit(CO, canopenNodeSTM32, 0); // Bitrate for STM32 microcontroller is being set in MXCube Settings
+    /* initialize CANopen, a bit rate of 0 keeps the CubeMX configuration */
+    bitRateSwitch = BIT_RATE_SWITCH_NONE;
+    err = CO_CANinit(CO, canopenNodeSTM32, canopenNodeSTM32->baudrate);
+    if (err == CO_ERROR_ILLEGAL_BAUDRATE) {
+        log_printf("Error: bit rate %u kbit/s not supported, CubeMX configuration used\n", canopenNodeSTM32->baudrate);
+        canopenNodeSTM32->baudrate = 0;
+        err = CO_CANinit(CO, canopenNodeSTM32, 0);
+    }
     if (err != CO_ERROR_NO) {
         log_printf("Error: CAN initialization failed: %d\n", err);
         return 1;
     }
+    CO_profile_bootMark(CO_PROFILE_BOOT_CAN_INIT);
 
     CO_LSS_address_t lssAddress = {.identity = {.vendorID = OD_PERSIST_COMM.x1018_identity.vendor_ID,
                                                 .productCode = OD_PERSIST_COMM.x1018_identity.productCode,
                                                 .revisionNumber = OD_PERSIST_COMM.x1018_identity.revisionNumber,
                                                 .serialNumber = OD_PERSIST_COMM.x1018_identity.serialNumber}};
-    err = CO_LSSinit(CO, &lssAddress, &canopenNodeSTM32->desiredNodeID, &canopenNodeSTM32->baudrate);
+    pendingBaudrate = canopenNodeSTM32->baudrate;
+    err = CO_LSSinit(CO, &lssAddress, &canopenNodeSTM32->desiredNodeID, &pendingBaudrate);
     if (err != CO_ERROR_NO) {
         log_printf("Error: LSS slave initialization failed: %d\n", err);
         return 2;
     }
+    CO_LSSslave_initCheckBitRateCallback(CO->LSSslave, NULL, canopen_app_lssCheckBitRate);
+    CO_LSSslave_initActivateBitRateCallback(CO->LSSslave, NULL, canopen_app_lssActivateBitRate);
+    if (canopenNodeSTM32->LSSstoreFunction != NULL) {
+        CO_LSSslave_initCfgStoreCallback(CO->LSSslave, NULL, canopen_app_lssStore);
+    }
+#if ((CO_CONFIG_LSS) & CO_CONFIG_FLAG_CALLBACK_PRE) && ((CO_CONFIG_LSS) & CO_CONFIG_LSS_SLAVE)
+    CO_LSSslave_initCallbackPre(CO->LSSslave, NULL, canopen_app_signal);
+#endif
 
     canopenNodeSTM32->activeNodeID = canopenNodeSTM32->desiredNodeID;
     uint32_t errInfo = 0;
@@ -174,12 +394,33 @@ canopen_app_resetCommunication() {
     }
 
     /* Configure Timer interrupt function for execution every 1 millisecond */
+    timerPeriodValid = false;
+    canopen_app_resetTimerPeriod();
+    timer_old_us = canopen_app_time_us();
     HAL_TIM_Base_Start_IT(canopenNodeSTM32->timerHandle); //1ms interrupt
 
     /* Configure CAN transmit and receive interrupt */
 
     /* Configure CANopen callbacks, etc */
     if (!CO->nodeIdUnconfigured) {
+#if (CO_CONFIG_NMT) & CO_CONFIG_FLAG_CALLBACK_PRE
+        CO_NMT_initCallbackPre(CO->NMT, NULL, canopen_app_signal);
+#endif
+#if ((CO_CONFIG_HB_CONS) & CO_CONFIG_FLAG_CALLBACK_PRE) && ((CO_CONFIG_HB_CONS) & CO_CONFIG_HB_CONS_ENABLE)
+        CO_HBconsumer_initCallbackPre(CO->HBcons, NULL, canopen_app_signal);
+#endif
+#if (CO_CONFIG_EM) & CO_CONFIG_FLAG_CALLBACK_PRE
+        CO_EM_initCallbackPre(CO->em, NULL, canopen_app_signal);
+#endif
+#if (CO_CONFIG_SDO_SRV) & CO_CONFIG_FLAG_CALLBACK_PRE
+        CO_SDOserver_initCallbackPre(&CO->SDOserver[0], NULL, canopen_app_signal);
+#endif
+#if ((CO_CONFIG_SDO_CLI) & CO_CONFIG_FLAG_CALLBACK_PRE) && ((CO_CONFIG_SDO_CLI) & CO_CONFIG_SDO_CLI_ENABLE)
+        CO_SDOclient_initCallbackPre(&CO->SDOclient[0], NULL, canopen_app_signal);
+#endif
+#if ((CO_CONFIG_LSS) & CO_CONFIG_FLAG_CALLBACK_PRE) && ((CO_CONFIG_LSS) & CO_CONFIG_LSS_MASTER)
+        CO_LSSmaster_initCallbackPre(CO->LSSmaster, NULL, canopen_app_signal);
+#endif
 
 #if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
         if (storageInitError != 0) {
@@ -190,27 +431,71 @@ canopen_app_resetCommunication() {
         log_printf("CANopenNode - Node-id not initialized\n");
     }
 
+#if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
+    CO_GTWA_initRead(CO->gtwa, gatewayRead, gatewayObject);
+#endif
+#if (CO_CONFIG_SDO_CLI) & CO_CONFIG_SDO_CLI_ENABLE
+    if (binaryGatewayOn) {
+        CO_GWB_initCANopen(&binaryGateway, CO->CANmodule, CO->nodeIdUnconfigured ? NULL : &CO->SDOclient[0]);
+        CO_CANmodule_setRxMonitor(CO->CANmodule, &binaryGateway, CO_GWB_rxMonitor);
+    }
+#endif
+
     /* start CAN */
     CO_CANsetNormalMode(CO->CANmodule);
+    CO_profile_bootMark(CO_PROFILE_BOOT_CANOPEN_INIT);
 
     log_printf("CANopenNode - Running...\n");
     fflush(stdout);
-    time_old = time_current = HAL_GetTick();
+    processPending = false;
+    /* The boot-up frame is sent by the first CO_process(), run it at the next canopen_app_process() call rather than
+     * 1 ms later */
+    time_old_us = canopen_app_time_us() - 1000U;
     return 0;
 }
 
 void
 canopen_app_process() {
     /* loop for normal program execution ******************************************/
-    /* get time difference since last function call */
-    time_current = HAL_GetTick();
+    /* Run every millisecond, or immediately when a received frame waits for processing */
+    uint32_t time_current_us = canopen_app_time_us();
 
-    if ((time_current - time_old) > 0) { // Make sure more than 1ms elapsed
+    /* The node is silent during a bit rate switch, the CANopen objects are processed after it */
+    if (canopen_app_processBitRateSwitch()) {
+        return;
+    }
+
+    if (processPending || ((time_current_us - time_old_us) >= 1000U)) {
         /* CANopen process */
         CO_NMT_reset_cmd_t reset_status;
-        uint32_t timeDifference_us = (time_current - time_old) * 1000;
-        time_old = time_current;
+#if CO_CONFIG_STM32_PROFILE
+        bool_t wasPending = processPending;
+        uint32_t pendingStart = processPendingStart;
+#endif
+        processPending = false;
+        /* get time difference since last function call */
+        uint32_t timeDifference_us = time_current_us - time_old_us;
+        time_old_us = time_current_us;
+#if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
+        reset_status = CO_process(CO, gatewayRead != NULL, timeDifference_us, NULL);
+#else
         reset_status = CO_process(CO, false, timeDifference_us, NULL);
+#endif
+#if (CO_CONFIG_TIME) & CO_CONFIG_TIME_ENABLE
+        if (reset_status == CO_RESET_NOT) {
+            canopen_app_alignTIME(time_current_us);
+        }
+#endif
+#if (CO_CONFIG_SDO_CLI) & CO_CONFIG_SDO_CLI_ENABLE
+        if (binaryGatewayOn) {
+            CO_GWB_process(&binaryGateway, timeDifference_us, NULL);
+        }
+#endif
+#if CO_CONFIG_STM32_PROFILE
+        if (wasPending) {
+            CO_profile_record(CO_PROFILE_RX_PROCESS, pendingStart);
+        }
+#endif
         canopenNodeSTM32->outStatusLEDRed = CO_LED_RED(CO->LEDs, CO_LED_CANopen);
         canopenNodeSTM32->outStatusLEDGreen = CO_LED_GREEN(CO->LEDs, CO_LED_CANopen);
 
@@ -231,17 +516,49 @@ canopen_app_process() {
 /* Thread function executes in constant intervals, this function can be called from FreeRTOS tasks or Timers ********/
 void
 canopen_app_interrupt(void) {
-    CO_LOCK_OD(CO->CANmodule);
+    /* The Object Dictionary is not locked here: this function runs at the CANopen interrupt priority, where no other
+     * code accessing the OD can preempt it, and the mainline locks its own OD accesses: the SDO server, and the
+     * application when it writes several TPDO mapped variables together (0x2100, 0x2111, 0x2140/0x2142, 0x6002).
+     * The application reads the RPDO mapped variables through the sequence counters, so interrupts are never masked
+     * for the whole PDO processing. */
+    /* get time difference since last function call, delayed or missed timer interrupts are accounted for */
+    uint32_t timer_current_us = canopen_app_time_us();
+    uint32_t timeDifference_us = timer_current_us - timer_old_us;
+    timer_old_us = timer_current_us;
+
+    if (timerPeriodValid) {
+        if (timeDifference_us < canopenNodeSTM32->timerPeriodMin_us) {
+            canopenNodeSTM32->timerPeriodMin_us = timeDifference_us;
+        }
+        if (timeDifference_us > canopenNodeSTM32->timerPeriodMax_us) {
+            canopenNodeSTM32->timerPeriodMax_us = timeDifference_us;
+        }
+    }
+    timerPeriodValid = true;
+
     if (!CO->nodeIdUnconfigured && CO->CANmodule->CANnormal) {
         bool_t syncWas = false;
-        /* get time difference since last function call */
-        uint32_t timeDifference_us = 1000; // 1ms second
 
 #if (CO_CONFIG_SYNC) & CO_CONFIG_SYNC_ENABLE
         syncWas = CO_process_SYNC(CO, timeDifference_us, NULL);
+        if (syncWas) {
+            canopen_app_alignSYNC(timer_current_us);
+        }
 #endif
 #if (CO_CONFIG_PDO) & CO_CONFIG_RPDO_ENABLE
-        CO_process_RPDO(CO, syncWas, timeDifference_us, NULL);
+        bool_t NMTisOperational = CO_NMT_getInternalState(CO->NMT) == CO_NMT_OPERATIONAL;
+
+        for (uint16_t i = 0; i < OD_CNT_RPDO; i++) {
+            rpdoSequence[i]++; /* Odd: mapped variables are being written */
+            __DMB();
+            CO_RPDO_process(&CO->RPDO[i],
+#if (CO_CONFIG_PDO) & CO_CONFIG_RPDO_TIMERS_ENABLE
+                            timeDifference_us, NULL,
+#endif
+                            NMTisOperational, syncWas);
+            __DMB();
+            rpdoSequence[i]++;
+        }
 #endif
 #if (CO_CONFIG_PDO) & CO_CONFIG_TPDO_ENABLE
         CO_process_TPDO(CO, syncWas, timeDifference_us, NULL);
@@ -249,5 +566,91 @@ canopen_app_interrupt(void) {
 
         /* Further I/O or nonblocking application code may go here. */
     }
-    CO_UNLOCK_OD(CO->CANmodule);
 }
+
+#if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
+void
+canopen_app_gatewayEnable(size_t (*readCallback)(void* object, const char* buf, size_t count, uint8_t* connectionOK),
+                          void* object) {
+    gatewayRead = readCallback;
+    gatewayObject = object;
+    CO_GTWA_initRead(CO->gtwa, gatewayRead, gatewayObject);
+}
+
+void
+canopen_app_gatewayDisable(void) {
+    /* The next CO_process() resets the gateway */
+    gatewayRead = NULL;
+    gatewayObject = NULL;
+    CO_GTWA_initRead(CO->gtwa, NULL, NULL);
+}
+
+size_t
+canopen_app_gatewayWrite(const char* buf, size_t count) {
+    if (gatewayRead == NULL) {
+        return 0;
+    }
+    size_t written = CO_GTWA_write(CO->gtwa, buf, count);
+    if (written != 0) {
+        /* Run the command without waiting for the next millisecond */
+        processPending = true;
+    }
+    return written;
+}
+#endif
+
+#if (CO_CONFIG_SDO_CLI) & CO_CONFIG_SDO_CLI_ENABLE
+void
+canopen_app_binaryGatewayEnable(size_t (*writeCallback)(void* object, const uint8_t* buf, size_t count),
+                                void (*closeCallback)(void* object), void* object) {
+    CO_GWB_init(&binaryGateway, writeCallback, closeCallback, object);
+    CO_GWB_initCANopen(&binaryGateway, CO->CANmodule, CO->nodeIdUnconfigured ? NULL : &CO->SDOclient[0]);
+    CO_CANmodule_setRxMonitor(CO->CANmodule, &binaryGateway, CO_GWB_rxMonitor);
+    binaryGatewayOn = true;
+}
+
+void
+canopen_app_binaryGatewayDisable(void) {
+    binaryGatewayOn = false;
+    CO_CANmodule_setRxMonitor(CO->CANmodule, NULL, NULL);
+}
+
+size_t
+canopen_app_binaryGatewayWrite(const uint8_t* buf, size_t count) {
+    if (!binaryGatewayOn) {
+        return 0;
+    }
+    size_t written = CO_GWB_write(&binaryGateway, buf, count);
+    if (written != 0) {
+        /* Start the requests and answer without waiting for the next millisecond */
+        processPending = true;
+    }
+    return written;
+}
+#endif
+
+#if (CO_CONFIG_PDO) & CO_CONFIG_RPDO_ENABLE
+uint32_t
+canopen_app_rpdoReadBegin(uint16_t rpdoIndex) {
+    uint32_t sequence;
+
+    if (rpdoIndex >= OD_CNT_RPDO) {
+        return 0;
+    }
+    /* The writer is an interrupt, it always completes before the mainline resumes */
+    do {
+        sequence = rpdoSequence[rpdoIndex];
+    } while ((sequence & 1U) != 0U);
+    __DMB();
+    return sequence;
+}
+
+bool_t
+canopen_app_rpdoReadRetry(uint16_t rpdoIndex, uint32_t sequence) {
+    if (rpdoIndex >= OD_CNT_RPDO) {
+        return false;
+    }
+    __DMB();
+    return rpdoSequence[rpdoIndex] != sequence;
+}
+#endif
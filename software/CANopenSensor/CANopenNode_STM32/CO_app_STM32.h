@@ -31,11 +31,15 @@ typedef struct {
 	 * be the final NodeID, after calling canopen_app_init() you should check ActiveNodeID of CANopenNodeSTM32 structure for assigned Node ID.
 	 */
     uint8_t activeNodeID; /* Assigned Node ID */
-    uint16_t baudrate;     /* This is the baudrate you've set in your CubeMX Configuration */
+    uint16_t baudrate;     /* Bit rate in kbit/s, 0 keeps the CubeMX configuration. Changed by the LSS activate bit timing */
     TIM_HandleTypeDef*
         timerHandle; /*Pass in the timer that is going to be used for generating 1ms interrupt for tmrThread function,
 	 * please note that CANOpenSTM32 Library will override HAL_TIM_PeriodElapsedCallback function, if you also need this function in your codes, please take required steps
 	 */
+    TIM_HandleTypeDef*
+        timebaseHandle; /* Pass in a free-running 32-bit timer counting at 1MHz (TIM2 on STM32L4), it is the clock of the
+	 * CANopen timers (inhibit times, event timers, SYNC). It is started by canopen_app_init() and never stopped.
+	 */
 
     /* Pass in the CAN Handle to this function and it wil be used for all CAN Communications. It can be FDCan or CAN
 	 * and CANOpenSTM32 Driver will take of care of handling that*/
@@ -46,9 +50,13 @@ typedef struct {
 #endif
 
     void (*HWInitFunction)(); /* Pass in the function that initialize the CAN peripheral, usually MX_CAN_Init */
+    bool_t (*LSSstoreFunction)(uint8_t nodeId, uint16_t baudrate); /* Optional, stores the configuration of the LSS
+                                                                      * store command, used at the next start */
 
     uint8_t outStatusLEDGreen; // This will be updated by the stack - Use them for the LED management
     uint8_t outStatusLEDRed;   // This will be updated by the stack - Use them for the LED management
+    uint32_t timerPeriodMin_us; // Shortest period between two canopen_app_interrupt() calls, measured with the timebase
+    uint32_t timerPeriodMax_us; // Longest period between two canopen_app_interrupt() calls, measured with the timebase
     CO_t* canOpenStack;
 
 } CANopenNodeSTM32;
@@ -66,6 +74,53 @@ int canopen_app_resetCommunication();
 void canopen_app_process();
 /* Thread function executes in constant intervals, this function can be called from FreeRTOS tasks or Timers ********/
 void canopen_app_interrupt(void);
+/* Current value of the microsecond timebase, use unsigned subtraction for the differences (wraps every 71 minutes) */
+uint32_t canopen_app_time_us(void);
+/* Restart the measurement of timerPeriodMin_us and timerPeriodMax_us */
+void canopen_app_resetTimerPeriod(void);
+/* True when no frame was received for idle_us, no frame waits for transmission and no SDO transfer is in progress.
+ * Used to schedule the operations which stall the CPU (flash erase) */
+bool_t canopen_app_isBusIdle(uint32_t idle_us);
+
+#if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
+/* CiA 309-3 ASCII gateway. While it is enabled, the commands given to canopen_app_gatewayWrite() are run by
+ * canopen_app_process() and the responses are given to readCallback (see CO_GTWA_initRead()), also after a
+ * communication reset. Disabling it drops the command in progress. */
+void canopen_app_gatewayEnable(size_t (*readCallback)(void* object, const char* buf, size_t count, uint8_t* connectionOK),
+                               void* object);
+void canopen_app_gatewayDisable(void);
+/* Copies command bytes in the gateway, returns the number of bytes copied, the others must be written again later */
+size_t canopen_app_gatewayWrite(const char* buf, size_t count);
+#endif
+
+#if (CO_CONFIG_SDO_CLI) & CO_CONFIG_SDO_CLI_ENABLE
+/* Binary gateway (CO_gatewayBin_STM32.h): raw CAN frames and batched SDO transfers. Used like the ASCII gateway,
+ * the frames given to canopen_app_binaryGatewayWrite() are run by canopen_app_process() and the responses are given
+ * to writeCallback. closeCallback is called when the host closes the session, the gateway must then be disabled.
+ * It shares the SDO client with the ASCII gateway, only one of them may be enabled. */
+void canopen_app_binaryGatewayEnable(size_t (*writeCallback)(void* object, const uint8_t* buf, size_t count),
+                                     void (*closeCallback)(void* object), void* object);
+void canopen_app_binaryGatewayDisable(void);
+/* Gives received bytes to the gateway, returns the number of bytes used, the others must be written again later */
+size_t canopen_app_binaryGatewayWrite(const uint8_t* buf, size_t count);
+#endif
+
+#if (CO_CONFIG_PDO) & CO_CONFIG_RPDO_ENABLE
+/* Lock-free read of the OD variables mapped to a RPDO. They are written from canopen_app_interrupt(), so the reader
+ * takes a sequence with canopen_app_rpdoReadBegin(), copies the variables and starts again while
+ * canopen_app_rpdoReadRetry() returns true. The copy is then consistent with a single received PDO. */
+uint32_t canopen_app_rpdoReadBegin(uint16_t rpdoIndex);
+bool_t canopen_app_rpdoReadRetry(uint16_t rpdoIndex, uint32_t sequence);
+
+#define CANOPEN_APP_RPDO_READ(rpdoIndex, dst, src)                                                                     \
+    do {                                                                                                               \
+        uint32_t rpdoReadSequence;                                                                                     \
+        do {                                                                                                           \
+            rpdoReadSequence = canopen_app_rpdoReadBegin(rpdoIndex);                                                   \
+            (dst) = (src);                                                                                             \
+        } while (canopen_app_rpdoReadRetry(rpdoIndex, rpdoReadSequence));                                             \
+    } while (0)
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,88 @@
+/*
+ * bxCAN bit timing calculator for the STM32 CANopenNode port.
+ *
+ * @file        CO_bitTiming_STM32.c
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CO_bitTiming_STM32.h"
+
+/* bxCAN limits, in time quanta */
+#define CO_BIT_TIMING_PRESCALER_MAX 1024U
+#define CO_BIT_TIMING_TS1_MAX       16U
+#define CO_BIT_TIMING_TS2_MAX       8U
+#define CO_BIT_TIMING_SJW_MAX       4U
+#define CO_BIT_TIMING_TQ_MIN        8U
+#define CO_BIT_TIMING_TQ_MAX        (1U + CO_BIT_TIMING_TS1_MAX + CO_BIT_TIMING_TS2_MAX)
+
+const uint16_t CO_bitTiming_rates[CO_BIT_TIMING_RATE_COUNT] = {1000, 800, 500, 250, 125, 50, 20, 10};
+
+bool
+CO_bitTiming_compute(uint32_t clock_hz, uint16_t bitRate_kbps, CO_bitTiming_t* timing) {
+    uint32_t bitRate = (uint32_t)bitRate_kbps * 1000U;
+    uint32_t bestError = UINT32_MAX;
+
+    if (bitRate == 0U || timing == NULL) {
+        return false;
+    }
+
+    /* From the most time quanta per bit, a longer one is kept only if its sample point is closer */
+    for (uint32_t tq = CO_BIT_TIMING_TQ_MAX; tq >= CO_BIT_TIMING_TQ_MIN; tq--) {
+        if ((clock_hz % (bitRate * tq)) != 0U) {
+            continue;
+        }
+        uint32_t prescaler = clock_hz / (bitRate * tq);
+        if (prescaler > CO_BIT_TIMING_PRESCALER_MAX) {
+            break;
+        }
+
+        /* Phase 2 segment rounded to the sample point, then bounded by the segment lengths */
+        uint32_t ts2 = (tq * (1000U - CO_BIT_TIMING_SAMPLE_POINT) + 500U) / 1000U;
+        if (ts2 < 1U) {
+            ts2 = 1U;
+        }
+        if (ts2 > CO_BIT_TIMING_TS2_MAX) {
+            ts2 = CO_BIT_TIMING_TS2_MAX;
+        }
+        if ((tq - 1U - ts2) > CO_BIT_TIMING_TS1_MAX) {
+            ts2 = tq - 1U - CO_BIT_TIMING_TS1_MAX;
+        }
+        uint32_t samplePoint = ((tq - ts2) * 1000U) / tq;
+        uint32_t error = (samplePoint > CO_BIT_TIMING_SAMPLE_POINT) ? (samplePoint - CO_BIT_TIMING_SAMPLE_POINT)
+                                                                     : (CO_BIT_TIMING_SAMPLE_POINT - samplePoint);
+        if (error < bestError) {
+            bestError = error;
+            timing->prescaler = (uint16_t)prescaler;
+            timing->timeSeg1 = (uint8_t)(tq - 1U - ts2);
+            timing->timeSeg2 = (uint8_t)ts2;
+            timing->syncJump = (uint8_t)((ts2 < CO_BIT_TIMING_SJW_MAX) ? ts2 : CO_BIT_TIMING_SJW_MAX);
+            timing->samplePoint = (uint16_t)samplePoint;
+        }
+    }
+    return (bestError != UINT32_MAX);
+}
+
+#ifndef CO_STM32_FDCAN_Driver
+void
+CO_bitTiming_apply(CAN_HandleTypeDef* hcan, const CO_bitTiming_t* timing) {
+    /* The HAL encodes the segments as register values, keep hcan->Init consistent with BTR */
+    hcan->Init.Prescaler = timing->prescaler;
+    hcan->Init.TimeSeg1 = (uint32_t)(timing->timeSeg1 - 1U) << CAN_BTR_TS1_Pos;
+    hcan->Init.TimeSeg2 = (uint32_t)(timing->timeSeg2 - 1U) << CAN_BTR_TS2_Pos;
+    hcan->Init.SyncJumpWidth = (uint32_t)(timing->syncJump - 1U) << CAN_BTR_SJW_Pos;
+    MODIFY_REG(hcan->Instance->BTR, CAN_BTR_BRP_Msk | CAN_BTR_TS1_Msk | CAN_BTR_TS2_Msk | CAN_BTR_SJW_Msk,
+               hcan->Init.SyncJumpWidth | hcan->Init.TimeSeg1 | hcan->Init.TimeSeg2
+                   | (uint32_t)(timing->prescaler - 1U));
+}
+#endif
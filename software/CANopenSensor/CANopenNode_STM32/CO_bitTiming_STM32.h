@@ -0,0 +1,60 @@
+/*
+ * bxCAN bit timing calculator for the STM32 CANopenNode port.
+ *
+ * @file        CO_bitTiming_STM32.h
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CO_BITTIMING_STM32_H
+#define CO_BITTIMING_STM32_H
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sample point targeted by the calculator, in 1/1000 of the bit time (CiA 301 recommends 87.5%) */
+#define CO_BIT_TIMING_SAMPLE_POINT 875
+
+/* Bit rates of the CiA 301 table, in kbit/s */
+#define CO_BIT_TIMING_RATE_COUNT 8
+extern const uint16_t CO_bitTiming_rates[CO_BIT_TIMING_RATE_COUNT];
+
+/* Bit timing of the bxCAN peripheral, a bit lasts (1 + timeSeg1 + timeSeg2) time quanta of prescaler clocks */
+typedef struct {
+    uint16_t prescaler;   /* 1..1024 */
+    uint8_t timeSeg1;     /* 1..16 time quanta, propagation and phase 1 segments */
+    uint8_t timeSeg2;     /* 1..8 time quanta, phase 2 segment */
+    uint8_t syncJump;     /* 1..4 time quanta */
+    uint16_t samplePoint; /* 1/1000 of the bit time */
+} CO_bitTiming_t;
+
+/* Exact bit timing for bitRate_kbps with the CAN kernel clock (PCLK1), the sample point is the closest to
+ * CO_BIT_TIMING_SAMPLE_POINT and the time quanta are as many as possible. Returns false if the clock can not
+ * be divided exactly. */
+bool CO_bitTiming_compute(uint32_t clock_hz, uint16_t bitRate_kbps, CO_bitTiming_t* timing);
+
+#ifndef CO_STM32_FDCAN_Driver
+/* Write the bit timing to a CAN peripheral in initialization mode (after HAL_CAN_Init(), before HAL_CAN_Start()) */
+void CO_bitTiming_apply(CAN_HandleTypeDef* hcan, const CO_bitTiming_t* timing);
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CO_BITTIMING_STM32_H */
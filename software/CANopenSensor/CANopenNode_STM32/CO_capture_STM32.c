@@ -0,0 +1,219 @@
+/*
+ * Bus capture for the STM32 CANopenNode port: every frame of the bus in a RAM ring, candump and pcap export.
+ *
+ * @file        CO_capture_STM32.c
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CO_capture_STM32.h"
+
+_Static_assert((CO_CAPTURE_SIZE & (CO_CAPTURE_SIZE - 1U)) == 0U, "CO_CAPTURE_SIZE must be a power of 2");
+_Static_assert(sizeof(CO_capture_frame_t) == 16U, "Recorded frames are 16 bytes");
+
+#define PCAP_MAGIC              0xA1B2C3D4UL /* Microsecond timestamps */
+#define PCAP_LINKTYPE_SOCKETCAN 227U
+#define SOCKETCAN_RTR_FLAG      0x40000000UL
+#define SOCKETCAN_FRAME         16U
+
+CO_capture_t CO_capture;
+
+static const char prv_hex[] = "0123456789ABCDEF";
+
+static void
+prv_put_u16(uint8_t* buf, uint16_t value) {
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+}
+
+static void
+prv_put_u32(uint8_t* buf, uint32_t value) {
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+    buf[2] = (uint8_t)(value >> 16);
+    buf[3] = (uint8_t)(value >> 24);
+}
+
+/* Decimal digits of value, width digits at least */
+static size_t
+prv_put_dec(char* buf, uint32_t value, uint8_t width) {
+    char digits[10];
+    size_t n = 0;
+
+    do {
+        digits[n++] = (char)('0' + (value % 10U));
+        value /= 10U;
+    } while ((value != 0U) || (n < width));
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = digits[n - 1U - i];
+    }
+    return n;
+}
+
+void
+CO_capture_start(CO_capture_trigger_t trigger, uint16_t id, uint16_t mask, uint32_t post) {
+    /* The CAN interrupts stop recording before the capture is changed */
+    CO_capture.state = CO_CAPTURE_IDLE;
+    __DMB();
+    CO_capture.head = 0;
+    CO_capture.trigger = (uint8_t)trigger;
+    CO_capture.triggerId = id;
+    CO_capture.triggerMask = mask;
+    CO_capture.triggerIndex = (trigger == CO_CAPTURE_TRIGGER_NONE) ? 0U : UINT32_MAX;
+    CO_capture.remaining = post;
+    __DMB();
+    CO_capture.state = (trigger == CO_CAPTURE_TRIGGER_NONE) ? CO_CAPTURE_TRIGGERED : CO_CAPTURE_ARMED;
+}
+
+void
+CO_capture_stop(void) {
+    if (CO_capture.state != CO_CAPTURE_IDLE) {
+        CO_capture.state = CO_CAPTURE_STOPPED;
+    }
+}
+
+void
+CO_capture_readerInit(CO_capture_reader_t* reader) {
+    reader->index = 0;
+    reader->lost = 0;
+    reader->lastStamp = 0;
+    reader->time_us = 0;
+    reader->started = false;
+}
+
+bool_t
+CO_capture_read(CO_capture_reader_t* reader, CO_capture_frame_t* frame, uint64_t* time_us) {
+    uint8_t state = CO_capture.state;
+
+    if ((state == CO_CAPTURE_IDLE) || (state == CO_CAPTURE_ARMED)) {
+        return false;
+    }
+
+    /* While recording, the slot of the oldest frame may be written at any time: it is not read */
+    uint32_t readable = (state == CO_CAPTURE_STOPPED) ? CO_CAPTURE_SIZE : (CO_CAPTURE_SIZE - 1U);
+
+    for (;;) {
+        uint32_t head = CO_capture.head;
+        __DMB();
+        if (head == reader->index) {
+            return false;
+        }
+        if ((head - reader->index) > readable) {
+            uint32_t skipped = head - reader->index - readable;
+            if (reader->started) {
+                reader->lost += skipped;
+            }
+            reader->index += skipped;
+        }
+
+        *frame = CO_capture.ring[reader->index & (CO_CAPTURE_SIZE - 1U)];
+
+        /* The copy may be torn if the writer reached the slot meanwhile */
+        __DMB();
+        bool_t overwritten = (CO_capture.head - reader->index) > readable;
+        reader->index++;
+        if (overwritten) {
+            if (reader->started) {
+                reader->lost++;
+            }
+            continue;
+        }
+        break;
+    }
+
+    if (!reader->started) {
+        reader->time_us = frame->timestamp_us;
+        reader->started = true;
+    } else {
+        /* The frames are in order of their interrupts, a transmission may be recorded after a later reception */
+        reader->time_us += (uint64_t)(int64_t)(int32_t)(frame->timestamp_us - reader->lastStamp);
+    }
+    reader->lastStamp = frame->timestamp_us;
+    *time_us = reader->time_us;
+    return true;
+}
+
+size_t
+CO_capture_candump(const CO_capture_frame_t* frame, uint64_t time_us, char* buf) {
+    size_t n = 0;
+    uint16_t id = frame->ident & 0x7FFU;
+    uint8_t dlc = (frame->dlc > 8U) ? 8U : frame->dlc;
+
+    buf[n++] = '(';
+    n += prv_put_dec(&buf[n], (uint32_t)(time_us / 1000000U), 10);
+    buf[n++] = '.';
+    n += prv_put_dec(&buf[n], (uint32_t)(time_us % 1000000U), 6);
+    buf[n++] = ')';
+    buf[n++] = ' ';
+    memcpy(&buf[n], CO_CAPTURE_INTERFACE " ", sizeof(CO_CAPTURE_INTERFACE));
+    n += sizeof(CO_CAPTURE_INTERFACE);
+    buf[n++] = prv_hex[id >> 8];
+    buf[n++] = prv_hex[(id >> 4) & 0xFU];
+    buf[n++] = prv_hex[id & 0xFU];
+    buf[n++] = '#';
+    if ((frame->ident & CO_CAPTURE_RTR) != 0U) {
+        buf[n++] = 'R';
+        if (dlc != 0U) {
+            buf[n++] = prv_hex[dlc];
+        }
+    } else {
+        for (uint8_t i = 0; i < dlc; i++) {
+            buf[n++] = prv_hex[frame->data[i] >> 4];
+            buf[n++] = prv_hex[frame->data[i] & 0xFU];
+        }
+    }
+    buf[n++] = '\n';
+    return n;
+}
+
+size_t
+CO_capture_pcapHeader(uint8_t* buf) {
+    prv_put_u32(&buf[0], PCAP_MAGIC);
+    prv_put_u16(&buf[4], 2);  /* Version 2.4 */
+    prv_put_u16(&buf[6], 4);
+    prv_put_u32(&buf[8], 0);  /* UTC */
+    prv_put_u32(&buf[12], 0); /* Accuracy */
+    prv_put_u32(&buf[16], SOCKETCAN_FRAME);
+    prv_put_u32(&buf[20], PCAP_LINKTYPE_SOCKETCAN);
+    return CO_CAPTURE_PCAP_HEADER;
+}
+
+size_t
+CO_capture_pcapRecord(const CO_capture_frame_t* frame, uint64_t time_us, uint8_t* buf) {
+    uint32_t canId = frame->ident & 0x7FFU;
+    uint8_t dlc = (frame->dlc > 8U) ? 8U : frame->dlc;
+
+    if ((frame->ident & CO_CAPTURE_RTR) != 0U) {
+        canId |= SOCKETCAN_RTR_FLAG;
+    }
+
+    prv_put_u32(&buf[0], (uint32_t)(time_us / 1000000U));
+    prv_put_u32(&buf[4], (uint32_t)(time_us % 1000000U));
+    prv_put_u32(&buf[8], SOCKETCAN_FRAME);
+    prv_put_u32(&buf[12], SOCKETCAN_FRAME);
+
+    /* struct can_frame, the identifier is big endian in LINKTYPE_CAN_SOCKETCAN */
+    buf[16] = (uint8_t)(canId >> 24);
+    buf[17] = (uint8_t)(canId >> 16);
+    buf[18] = (uint8_t)(canId >> 8);
+    buf[19] = (uint8_t)canId;
+    buf[20] = dlc;
+    buf[21] = 0;
+    buf[22] = 0;
+    buf[23] = 0;
+    memset(&buf[24], 0, 8);
+    if ((frame->ident & CO_CAPTURE_RTR) == 0U) {
+        memcpy(&buf[24], frame->data, dlc);
+    }
+    return CO_CAPTURE_PCAP_RECORD;
+}
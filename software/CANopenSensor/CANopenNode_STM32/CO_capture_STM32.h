@@ -0,0 +1,173 @@
+/*
+ * Bus capture for the STM32 CANopenNode port: every frame of the bus in a RAM ring, candump and pcap export.
+ *
+ * @file        CO_capture_STM32.h
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CO_CAPTURE_STM32_H
+#define CO_CAPTURE_STM32_H
+
+#include "301/CO_driver.h"
+#include "CO_profile_STM32.h"
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The CAN driver gives every received frame, whatever its identifier, and every transmitted frame (read back from
+ * its TX mailbox) to CO_capture_frame(), with the timestamp of its start of frame. The capture is written in the CAN
+ * interrupts and read from the main loop:
+ *      CO_CAPTURE_ARMED        the ring is overwritten until a frame matches the trigger, it keeps the frames before
+ *      CO_CAPTURE_TRIGGERED    'post' frames are recorded from the trigger frame on (0: until CO_capture_stop())
+ *      CO_CAPTURE_STOPPED      the ring holds the last CO_CAPTURE_SIZE frames
+ * The cost per frame is constant: no loop and no call, the 8 data bytes are always copied. It is recorded as
+ * CO_PROFILE_CAPTURE.
+ */
+#ifndef CO_CAPTURE_SIZE
+#define CO_CAPTURE_SIZE 256U /* Frames, power of 2 */
+#endif
+
+#define CO_CAPTURE_RTR  0x8000U /* Identifier flags of a recorded frame */
+#define CO_CAPTURE_TX   0x4000U /* Transmitted by this node */
+
+#define CO_CAPTURE_INTERFACE   "can0" /* Interface name of the candump lines */
+#define CO_CAPTURE_CANDUMP_MAX 64U    /* Longest candump line */
+#define CO_CAPTURE_PCAP_HEADER 24U    /* pcap file header */
+#define CO_CAPTURE_PCAP_RECORD 32U    /* pcap record header and SocketCAN frame */
+
+typedef enum {
+    CO_CAPTURE_IDLE = 0,
+    CO_CAPTURE_ARMED,
+    CO_CAPTURE_TRIGGERED,
+    CO_CAPTURE_STOPPED
+} CO_capture_state_t;
+
+typedef enum {
+    CO_CAPTURE_TRIGGER_NONE = 0, /* The first frame */
+    CO_CAPTURE_TRIGGER_ID,       /* ((identifier ^ id) & mask) == 0, RTR is bit 15 */
+    CO_CAPTURE_TRIGGER_EMCY,     /* Emergency of any node (0x081 to 0x0FF) */
+    CO_CAPTURE_TRIGGER_NMT       /* NMT command (0x000) or boot-up of any node */
+} CO_capture_trigger_t;
+
+/* Recorded frame, 16 bytes */
+typedef struct {
+    uint32_t timestamp_us; /* Start of frame, see CO_CANrxMsg_t */
+    uint16_t ident;        /* 11-bit identifier, CO_CAPTURE_RTR and CO_CAPTURE_TX */
+    uint8_t dlc;
+    uint8_t reserved;
+    uint8_t data[8];       /* Only dlc bytes are meaningful */
+} CO_capture_frame_t;
+
+typedef struct {
+    CO_capture_frame_t ring[CO_CAPTURE_SIZE];
+    volatile uint32_t head;         /* Frames recorded since the start, free running */
+    volatile uint8_t state;         /* CO_capture_state_t */
+    uint8_t trigger;                /* CO_capture_trigger_t */
+    uint16_t triggerId;
+    uint16_t triggerMask;
+    volatile uint32_t triggerIndex; /* Value of head when the trigger frame was recorded, UINT32_MAX before */
+    volatile uint32_t remaining;    /* Frames still to record after the trigger, 0: no limit */
+} CO_capture_t;
+
+/* Reader of the ring, from the main loop */
+typedef struct {
+    uint32_t index;    /* Next frame, free running as head */
+    uint32_t lost;     /* Frames overwritten before they were read */
+    uint32_t lastStamp;
+    uint64_t time_us;  /* timestamp_us of the last frame, without the 32-bit wraps */
+    bool_t started;
+} CO_capture_reader_t;
+
+extern CO_capture_t CO_capture;
+
+/* Clears the ring and arms the capture, the frames before the trigger are kept as long as the ring holds them */
+void CO_capture_start(CO_capture_trigger_t trigger, uint16_t id, uint16_t mask, uint32_t post);
+
+/* Stops the recording, the ring is kept */
+void CO_capture_stop(void);
+
+/* Starts reading from the oldest frame of the ring */
+void CO_capture_readerInit(CO_capture_reader_t* reader);
+
+/* Copies the next frame, false if there is none yet. Nothing is read while the capture waits for its trigger. The
+ * frames overwritten before the first read are skipped, the later ones are counted in reader->lost. time_us is the
+ * frame timestamp extended to 64 bits. */
+bool_t CO_capture_read(CO_capture_reader_t* reader, CO_capture_frame_t* frame, uint64_t* time_us);
+
+/* candump log line of a frame ("(sec.usec) can0 123#DEADBEEF\n"), buf holds CO_CAPTURE_CANDUMP_MAX bytes. Returns
+ * the length of the line, without terminating zero. */
+size_t CO_capture_candump(const CO_capture_frame_t* frame, uint64_t time_us, char* buf);
+
+/* pcap file header (LINKTYPE_CAN_SOCKETCAN), then one record per frame. Return CO_CAPTURE_PCAP_HEADER and
+ * CO_CAPTURE_PCAP_RECORD. */
+size_t CO_capture_pcapHeader(uint8_t* buf);
+size_t CO_capture_pcapRecord(const CO_capture_frame_t* frame, uint64_t time_us, uint8_t* buf);
+
+static inline bool_t
+CO_capture_isTrigger(const CO_capture_t* capture, uint16_t ident, uint8_t dlc, const uint8_t* data) {
+    switch (capture->trigger) {
+        case CO_CAPTURE_TRIGGER_ID:
+            return ((ident ^ capture->triggerId) & capture->triggerMask) == 0U;
+        case CO_CAPTURE_TRIGGER_EMCY:
+            return ((ident & (CO_CAPTURE_RTR | 0x780U)) == 0x080U) && ((ident & 0x7FU) != 0U);
+        case CO_CAPTURE_TRIGGER_NMT:
+            return ((ident & (CO_CAPTURE_RTR | 0x7FFU)) == 0x000U)
+                   || (((ident & (CO_CAPTURE_RTR | 0x780U)) == 0x700U) && (dlc == 1U) && (data[0] == 0U));
+        default:
+            return true;
+    }
+}
+
+/* Records a frame, from the CAN interrupts. ident holds CO_CAPTURE_RTR and CO_CAPTURE_TX, data 8 bytes. */
+static inline void
+CO_capture_frame(uint16_t ident, uint8_t dlc, const uint8_t* data, uint32_t timestamp_us) {
+    CO_capture_t* capture = &CO_capture;
+    uint8_t state = capture->state;
+
+    if ((state != CO_CAPTURE_ARMED) && (state != CO_CAPTURE_TRIGGERED)) {
+        return;
+    }
+
+    uint32_t start = CO_profile_now();
+    uint32_t head = capture->head;
+    CO_capture_frame_t* frame = &capture->ring[head & (CO_CAPTURE_SIZE - 1U)];
+    frame->timestamp_us = timestamp_us;
+    frame->ident = ident;
+    frame->dlc = dlc;
+    memcpy(frame->data, data, sizeof(frame->data));
+
+    if ((state == CO_CAPTURE_ARMED) && CO_capture_isTrigger(capture, ident, dlc, data)) {
+        capture->triggerIndex = head;
+        state = CO_CAPTURE_TRIGGERED;
+    }
+    if ((state == CO_CAPTURE_TRIGGERED) && (capture->remaining != 0U) && (--capture->remaining == 0U)) {
+        state = CO_CAPTURE_STOPPED;
+    }
+
+    /* The frame is complete before the reader can see it */
+    __DMB();
+    capture->head = head + 1U;
+    capture->state = state;
+    CO_profile_record(CO_PROFILE_CAPTURE, start);
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CO_CAPTURE_STM32_H */
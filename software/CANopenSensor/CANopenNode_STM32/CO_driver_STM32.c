@@ -30,6 +30,8 @@
  */
 #include "301/CO_driver.h"
 #include "CO_app_STM32.h"
+#include "CO_bitTiming_STM32.h"
+#include "CO_capture_STM32.h"
 
 /* Local CAN module object */
 static CO_CANmodule_t* CANModule_local = NULL; /* Local instance of global CAN module */
@@ -38,6 +40,22 @@ static CO_CANmodule_t* CANModule_local = NULL; /* Local instance of global CAN m
 #define CANID_MASK 0x07FF /*!< CAN standard ID mask */
 #define FLAG_RTR   0x8000 /*!< RTR flag, part of identifier */
 
+/* Length of a standard frame on the bus, with the worst case bit stuffing and the interframe space */
+#define CAN_FRAME_BITS(dlc) (47U + 8U * (dlc) + (33U + 8U * (dlc)) / 4U)
+
+#ifndef CO_STM32_FDCAN_Driver
+/* The CAN timer (time triggered communication mode) counts nominal bit times */
+static void
+prv_update_bit_time(CO_CANmodule_t* CANmodule) {
+    uint32_t btr = ((CAN_HandleTypeDef*)((CANopenNodeSTM32*)CANmodule->CANptr)->CANHandle)->Instance->BTR;
+    uint32_t brp = ((btr & CAN_BTR_BRP_Msk) >> CAN_BTR_BRP_Pos) + 1U;
+    uint32_t ts1 = ((btr & CAN_BTR_TS1_Msk) >> CAN_BTR_TS1_Pos) + 1U;
+    uint32_t ts2 = ((btr & CAN_BTR_TS2_Msk) >> CAN_BTR_TS2_Pos) + 1U;
+    CANmodule->bitTime_ns = (uint32_t)(((uint64_t)brp * (1U + ts1 + ts2) * 1000000000U) / HAL_RCC_GetPCLK1Freq());
+    CANmodule->timeRefValid = false;
+}
+#endif
+
 /******************************************************************************/
 void
 CO_CANsetConfigurationMode(void* CANptr) {
@@ -95,6 +113,14 @@ CO_CANmodule_init(CO_CANmodule_t* CANmodule, void* CANptr, CO_CANrx_t rxArray[],
     CANmodule->firstCANtxMessage = true;
     CANmodule->CANtxCount = 0U;
     CANmodule->errOld = 0U;
+    CANmodule->timeRefValid = false;
+    CANmodule->lastRx_us = 0U;
+    CANmodule->busBits = 0U;
+    CANmodule->rxMonitor = NULL;
+    CANmodule->rxMonitorObject = NULL;
+    for (uint8_t i = 0U; i < 3U; i++) {
+        CANmodule->txMailboxBuffer[i] = NULL;
+    }
 
     /* Reset all variables */
     for (uint16_t i = 0U; i < rxSize; i++) {
@@ -102,9 +128,11 @@ CO_CANmodule_init(CO_CANmodule_t* CANmodule, void* CANptr, CO_CANrx_t rxArray[],
         rxArray[i].mask = 0xFFFFU;
         rxArray[i].object = NULL;
         rxArray[i].CANrx_callback = NULL;
+        rxArray[i].timestamp_us = 0U;
     }
     for (uint16_t i = 0U; i < txSize; i++) {
         txArray[i].bufferFull = false;
+        txArray[i].timestamp_us = 0U;
     }
 
     /***************************************/
@@ -112,6 +140,17 @@ CO_CANmodule_init(CO_CANmodule_t* CANmodule, void* CANptr, CO_CANrx_t rxArray[],
     /***************************************/
     ((CANopenNodeSTM32*)CANptr)->HWInitFunction();
 
+#ifndef CO_STM32_FDCAN_Driver
+    /* Bit rate selected by the application or LSS, otherwise the one of the CubeMX configuration */
+    if (CANbitRate != 0U) {
+        if (!CO_CANmodule_setBitRate(CANmodule, CANbitRate)) {
+            return CO_ERROR_ILLEGAL_BAUDRATE;
+        }
+    } else {
+        prv_update_bit_time(CANmodule);
+    }
+#endif
+
     /*
      * Configure global filter that is used as last check if message did not pass any of other filters:
      *
@@ -241,6 +280,55 @@ CO_CANtxBufferInit(CO_CANmodule_t* CANmodule, uint16_t index, uint16_t ident, bo
     return buffer;
 }
 
+#ifndef CO_STM32_FDCAN_Driver
+/**
+ * \brief           Convert a CAN timer capture to a timestamp
+ *
+ * The 16-bit CAN timer counts bit times and wraps every 65536 of them (262ms at 250kbit/s). The number of wraps
+ * since the reference capture is resolved with the microsecond timebase, so the timestamps keep the accuracy of the
+ * bit time. A capture older than the reference (transmission completed while a later frame was handled) is
+ * converted without moving the reference.
+ *
+ * \param[in]       CANmodule: CAN module instance
+ * \param[in]       canTime: CAN timer captured at the start of frame
+ * \return          Timestamp in microseconds of the canopen_app_time_us() timebase
+ */
+static uint32_t
+prv_can_time_to_us(CO_CANmodule_t* CANmodule, uint16_t canTime) {
+    uint32_t now_us = canopen_app_time_us();
+
+    if (!CANmodule->timeRefValid || CANmodule->bitTime_ns == 0U) {
+        /* First capture, align the CAN time on the timebase */
+        CANmodule->timeRefValid = CANmodule->bitTime_ns != 0U;
+        CANmodule->timeRefBits = CANmodule->timeRefValid ? (uint64_t)now_us * 1000U / CANmodule->bitTime_ns : 0U;
+        CANmodule->timeRefCan = canTime;
+        CANmodule->timeRef_us = now_us;
+        return now_us;
+    }
+
+    /* Bit times elapsed since the reference, expected from the timebase and exact modulo 65536 from the capture */
+    int64_t expected = (int64_t)(((uint64_t)(now_us - CANmodule->timeRef_us) * 1000U) / CANmodule->bitTime_ns);
+    int64_t delta = (uint16_t)(canTime - CANmodule->timeRefCan);
+    int64_t wraps = expected - delta + 32768;
+    wraps = (wraps >= 0) ? (wraps / 65536) : -((-wraps + 65535) / 65536);
+    delta += wraps * 65536;
+
+    uint64_t bits = CANmodule->timeRefBits + (uint64_t)delta;
+    if (delta >= 0) {
+        CANmodule->timeRefBits = bits;
+        CANmodule->timeRefCan = canTime;
+        CANmodule->timeRef_us = now_us;
+    }
+    return (uint32_t)(bits * CANmodule->bitTime_ns / 1000U);
+}
+
+/* Index 0..2 of a CAN_TX_MAILBOXx value */
+static inline uint8_t
+prv_tx_mailbox_index(uint32_t mailbox) {
+    return mailbox == CAN_TX_MAILBOX0 ? 0U : (mailbox == CAN_TX_MAILBOX1 ? 1U : 2U);
+}
+#endif
+
 /**
  * \brief           Send CAN message to network
  * This function must be called with atomic access.
@@ -320,6 +408,7 @@ prv_send_can_message(CO_CANmodule_t* CANmodule, CO_CANtx_t* buffer) {
         tx_hdr.DLC = buffer->DLC;
         tx_hdr.StdId = buffer->ident & CANID_MASK;
         tx_hdr.RTR = (buffer->ident & FLAG_RTR) ? CAN_RTR_REMOTE : CAN_RTR_DATA;
+        tx_hdr.TransmitGlobalTime = DISABLE; /* Keep the CAN timer capture out of the data bytes */
 
         uint32_t TxMailboxNum; // Transmission MailBox number
 
@@ -327,6 +416,10 @@ prv_send_can_message(CO_CANmodule_t* CANmodule, CO_CANtx_t* buffer) {
         success = HAL_CAN_AddTxMessage(((CANopenNodeSTM32*)CANmodule->CANptr)->CANHandle, &tx_hdr, buffer->data,
                                        &TxMailboxNum)
                   == HAL_OK;
+        if (success) {
+            /* Remember the buffer for its transmit timestamp */
+            CANmodule->txMailboxBuffer[prv_tx_mailbox_index(TxMailboxNum)] = buffer;
+        }
     }
 #endif
     return success;
@@ -363,6 +456,31 @@ CO_CANsend(CO_CANmodule_t* CANmodule, CO_CANtx_t* buffer) {
     return err;
 }
 
+/******************************************************************************/
+bool_t
+CO_CANsendNow(CO_CANmodule_t* CANmodule, CO_CANtx_t* buffer) {
+    bool_t sent = false;
+
+    if (CANmodule->CANnormal) {
+        CO_LOCK_CAN_SEND(CANmodule);
+        sent = prv_send_can_message(CANmodule, buffer) != 0U;
+        CO_UNLOCK_CAN_SEND(CANmodule);
+    }
+    return sent;
+}
+
+/******************************************************************************/
+void
+CO_CANmodule_setRxMonitor(CO_CANmodule_t* CANmodule, void* object,
+                          void (*rxMonitor)(void* object, const CO_CANrxMsg_t* msg)) {
+    /* The receive interrupt never sees the new function with the previous object */
+    CANmodule->rxMonitor = NULL;
+    __DMB();
+    CANmodule->rxMonitorObject = object;
+    __DMB();
+    CANmodule->rxMonitor = rxMonitor;
+}
+
 /******************************************************************************/
 void
 CO_CANclearPendingSyncPDOs(CO_CANmodule_t* CANmodule) {
@@ -537,6 +655,8 @@ prv_read_can_received_msg(CAN_HandleTypeDef* hcan, uint32_t fifo, uint32_t fifo_
             rcvMsg.dlc = 0;
             break; /* Invalid length when more than 8 */
     }
+    /* FDCAN timestamp counter is not configured, use the reception time */
+    rcvMsg.timestamp_us = canopen_app_time_us();
     rcvMsgIdent = rcvMsg.ident;
 #else
     static CAN_RxHeaderTypeDef rx_hdr;
@@ -547,8 +667,15 @@ prv_read_can_received_msg(CAN_HandleTypeDef* hcan, uint32_t fifo, uint32_t fifo_
     /* Setup identifier (with RTR) and length */
     rcvMsg.ident = rx_hdr.StdId | (rx_hdr.RTR == CAN_RTR_REMOTE ? FLAG_RTR : 0x00);
     rcvMsg.dlc = rx_hdr.DLC;
+    rcvMsg.timestamp_us = prv_can_time_to_us(CANModule_local, (uint16_t)rx_hdr.Timestamp);
     rcvMsgIdent = rcvMsg.ident;
 #endif
+    CANModule_local->lastRx_us = rcvMsg.timestamp_us;
+    CANModule_local->busBits += CAN_FRAME_BITS((rcvMsg.dlc > 8U) ? 8U : rcvMsg.dlc);
+    CO_capture_frame((uint16_t)rcvMsg.ident, rcvMsg.dlc, rcvMsg.data, rcvMsg.timestamp_us);
+    if (CANModule_local->rxMonitor != NULL) {
+        CANModule_local->rxMonitor(CANModule_local->rxMonitorObject, &rcvMsg);
+    }
 
     /*
      * Hardware filters are not used for the moment
@@ -572,10 +699,75 @@ prv_read_can_received_msg(CAN_HandleTypeDef* hcan, uint32_t fifo, uint32_t fifo_
 
     /* Call specific function, which will process the message */
     if (messageFound && buffer != NULL && buffer->CANrx_callback != NULL) {
+        buffer->timestamp_us = rcvMsg.timestamp_us;
         buffer->CANrx_callback(buffer->object, (void*)&rcvMsg);
     }
 }
 
+/******************************************************************************/
+bool_t
+CO_CANrxTimestamp(CO_CANmodule_t* CANmodule, const void* object, uint32_t* timestamp_us) {
+    if (CANmodule == NULL || object == NULL || timestamp_us == NULL) {
+        return false;
+    }
+    for (uint16_t i = 0U; i < CANmodule->rxSize; i++) {
+        if (CANmodule->rxArray[i].object == object) {
+            *timestamp_us = CANmodule->rxArray[i].timestamp_us;
+            return true;
+        }
+    }
+    return false;
+}
+
+/******************************************************************************/
+bool_t
+CO_CANmodule_setBitRate(CO_CANmodule_t* CANmodule, uint16_t bitRate) {
+#ifdef CO_STM32_FDCAN_Driver
+    (void)CANmodule;
+    (void)bitRate;
+    return false;
+#else
+    CO_bitTiming_t timing;
+
+    if (CANmodule == NULL || !CO_bitTiming_compute(HAL_RCC_GetPCLK1Freq(), bitRate, &timing)) {
+        return false;
+    }
+    CO_bitTiming_apply(((CANopenNodeSTM32*)CANmodule->CANptr)->CANHandle, &timing);
+    prv_update_bit_time(CANmodule);
+
+    /* The frames queued at the previous bit rate are dropped */
+    CO_LOCK_CAN_SEND(CANmodule);
+    for (uint16_t i = 0U; i < CANmodule->txSize; i++) {
+        CANmodule->txArray[i].bufferFull = false;
+    }
+    CANmodule->CANtxCount = 0U;
+    CO_UNLOCK_CAN_SEND(CANmodule);
+    return true;
+#endif
+}
+
+/******************************************************************************/
+void
+CO_CANmodule_abortTx(CO_CANmodule_t* CANmodule) {
+#ifdef CO_STM32_FDCAN_Driver
+    (void)CANmodule;
+#else
+    if (CANmodule == NULL) {
+        return;
+    }
+
+    CO_LOCK_CAN_SEND(CANmodule);
+    (void)HAL_CAN_AbortTxRequest(((CANopenNodeSTM32*)CANmodule->CANptr)->CANHandle,
+                                 CAN_TX_MAILBOX0 | CAN_TX_MAILBOX1 | CAN_TX_MAILBOX2);
+    /* No timestamp nor capture for the aborted frames, a completed one is not recorded either */
+    for (uint8_t i = 0U; i < 3U; i++) {
+        CANmodule->txMailboxBuffer[i] = NULL;
+    }
+    CANmodule->bufferInhibitFlag = false;
+    CO_UNLOCK_CAN_SEND(CANmodule);
+#endif
+}
+
 #ifdef CO_STM32_FDCAN_Driver
 /**
  * \brief           Rx FIFO 0 callback.
@@ -611,6 +803,9 @@ HAL_FDCAN_RxFifo1Callback(FDCAN_HandleTypeDef* hfdcan, uint32_t RxFifo1ITs) {
  */
 void
 HAL_FDCAN_TxBufferCompleteCallback(FDCAN_HandleTypeDef* hfdcan, uint32_t BufferIndexes) {
+    if (CANModule_local->firstCANtxMessage) {
+        CO_profile_bootMark(CO_PROFILE_BOOT_BOOTUP);
+    }
     CANModule_local->firstCANtxMessage = false;            /* First CAN message (bootup) was sent successfully */
     CANModule_local->bufferInhibitFlag = false;            /* Clear flag from previous message */
     if (CANModule_local->CANtxCount > 0U) {                /* Are there any new messages waiting to be send */
@@ -672,7 +867,29 @@ HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef* hcan) {
  */
 void
 CO_CANinterrupt_TX(CO_CANmodule_t* CANmodule, uint32_t MailboxNumber) {
+    uint8_t mailbox = prv_tx_mailbox_index(MailboxNumber);
+
+    /* Transmit timestamp, read before the mailbox is reused */
+    if (CANmodule->txMailboxBuffer[mailbox] != NULL) {
+        uint32_t canTime = HAL_CAN_GetTxTimestamp(((CANopenNodeSTM32*)CANmodule->CANptr)->CANHandle, MailboxNumber);
+        uint32_t timestamp_us = prv_can_time_to_us(CANmodule, (uint16_t)canTime);
+        CANmodule->txMailboxBuffer[mailbox]->timestamp_us = timestamp_us;
+        CANmodule->busBits += CAN_FRAME_BITS(CANmodule->txMailboxBuffer[mailbox]->DLC);
+
+        /* The frame is read back from the mailbox, its buffer may already hold the next one */
+        CAN_TxMailBox_TypeDef* txMailbox =
+            &((CANopenNodeSTM32*)CANmodule->CANptr)->CANHandle->Instance->sTxMailBox[mailbox];
+        uint32_t data[2] = {txMailbox->TDLR, txMailbox->TDHR};
+        uint8_t dlc = (uint8_t)(txMailbox->TDTR & CAN_TDT0R_DLC);
+        CO_capture_frame((uint16_t)((txMailbox->TIR >> CAN_TI0R_STID_Pos) | CO_CAPTURE_TX
+                                    | (((txMailbox->TIR & CAN_TI0R_RTR) != 0U) ? CO_CAPTURE_RTR : 0U)),
+                         (dlc > 8U) ? 8U : dlc, (const uint8_t*)data, timestamp_us);
+        CANmodule->txMailboxBuffer[mailbox] = NULL;
+    }
 
+    if (CANmodule->firstCANtxMessage) {
+        CO_profile_bootMark(CO_PROFILE_BOOT_BOOTUP);
+    }
     CANmodule->firstCANtxMessage = false;            /* First CAN message (bootup) was sent successfully */
     CANmodule->bufferInhibitFlag = false;            /* Clear flag from previous message */
     if (CANmodule->CANtxCount > 0U) {                /* Are there any new messages waiting to be send */
@@ -713,11 +930,11 @@ HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef* hcan) {
 
 void
 HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef* hcan) {
-    CO_CANinterrupt_TX(CANModule_local, CAN_TX_MAILBOX0);
+    CO_CANinterrupt_TX(CANModule_local, CAN_TX_MAILBOX1);
 }
 
 void
 HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef* hcan) {
-    CO_CANinterrupt_TX(CANModule_local, CAN_TX_MAILBOX0);
+    CO_CANinterrupt_TX(CANModule_local, CAN_TX_MAILBOX2);
 }
 #endif
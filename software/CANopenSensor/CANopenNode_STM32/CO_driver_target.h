@@ -35,6 +35,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "CO_profile_STM32.h"
+
 // Determining the CANOpen Driver
 
 #if defined(FDCAN) || defined(FDCAN1) || defined(FDCAN2) || defined(FDCAN3)
@@ -58,6 +60,54 @@ extern "C" {
 /* Stack configuration override default values.
  * For more information see file CO_config.h. */
 
+/* NMT, heartbeat consumer, emergency, SDO server and LSS slave signal the reception of a frame from the CAN interrupt,
+ * canopen_app_process() then runs CO_process() without waiting for the next millisecond. */
+#ifndef CO_CONFIG_GLOBAL_FLAG_CALLBACK_PRE
+#define CO_CONFIG_GLOBAL_FLAG_CALLBACK_PRE CO_CONFIG_FLAG_CALLBACK_PRE
+#endif
+
+/* SDO block upload, used to bulk read the event journal (0x2120). Block transfer requires CRC16 and a 900 bytes buffer. */
+#ifndef CO_CONFIG_SDO_SRV
+#define CO_CONFIG_SDO_SRV                                                                                              \
+    (CO_CONFIG_SDO_SRV_SEGMENTED | CO_CONFIG_SDO_SRV_BLOCK | CO_CONFIG_GLOBAL_FLAG_CALLBACK_PRE                         \
+     | CO_CONFIG_GLOBAL_FLAG_TIMERNEXT | CO_CONFIG_GLOBAL_FLAG_OD_DYNAMIC)
+#endif
+#ifndef CO_CONFIG_SDO_SRV_BUFFER_SIZE
+#define CO_CONFIG_SDO_SRV_BUFFER_SIZE 900
+#endif
+#ifndef CO_CONFIG_CRC16
+#define CO_CONFIG_CRC16 CO_CONFIG_CRC16_ENABLE
+#endif
+
+/* CiA 309-3 ASCII gateway, on the shell UART with the "gateway" command (canopen_app_gatewayEnable()). It uses the SDO
+ * client, the NMT master and the LSS master to reach the other nodes of the bus. */
+#ifndef CO_CONFIG_GTW
+#define CO_CONFIG_GTW                                                                                                  \
+    (CO_CONFIG_GTW_ASCII | CO_CONFIG_GTW_ASCII_SDO | CO_CONFIG_GTW_ASCII_NMT | CO_CONFIG_GTW_ASCII_LSS                  \
+     | CO_CONFIG_GTW_ASCII_ERROR_DESC | CO_CONFIG_GTW_ASCII_PRINT_HELP)
+#endif
+#ifndef CO_CONFIG_GTW_BLOCK_DL_LOOP
+#define CO_CONFIG_GTW_BLOCK_DL_LOOP 1
+#endif
+/* The commands wait in the shell stdin ring while this buffer is full */
+#ifndef CO_CONFIG_GTWA_COMM_BUF_SIZE
+#define CO_CONFIG_GTWA_COMM_BUF_SIZE 200
+#endif
+#ifndef CO_CONFIG_FIFO
+#define CO_CONFIG_FIFO (CO_CONFIG_FIFO_ENABLE | CO_CONFIG_FIFO_ASCII_COMMANDS | CO_CONFIG_FIFO_ASCII_DATATYPES)
+#endif
+#ifndef CO_CONFIG_SDO_CLI
+#define CO_CONFIG_SDO_CLI                                                                                              \
+    (CO_CONFIG_SDO_CLI_ENABLE | CO_CONFIG_SDO_CLI_SEGMENTED | CO_CONFIG_SDO_CLI_LOCAL                                  \
+     | CO_CONFIG_GLOBAL_FLAG_CALLBACK_PRE | CO_CONFIG_GLOBAL_FLAG_TIMERNEXT | CO_CONFIG_GLOBAL_FLAG_OD_DYNAMIC)
+#endif
+#ifndef CO_CONFIG_NMT
+#define CO_CONFIG_NMT (CO_CONFIG_NMT_MASTER | CO_CONFIG_GLOBAL_FLAG_CALLBACK_PRE | CO_CONFIG_GLOBAL_FLAG_TIMERNEXT)
+#endif
+#ifndef CO_CONFIG_LSS
+#define CO_CONFIG_LSS (CO_CONFIG_LSS_SLAVE | CO_CONFIG_LSS_MASTER | CO_CONFIG_GLOBAL_FLAG_CALLBACK_PRE)
+#endif
+
 /* Basic definitions. If big endian, CO_SWAP_xx macros must swap bytes. */
 #define CO_LITTLE_ENDIAN
 #define CO_SWAP_16(x) x
@@ -77,15 +127,17 @@ typedef double float64_t;
  * This is platform specific one
  */
 typedef struct {
-    uint32_t ident;  /*!< Standard identifier */
-    uint8_t dlc;     /*!< Data length */
-    uint8_t data[8]; /*!< Received data */
+    uint32_t ident;        /*!< Standard identifier */
+    uint8_t dlc;           /*!< Data length */
+    uint8_t data[8];       /*!< Received data */
+    uint32_t timestamp_us; /*!< Start of frame, captured by the CAN peripheral (see CO_CANrxTimestamp()) */
 } CO_CANrxMsg_t;
 
 /* Access to received CAN message */
-#define CO_CANrxMsg_readIdent(msg) ((uint16_t)(((CO_CANrxMsg_t*)(msg)))->ident)
-#define CO_CANrxMsg_readDLC(msg)   ((uint8_t)(((CO_CANrxMsg_t*)(msg)))->dlc)
-#define CO_CANrxMsg_readData(msg)  ((uint8_t*)(((CO_CANrxMsg_t*)(msg)))->data)
+#define CO_CANrxMsg_readIdent(msg)     ((uint16_t)(((CO_CANrxMsg_t*)(msg)))->ident)
+#define CO_CANrxMsg_readDLC(msg)       ((uint8_t)(((CO_CANrxMsg_t*)(msg)))->dlc)
+#define CO_CANrxMsg_readData(msg)      ((uint8_t*)(((CO_CANrxMsg_t*)(msg)))->data)
+#define CO_CANrxMsg_readTimestamp(msg) ((uint32_t)(((CO_CANrxMsg_t*)(msg)))->timestamp_us)
 
 /* Received message object */
 typedef struct {
@@ -93,6 +145,7 @@ typedef struct {
     uint16_t mask;
     void* object;
     void (*CANrx_callback)(void* object, void* message);
+    uint32_t timestamp_us; /* Start of the last frame received by this buffer */
 } CO_CANrx_t;
 
 /* Transmit message object */
@@ -102,6 +155,7 @@ typedef struct {
     uint8_t data[8];
     volatile bool_t bufferFull;
     volatile bool_t syncFlag;
+    uint32_t timestamp_us; /* Start of the last frame transmitted from this buffer */
 } CO_CANtx_t;
 
 /* CAN module object */
@@ -120,9 +174,21 @@ typedef struct {
     uint32_t errOld;
 
     /* STM32 specific features */
-    uint32_t primask_send; /* Primask register for interrupts for send operation */
-    uint32_t primask_emcy; /* Primask register for interrupts for emergency operation */
-    uint32_t primask_od;   /* Primask register for interrupts for send operation */
+    uint32_t primask_send; /* Interrupt mask (PRIMASK or BASEPRI) saved by the send operation lock */
+    uint32_t primask_emcy; /* Interrupt mask (PRIMASK or BASEPRI) saved by the emergency operation lock */
+    uint32_t primask_od;   /* Interrupt mask (PRIMASK or BASEPRI) saved by the OD lock */
+
+    /* Frame timestamps, from the CAN timer captures (bxCAN time triggered communication mode) */
+    uint32_t bitTime_ns;            /* Nominal bit time, period of the CAN timer */
+    uint64_t timeRefBits;           /* Unwrapped CAN timer of the reference capture */
+    uint32_t timeRef_us;            /* Timebase value when the reference capture was read */
+    uint16_t timeRefCan;            /* CAN timer of the reference capture */
+    bool_t timeRefValid;            /* A reference capture exists */
+    CO_CANtx_t* txMailboxBuffer[3]; /* Buffer transmitted from each TX mailbox */
+    volatile uint32_t lastRx_us;    /* Start of the last frame received, whatever its identifier */
+    volatile uint32_t busBits;      /* Bits of the frames received and transmitted, for the bus load */
+    void (*volatile rxMonitor)(void* object, const CO_CANrxMsg_t* msg); /* See CO_CANmodule_setRxMonitor() */
+    void* rxMonitorObject;
 
 } CO_CANmodule_t;
 
@@ -136,30 +202,106 @@ typedef struct {
     void* addrNV;
 } CO_storage_entry_t;
 
+/*
+ * Critical sections
+ *
+ * With CO_CONFIG_STM32_LOCK_BASEPRI set, the CANopen critical sections only mask the interrupts whose priority value
+ * is CO_CONFIG_STM32_LOCK_PRIORITY or above (BASEPRI), otherwise all interrupts are masked (PRIMASK).
+ * NVIC priority plan (NVIC_PRIORITYGROUP_4, lower value is more urgent):
+ *   0 - Sensor inputs (EXTI, TIM2 vibration window), never delayed by the CANopen stack
+ *   1 - Shell UART, buzzer timer: do not access CANopen objects
+ *   2 - CAN TX/RX0/RX1/SCE and CANopen timer: CO_CONFIG_STM32_LOCK_PRIORITY
+ * Every interrupt which calls into the CANopen stack must have a priority value >= CO_CONFIG_STM32_LOCK_PRIORITY.
+ */
+#ifndef CO_CONFIG_STM32_LOCK_BASEPRI
+#define CO_CONFIG_STM32_LOCK_BASEPRI 1
+#endif
+#ifndef CO_CONFIG_STM32_LOCK_PRIORITY
+#define CO_CONFIG_STM32_LOCK_PRIORITY 2U
+#endif
+
+#if CO_CONFIG_STM32_LOCK_BASEPRI
+#define CO_LOCK_GET_MASK()         __get_BASEPRI()
+#define CO_LOCK_SET_MASK()         __set_BASEPRI_MAX(CO_CONFIG_STM32_LOCK_PRIORITY << (8U - __NVIC_PRIO_BITS))
+#define CO_LOCK_RESTORE_MASK(mask) __set_BASEPRI(mask)
+#else
+#define CO_LOCK_GET_MASK()         __get_PRIMASK()
+#define CO_LOCK_SET_MASK()         __disable_irq()
+#define CO_LOCK_RESTORE_MASK(mask) __set_PRIMASK(mask)
+#endif
+
 /* (un)lock critical section in CO_CANsend() */
-// Why disabling the whole Interrupt
 #define CO_LOCK_CAN_SEND(CAN_MODULE)                                                                                   \
     do {                                                                                                               \
-        (CAN_MODULE)->primask_send = __get_PRIMASK();                                                                  \
-        __disable_irq();                                                                                               \
+        (CAN_MODULE)->primask_send = CO_LOCK_GET_MASK();                                                               \
+        CO_LOCK_SET_MASK();                                                                                            \
+        CO_PROFILE_LOCK_ENTER((CAN_MODULE)->primask_send);                                                             \
+    } while (0)
+#define CO_UNLOCK_CAN_SEND(CAN_MODULE)                                                                                 \
+    do {                                                                                                               \
+        CO_PROFILE_LOCK_EXIT((CAN_MODULE)->primask_send);                                                              \
+        CO_LOCK_RESTORE_MASK((CAN_MODULE)->primask_send);                                                              \
     } while (0)
-#define CO_UNLOCK_CAN_SEND(CAN_MODULE) __set_PRIMASK((CAN_MODULE)->primask_send)
 
 /* (un)lock critical section in CO_errorReport() or CO_errorReset() */
 #define CO_LOCK_EMCY(CAN_MODULE)                                                                                       \
     do {                                                                                                               \
-        (CAN_MODULE)->primask_emcy = __get_PRIMASK();                                                                  \
-        __disable_irq();                                                                                               \
+        (CAN_MODULE)->primask_emcy = CO_LOCK_GET_MASK();                                                               \
+        CO_LOCK_SET_MASK();                                                                                            \
+        CO_PROFILE_LOCK_ENTER((CAN_MODULE)->primask_emcy);                                                             \
+    } while (0)
+#define CO_UNLOCK_EMCY(CAN_MODULE)                                                                                     \
+    do {                                                                                                               \
+        CO_PROFILE_LOCK_EXIT((CAN_MODULE)->primask_emcy);                                                              \
+        CO_LOCK_RESTORE_MASK((CAN_MODULE)->primask_emcy);                                                              \
     } while (0)
-#define CO_UNLOCK_EMCY(CAN_MODULE) __set_PRIMASK((CAN_MODULE)->primask_emcy)
 
 /* (un)lock critical section when accessing Object Dictionary */
 #define CO_LOCK_OD(CAN_MODULE)                                                                                         \
     do {                                                                                                               \
-        (CAN_MODULE)->primask_od = __get_PRIMASK();                                                                    \
-        __disable_irq();                                                                                               \
+        (CAN_MODULE)->primask_od = CO_LOCK_GET_MASK();                                                                 \
+        CO_LOCK_SET_MASK();                                                                                            \
+        CO_PROFILE_LOCK_ENTER((CAN_MODULE)->primask_od);                                                               \
     } while (0)
-#define CO_UNLOCK_OD(CAN_MODULE) __set_PRIMASK((CAN_MODULE)->primask_od)
+#define CO_UNLOCK_OD(CAN_MODULE)                                                                                       \
+    do {                                                                                                               \
+        CO_PROFILE_LOCK_EXIT((CAN_MODULE)->primask_od);                                                                \
+        CO_LOCK_RESTORE_MASK((CAN_MODULE)->primask_od);                                                                \
+    } while (0)
+
+/*
+ * Timestamp, in microseconds of the canopen_app_time_us() timebase, of the last frame received for 'object'.
+ * 'object' is the one given to CO_CANrxBufferInit(), for example CO->SYNC, CO->TIME or &CO->RPDO[i].
+ * Differences between timestamps are accurate to the CAN bit time, the offset to the timebase is the latency of the
+ * first received frame. Returns false if no buffer is registered for 'object'.
+ */
+bool_t CO_CANrxTimestamp(CO_CANmodule_t* CANmodule, const void* object, uint32_t* timestamp_us);
+
+/*
+ * Program the bit timing computed for bitRate (kbit/s, see CO_bitTiming_compute()) and drop the frames waiting for
+ * transmission. The CAN peripheral must be in configuration mode (CO_CANsetConfigurationMode()). Returns false if
+ * the bit rate can not be obtained from the CAN clock.
+ */
+bool_t CO_CANmodule_setBitRate(CO_CANmodule_t* CANmodule, uint16_t bitRate);
+
+/*
+ * Abort the frames waiting in the TX mailboxes. HAL_CAN_Stop() keeps them, they would be sent by the next
+ * CO_CANsetNormalMode(). To be called before CO_CANsetConfigurationMode(), a frame already on the bus is completed.
+ */
+void CO_CANmodule_abortTx(CO_CANmodule_t* CANmodule);
+
+/*
+ * Register a function called from the CAN receive interrupt with every received frame, whatever its identifier, before
+ * the frame is given to its buffer. NULL removes it. CO_CANmodule_init() removes it as well.
+ */
+void CO_CANmodule_setRxMonitor(CO_CANmodule_t* CANmodule, void* object,
+                               void (*rxMonitor)(void* object, const CO_CANrxMsg_t* msg));
+
+/*
+ * Send a frame from a buffer which is not part of txArray (gateway) if a TX mailbox is free. The frame is never
+ * queued, returns false if it was not sent.
+ */
+bool_t CO_CANsendNow(CO_CANmodule_t* CANmodule, CO_CANtx_t* buffer);
 
 /* Synchronization between CAN receive and message processing threads. */
 #define CO_MemoryBarrier()
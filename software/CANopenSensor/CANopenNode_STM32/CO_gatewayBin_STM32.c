@@ -0,0 +1,468 @@
+/*
+ * Binary gateway for the STM32 CANopenNode port: raw CAN frames and batched SDO transfers over a byte stream.
+ *
+ * @file        CO_gatewayBin_STM32.c
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CO_gatewayBin_STM32.h"
+#include "301/crc16-ccitt.h"
+#include "main.h"
+
+#include <string.h>
+
+#if (CO_CONFIG_SDO_CLI) & CO_CONFIG_SDO_CLI_ENABLE
+
+#define SDO_SLOT_MASK (CO_GWB_SDO_SLOTS - 1U)
+#define MON_MASK      (CO_GWB_MONITOR_SIZE - 1U)
+#define SDO_HEAD_LEN  6U /* tag, node-id, index, sub-index, size */
+#define RESULT_LEN    6U /* tag, abort code, size */
+#define FRAME_LEN     7U /* timestamp, identifier, dlc */
+
+_Static_assert((CO_GWB_SDO_SLOTS & SDO_SLOT_MASK) == 0U, "CO_GWB_SDO_SLOTS must be a power of 2");
+_Static_assert((CO_GWB_MONITOR_SIZE & MON_MASK) == 0U, "CO_GWB_MONITOR_SIZE must be a power of 2");
+_Static_assert(2U + RESULT_LEN + CO_GWB_SDO_DATA_MAX <= CO_GWB_FRAME_MAX, "A result must fit in a frame");
+
+static void
+prv_reset_input(CO_GWB_t* gwb) {
+    gwb->rxLen = 0U;
+    gwb->rxCode = 0U;
+    gwb->rxBlock = 0U;
+    gwb->rxError = false;
+    gwb->rxReady = false;
+}
+
+static void
+prv_nack(CO_GWB_t* gwb, uint8_t type, uint8_t reason) {
+    gwb->replyType = CO_GWB_NACK;
+    gwb->replyArg[0] = type;
+    gwb->replyArg[1] = reason;
+    gwb->rejected++;
+}
+
+static uint8_t
+prv_credits(const CO_GWB_t* gwb) {
+    return (uint8_t)(CO_GWB_SDO_SLOTS - (uint8_t)(gwb->reqHead - gwb->reqTail));
+}
+
+/* Checks the SDO requests of the input frame, returns their number or 0 if the frame is malformed */
+static uint8_t
+prv_count_requests(const uint8_t* buf, uint16_t len) {
+    uint16_t pos = 0U;
+    uint8_t count = 0U;
+
+    while (pos < len) {
+        if ((uint16_t)(len - pos) < SDO_HEAD_LEN) {
+            return 0U;
+        }
+        uint8_t size = buf[pos + 5U];
+        if (size > CO_GWB_SDO_DATA_MAX || (len - pos - SDO_HEAD_LEN) < size || count == UINT8_MAX) {
+            return 0U;
+        }
+        pos += SDO_HEAD_LEN + size;
+        count++;
+    }
+    return count;
+}
+
+/* Runs the complete input frame, returns false if it must wait (reply or SDO slots in use) */
+static bool_t
+prv_execute(CO_GWB_t* gwb) {
+    uint8_t type = gwb->rxBuf[0];
+    const uint8_t* data = &gwb->rxBuf[1];
+    uint16_t len = gwb->rxLen - 1U;
+
+    /* Every frame may need a reply, there is room for one */
+    if (gwb->replyType != 0U) {
+        return false;
+    }
+
+    switch (type) {
+        case CO_GWB_CAN_SEND: {
+            if (len < 3U || data[2] > 8U || len != (3U + data[2])) {
+                prv_nack(gwb, type, CO_GWB_NACK_FRAME);
+                break;
+            }
+            gwb->tx.ident = CO_getUint16(&data[0]);
+            gwb->tx.DLC = data[2];
+            memcpy(gwb->tx.data, &data[3], data[2]);
+            if (gwb->CANmodule == NULL || !CO_CANsendNow(gwb->CANmodule, &gwb->tx)) {
+                prv_nack(gwb, type, CO_GWB_NACK_BUSY);
+            }
+            break;
+        }
+
+        case CO_GWB_MONITOR:
+            if (len != 1U) {
+                prv_nack(gwb, type, CO_GWB_NACK_FRAME);
+                break;
+            }
+            if (data[0] != 0U && !gwb->monEnable) {
+                /* Only the frames received from now on */
+                gwb->monTail = gwb->monHead;
+            }
+            gwb->monEnable = data[0] != 0U;
+            break;
+
+        case CO_GWB_SDO: {
+            uint8_t count = prv_count_requests(data, len);
+            if (count == 0U || count > CO_GWB_SDO_SLOTS) {
+                prv_nack(gwb, type, CO_GWB_NACK_FRAME);
+                break;
+            }
+            if (count > prv_credits(gwb)) {
+                /* The host went beyond its credits, the frame waits for the results to be sent */
+                return false;
+            }
+            for (uint16_t pos = 0U; pos < len;) {
+                CO_GWB_request_t* req = &gwb->req[gwb->reqHead & SDO_SLOT_MASK];
+                req->tag = data[pos];
+                req->node = data[pos + 1U];
+                req->index = CO_getUint16(&data[pos + 2U]);
+                req->subIndex = data[pos + 4U];
+                req->size = data[pos + 5U];
+                req->download = req->size != 0U;
+                req->done = 0U;
+                req->abortCode = CO_SDO_AB_NONE;
+                memcpy(req->data, &data[pos + SDO_HEAD_LEN], req->size);
+                pos += SDO_HEAD_LEN + req->size;
+                gwb->reqHead++;
+            }
+            break;
+        }
+
+        case CO_GWB_STATUS:
+        case CO_GWB_CLOSE:
+            if (len != 0U) {
+                prv_nack(gwb, type, CO_GWB_NACK_FRAME);
+                break;
+            }
+            if (type == CO_GWB_STATUS) {
+                gwb->replyType = CO_GWB_STATUS;
+            } else {
+                /* The status is sent after the last results and frames */
+                gwb->monEnable = false;
+                gwb->closeRequest = true;
+            }
+            break;
+
+        default:
+            prv_nack(gwb, type, CO_GWB_NACK_TYPE);
+            break;
+    }
+
+    prv_reset_input(gwb);
+    return true;
+}
+
+static void
+prv_append(CO_GWB_t* gwb, uint8_t c) {
+    if (gwb->rxLen >= sizeof(gwb->rxBuf)) {
+        gwb->rxError = true;
+    } else {
+        gwb->rxBuf[gwb->rxLen++] = c;
+    }
+}
+
+/* End of the current request, abortCode is CO_SDO_AB_NONE on success */
+static void
+prv_sdo_end(CO_GWB_t* gwb, CO_GWB_request_t* req, CO_SDO_abortCode_t abortCode) {
+    req->abortCode = (uint32_t)abortCode;
+    if (req->download || abortCode != CO_SDO_AB_NONE) {
+        req->size = 0U;
+    }
+    gwb->sdoActive = false;
+    gwb->reqRun++;
+}
+
+/* Runs the waiting requests one after the other, returns while a response is awaited */
+static void
+prv_process_sdo(CO_GWB_t* gwb, uint32_t timeDifference_us, uint32_t* timerNext_us) {
+    while (gwb->reqRun != gwb->reqHead) {
+        CO_GWB_request_t* req = &gwb->req[gwb->reqRun & SDO_SLOT_MASK];
+        CO_SDO_abortCode_t abortCode = CO_SDO_AB_NONE;
+        CO_SDO_return_t ret;
+
+        if (!gwb->sdoActive) {
+            if (gwb->SDO_C == NULL) {
+                prv_sdo_end(gwb, req, CO_SDO_AB_DATA_DEV_STATE);
+                continue;
+            }
+            if (req->node < 1U || req->node > 127U) {
+                prv_sdo_end(gwb, req, CO_SDO_AB_GENERAL);
+                continue;
+            }
+            ret = CO_SDOclient_setup(gwb->SDO_C, CO_CAN_ID_SDO_CLI + req->node, CO_CAN_ID_SDO_SRV + req->node,
+                                     req->node);
+            if (ret == CO_SDO_RT_ok_communicationEnd) {
+                ret = req->download ? CO_SDOclientDownloadInitiate(gwb->SDO_C, req->index, req->subIndex, req->size,
+                                                                   CO_GWB_SDO_TIMEOUT, false)
+                                    : CO_SDOclientUploadInitiate(gwb->SDO_C, req->index, req->subIndex,
+                                                                 CO_GWB_SDO_TIMEOUT, false);
+            }
+            if (ret != CO_SDO_RT_ok_communicationEnd) {
+                prv_sdo_end(gwb, req, CO_SDO_AB_GENERAL);
+                continue;
+            }
+            gwb->sdoActive = true;
+            timeDifference_us = 0U;
+        }
+
+        if (req->download) {
+            if (req->done < req->size) {
+                req->done += CO_SDOclientDownloadBufWrite(gwb->SDO_C, &req->data[req->done], req->size - req->done);
+            }
+            ret = CO_SDOclientDownload(gwb->SDO_C, timeDifference_us, false, req->done < req->size, &abortCode, NULL,
+                                       timerNext_us);
+        } else {
+            ret = CO_SDOclientUpload(gwb->SDO_C, timeDifference_us, false, &abortCode, NULL, NULL, timerNext_us);
+            if (ret == CO_SDO_RT_uploadDataBufferFull || ret == CO_SDO_RT_ok_communicationEnd) {
+                req->size += CO_SDOclientUploadBufRead(gwb->SDO_C, &req->data[req->size],
+                                                       CO_GWB_SDO_DATA_MAX - req->size);
+                if (CO_fifo_getOccupied(&gwb->SDO_C->bufFifo) != 0U) {
+                    abortCode = CO_SDO_AB_OUT_OF_MEM;
+                    CO_SDOclientUpload(gwb->SDO_C, 0, true, &abortCode, NULL, NULL, NULL);
+                    ret = CO_SDO_RT_endedWithClientAbort;
+                }
+            }
+        }
+
+        if (ret < 0) {
+            prv_sdo_end(gwb, req, abortCode);
+        } else if (ret == CO_SDO_RT_ok_communicationEnd) {
+            prv_sdo_end(gwb, req, CO_SDO_AB_NONE);
+        } else {
+            return;
+        }
+    }
+}
+
+/* COBS encoding of len bytes, followed by the delimiter. Returns the encoded length. */
+static uint16_t
+prv_cobs_encode(const uint8_t* src, uint16_t len, uint8_t* dst) {
+    uint16_t code = 0U;
+    uint16_t out = 1U;
+    uint8_t run = 1U;
+
+    for (uint16_t i = 0U; i < len; i++) {
+        if (src[i] != 0U) {
+            dst[out++] = src[i];
+            run++;
+        }
+        if (src[i] == 0U || run == 0xFFU) {
+            dst[code] = run;
+            code = out++;
+            run = 1U;
+        }
+    }
+    dst[code] = run;
+    dst[out++] = 0U;
+    return out;
+}
+
+/* Builds the next output frame: reply, then results, then received frames. Returns false if there is none. */
+static bool_t
+prv_build(CO_GWB_t* gwb) {
+    uint8_t frame[CO_GWB_FRAME_MAX + 2U];
+    uint16_t len = 2U;
+
+    if (gwb->closeRequest && gwb->replyType == 0U && gwb->reqTail == gwb->reqHead && gwb->monTail == gwb->monHead) {
+        /* Nothing else to send, the status ends the session */
+        gwb->replyType = CO_GWB_STATUS;
+        gwb->closeRequest = false;
+        gwb->closing = true;
+    }
+
+    if (gwb->replyType != 0U) {
+        frame[0] = gwb->replyType;
+        if (gwb->replyType == CO_GWB_STATUS) {
+            CO_setUint16(&frame[2], gwb->monLost);
+            CO_setUint16(&frame[4], gwb->rejected);
+            len = 6U;
+        } else {
+            frame[2] = gwb->replyArg[0];
+            frame[3] = gwb->replyArg[1];
+            len = 4U;
+        }
+        gwb->replyType = 0U;
+    } else if (gwb->reqTail != gwb->reqRun) {
+        frame[0] = CO_GWB_RESULTS;
+        while (gwb->reqTail != gwb->reqRun) {
+            const CO_GWB_request_t* req = &gwb->req[gwb->reqTail & SDO_SLOT_MASK];
+            if ((len + RESULT_LEN + req->size) > CO_GWB_FRAME_MAX) {
+                break;
+            }
+            frame[len] = req->tag;
+            CO_setUint32(&frame[len + 1U], req->abortCode);
+            frame[len + 5U] = req->size;
+            memcpy(&frame[len + RESULT_LEN], req->data, req->size);
+            len += RESULT_LEN + req->size;
+            gwb->reqTail++;
+        }
+    } else if (gwb->monTail != gwb->monHead) {
+        frame[0] = CO_GWB_FRAMES;
+        while (gwb->monTail != gwb->monHead) {
+            const CO_CANrxMsg_t* msg = &gwb->mon[gwb->monTail & MON_MASK];
+            uint8_t dlc = (msg->dlc > 8U) ? 8U : msg->dlc;
+            if ((len + FRAME_LEN + dlc) > CO_GWB_FRAME_MAX) {
+                break;
+            }
+            CO_setUint32(&frame[len], msg->timestamp_us);
+            CO_setUint16(&frame[len + 4U], (uint16_t)msg->ident);
+            frame[len + 6U] = dlc;
+            memcpy(&frame[len + FRAME_LEN], msg->data, dlc);
+            len += FRAME_LEN + dlc;
+            /* The slot is given back to the interrupt once read */
+            __DMB();
+            gwb->monTail++;
+        }
+    } else {
+        return false;
+    }
+
+    frame[1] = prv_credits(gwb);
+    len += CO_setUint16(&frame[len], crc16_ccitt(frame, len, 0U));
+    gwb->txLen = prv_cobs_encode(frame, len, gwb->txBuf);
+    gwb->txSent = 0U;
+    return true;
+}
+
+void
+CO_GWB_init(CO_GWB_t* gwb, size_t (*writeCallback)(void* object, const uint8_t* buf, size_t count),
+            void (*closeCallback)(void* object), void* object) {
+    gwb->monEnable = false;
+    gwb->writeCallback = writeCallback;
+    gwb->closeCallback = closeCallback;
+    gwb->writeObject = object;
+    gwb->closeRequest = false;
+    gwb->closing = false;
+    prv_reset_input(gwb);
+    gwb->txLen = 0U;
+    gwb->txSent = 0U;
+    gwb->replyType = 0U;
+    gwb->reqHead = 0U;
+    gwb->reqRun = 0U;
+    gwb->reqTail = 0U;
+    gwb->sdoActive = false;
+    gwb->monTail = gwb->monHead;
+    gwb->monLost = 0U;
+    gwb->rejected = 0U;
+}
+
+void
+CO_GWB_initCANopen(CO_GWB_t* gwb, CO_CANmodule_t* CANmodule, CO_SDOclient_t* SDO_C) {
+    gwb->CANmodule = CANmodule;
+    gwb->SDO_C = SDO_C;
+    if (gwb->sdoActive) {
+        /* The transfer was dropped with the previous objects */
+        prv_sdo_end(gwb, &gwb->req[gwb->reqRun & SDO_SLOT_MASK], CO_SDO_AB_DATA_DEV_STATE);
+    }
+}
+
+size_t
+CO_GWB_write(CO_GWB_t* gwb, const uint8_t* buf, size_t count) {
+    size_t i = 0U;
+
+    if (gwb->rxReady && !prv_execute(gwb)) {
+        return 0U;
+    }
+
+    while (i < count) {
+        uint8_t c = buf[i++];
+
+        if (c == 0U) {
+            /* Delimiter, consecutive ones are ignored */
+            if (gwb->rxLen == 0U && gwb->rxCode == 0U && !gwb->rxError) {
+                continue;
+            }
+            if (gwb->rxError || gwb->rxBlock != 0U || gwb->rxLen < 3U
+                || crc16_ccitt(gwb->rxBuf, gwb->rxLen - 2U, 0U) != CO_getUint16(&gwb->rxBuf[gwb->rxLen - 2U])) {
+                if (gwb->replyType == 0U) {
+                    prv_nack(gwb, 0U, CO_GWB_NACK_FRAME);
+                } else {
+                    gwb->rejected++;
+                }
+                prv_reset_input(gwb);
+                continue;
+            }
+            gwb->rxLen -= 2U;
+            gwb->rxReady = true;
+            if (!prv_execute(gwb)) {
+                return i;
+            }
+        } else if (gwb->rxError) {
+            continue;
+        } else if (gwb->rxBlock == 0U) {
+            /* Code byte, the previous block ended with a zero unless it was a full one */
+            if (gwb->rxCode != 0U && gwb->rxCode != 0xFFU) {
+                prv_append(gwb, 0U);
+            }
+            gwb->rxCode = c;
+            gwb->rxBlock = c - 1U;
+        } else {
+            prv_append(gwb, c);
+            gwb->rxBlock--;
+        }
+    }
+    return i;
+}
+
+void
+CO_GWB_process(CO_GWB_t* gwb, uint32_t timeDifference_us, uint32_t* timerNext_us) {
+    /* The input frame held for room, when no other byte comes to retry it */
+    if (gwb->rxReady) {
+        (void)prv_execute(gwb);
+    }
+
+    prv_process_sdo(gwb, timeDifference_us, timerNext_us);
+
+    for (;;) {
+        if (gwb->txSent < gwb->txLen) {
+            gwb->txSent += gwb->writeCallback(gwb->writeObject, &gwb->txBuf[gwb->txSent], gwb->txLen - gwb->txSent);
+            if (gwb->txSent < gwb->txLen) {
+                return;
+            }
+        }
+        if (!prv_build(gwb)) {
+            break;
+        }
+    }
+
+    if (gwb->closing) {
+        /* The last status is sent, what follows is for the shell */
+        gwb->closing = false;
+        if (gwb->closeCallback != NULL) {
+            gwb->closeCallback(gwb->writeObject);
+        }
+    }
+}
+
+void
+CO_GWB_rxMonitor(void* object, const CO_CANrxMsg_t* msg) {
+    CO_GWB_t* gwb = (CO_GWB_t*)object;
+    uint16_t head = gwb->monHead;
+
+    if (!gwb->monEnable) {
+        return;
+    }
+    if ((uint16_t)(head - gwb->monTail) >= CO_GWB_MONITOR_SIZE) {
+        gwb->monLost++;
+        return;
+    }
+    gwb->mon[head & MON_MASK] = *msg;
+    __DMB();
+    gwb->monHead = head + 1U;
+}
+
+#endif /* (CO_CONFIG_SDO_CLI) & CO_CONFIG_SDO_CLI_ENABLE */
@@ -0,0 +1,156 @@
+/*
+ * Binary gateway for the STM32 CANopenNode port: raw CAN frames and batched SDO transfers over a byte stream.
+ *
+ * @file        CO_gatewayBin_STM32.h
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CO_GATEWAYBIN_STM32_H
+#define CO_GATEWAYBIN_STM32_H
+
+#include "301/CO_driver.h"
+#include "301/CO_SDOclient.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Frames in both directions: COBS encoded, followed by a 0x00 delimiter. Decoded, a frame is a type byte, the payload
+ * and the crc16_ccitt (initial value 0) of the type and the payload. Multi-byte values are little endian. A CAN
+ * identifier is 2 bytes, bit 15 is the RTR flag.
+ *
+ * Host to gateway:
+ *      CO_GWB_CAN_SEND     identifier, dlc, data[dlc]; sent if a TX mailbox is free, else CO_GWB_NACK_BUSY
+ *      CO_GWB_MONITOR      1 byte, not 0 to forward the received frames, 0 to stop
+ *      CO_GWB_SDO          one or more requests: tag, node-id, index (2 bytes), sub-index, size, data[size]. A size
+ *                          of 0 is an upload, else a download of data. The tag is chosen by the host, it is given
+ *                          back in the result
+ *      CO_GWB_STATUS       empty, answered with CO_GWB_STATUS
+ *      CO_GWB_CLOSE        empty, the monitor stops, the last results and frames are sent, then CO_GWB_STATUS,
+ *                          then the stream is closed
+ *
+ * Gateway to host, the byte after the type is the number of free SDO request slots (credits):
+ *      CO_GWB_FRAMES       received frames: timestamp_us (4 bytes, see CO_CANrxMsg_t), identifier, dlc, data[dlc]
+ *      CO_GWB_RESULTS      SDO results in request order: tag, abort code (4 bytes), size, data[size]. size is the
+ *                          uploaded size, 0 for a download or an abort
+ *      CO_GWB_STATUS       frames lost by the monitor (2 bytes), frames rejected (2 bytes)
+ *      CO_GWB_NACK         type of the rejected frame (0 if unreadable), reason (CO_GWB_NACK_xxx)
+ *
+ * Flow control: the host keeps no more SDO requests in flight than the last credits received. A frame whose requests
+ * do not fit is held in the input stream until they do, the received bytes then wait in the UART ring. Output frames
+ * are built only when the previous one is fully written, so results wait in their slots while the UART is busy and no
+ * new request is started once all the slots hold results.
+ */
+#define CO_GWB_CAN_SEND  0x01U
+#define CO_GWB_MONITOR   0x02U
+#define CO_GWB_SDO       0x03U
+#define CO_GWB_STATUS    0x04U
+#define CO_GWB_CLOSE     0x05U
+#define CO_GWB_FRAMES    0x81U
+#define CO_GWB_RESULTS   0x83U
+#define CO_GWB_NACK      0x8FU
+
+#define CO_GWB_NACK_FRAME   1U /* Bad COBS encoding, CRC or length */
+#define CO_GWB_NACK_TYPE    2U /* Unknown type */
+#define CO_GWB_NACK_BUSY    3U /* No free TX mailbox or CAN not in normal mode */
+
+#define CO_GWB_RTR          0x8000U
+
+#define CO_GWB_FRAME_MAX    255U /* Decoded frame, without the CRC */
+#define CO_GWB_SDO_SLOTS    8U   /* Power of 2 */
+#define CO_GWB_SDO_DATA_MAX 64U  /* Longer uploads end with CO_SDO_AB_OUT_OF_MEM */
+#define CO_GWB_MONITOR_SIZE 32U  /* Received frames waiting for the host, power of 2 */
+#define CO_GWB_SDO_TIMEOUT  500U /* ms */
+
+/* SDO request, then its result */
+typedef struct {
+    uint8_t tag;
+    uint8_t node;
+    uint16_t index;
+    uint8_t subIndex;
+    bool_t download;
+    uint8_t size;     /* Data to download, or data uploaded */
+    uint8_t done;     /* Data given to the SDO client */
+    uint32_t abortCode;
+    uint8_t data[CO_GWB_SDO_DATA_MAX];
+} CO_GWB_request_t;
+
+typedef struct {
+    CO_CANmodule_t* CANmodule;
+    CO_SDOclient_t* SDO_C;
+    size_t (*writeCallback)(void* object, const uint8_t* buf, size_t count);
+    void* writeObject;
+    void (*closeCallback)(void* object);
+    bool_t closeRequest; /* CO_GWB_CLOSE received, its status is not built yet */
+    bool_t closing;      /* Its status is being written */
+
+    /* Input frame, decoded as the bytes arrive */
+    uint8_t rxBuf[CO_GWB_FRAME_MAX + 2U];
+    uint16_t rxLen;
+    uint8_t rxCode;      /* COBS code of the current block, 0 at the start of a frame */
+    uint8_t rxBlock;     /* Bytes left in the current block */
+    bool_t rxError;      /* Skip to the next delimiter */
+    bool_t rxReady;      /* Complete frame waiting for room */
+
+    /* Output frame, encoded, written from txSent */
+    uint8_t txBuf[CO_GWB_FRAME_MAX + 2U + (CO_GWB_FRAME_MAX + 2U) / 254U + 2U];
+    uint16_t txLen;
+    uint16_t txSent;
+    uint8_t replyType;   /* CO_GWB_STATUS or CO_GWB_NACK to send, 0 if none */
+    uint8_t replyArg[2];
+
+    /* SDO requests, free running indexes: results in [tail, run), running at run, waiting in [run, head) */
+    CO_GWB_request_t req[CO_GWB_SDO_SLOTS];
+    uint8_t reqHead;
+    uint8_t reqRun;
+    uint8_t reqTail;
+    bool_t sdoActive;
+
+    /* Received frames, written by the CAN receive interrupt */
+    CO_CANrxMsg_t mon[CO_GWB_MONITOR_SIZE];
+    volatile uint16_t monHead;
+    uint16_t monTail;
+    volatile bool_t monEnable;
+    volatile uint16_t monLost;
+    uint16_t rejected;
+
+    CO_CANtx_t tx;       /* Frames of CO_GWB_CAN_SEND, not part of the CANmodule txArray */
+} CO_GWB_t;
+
+/* Starts a session: clears the requests and the frames, the responses are given to writeCallback, which returns the
+ * number of bytes it took (the others are given again later). closeCallback is called once CO_GWB_CLOSE is
+ * answered. */
+void CO_GWB_init(CO_GWB_t* gwb, size_t (*writeCallback)(void* object, const uint8_t* buf, size_t count),
+                 void (*closeCallback)(void* object), void* object);
+
+/* Objects of the CANopen stack, to be given again after each communication reset (the requests in progress are
+ * ended with CO_SDO_AB_DATA_DEV_STATE). SDO_C is NULL while the node-id is unconfigured. The monitor must also be
+ * registered again, see CO_CANmodule_setRxMonitor(). */
+void CO_GWB_initCANopen(CO_GWB_t* gwb, CO_CANmodule_t* CANmodule, CO_SDOclient_t* SDO_C);
+
+/* Decodes the input bytes, returns the number of bytes used. Less than count when a frame waits for room. */
+size_t CO_GWB_write(CO_GWB_t* gwb, const uint8_t* buf, size_t count);
+
+/* Runs the SDO transfers and writes the responses, from the same thread as CO_process() */
+void CO_GWB_process(CO_GWB_t* gwb, uint32_t timeDifference_us, uint32_t* timerNext_us);
+
+/* Monitor callback, from the CAN receive interrupt (see CO_CANmodule_setRxMonitor()) */
+void CO_GWB_rxMonitor(void* object, const CO_CANrxMsg_t* msg);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CO_GATEWAYBIN_STM32_H */
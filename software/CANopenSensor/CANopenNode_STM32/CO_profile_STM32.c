@@ -0,0 +1,120 @@
+/*
+ * Interrupt latency profiling for the STM32 CANopenNode port.
+ *
+ * @file        CO_profile_STM32.c
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CO_profile_STM32.h"
+#include "CO_driver_target.h"
+
+#include <stdbool.h>
+
+CO_profile_t CO_profile;
+
+void
+CO_profile_init(void) {
+#if CO_CONFIG_STM32_PROFILE
+    /* The cycle counter is not cleared, it may already time the boot */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    CO_profile_reset();
+}
+
+void
+CO_profile_reset(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t i = 0; i < CO_PROFILE_COUNT; i++) {
+        CO_profile.maxCycles[i] = 0;
+        CO_profile.irq[i] = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
+uint32_t
+CO_profile_worstLatency(IRQn_Type irq) {
+    uint32_t priority = NVIC_GetPriority(irq);
+    uint32_t worst = 0;
+
+    for (uint8_t i = 0; i < CO_PROFILE_COUNT; i++) {
+        uint32_t cycles = CO_profile.maxCycles[i];
+        bool blocking;
+
+        if (i == CO_PROFILE_LOCK) {
+#if CO_CONFIG_STM32_LOCK_BASEPRI
+            /* Critical sections only mask the interrupts up to the CANopen priority */
+            blocking = priority >= CO_CONFIG_STM32_LOCK_PRIORITY;
+#else
+            /* Critical sections mask every interrupt */
+            blocking = true;
+#endif
+        } else if (CO_profile.irq[i] < 0) {
+            /* Recorded from thread mode, can not delay an interrupt */
+            blocking = false;
+        } else {
+            /* An interrupt can only preempt a handler of strictly higher priority value */
+            blocking = NVIC_GetPriority((IRQn_Type)CO_profile.irq[i]) <= priority;
+        }
+
+        if (blocking && (cycles > worst)) {
+            worst = cycles;
+        }
+    }
+    return worst;
+}
+
+uint32_t
+CO_profile_cyclesToUs(uint32_t cycles) {
+    return cycles / (SystemCoreClock / 1000000U);
+}
+
+void
+CO_profile_bootStart(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    CO_profile.bootMarked = 0;
+    CO_profile.bootElapsed_us = 0;
+    CO_profile.bootRemainder = 0;
+    CO_profile.bootTick = HAL_GetTick();
+    CO_profile.bootCycles = DWT->CYCCNT;
+    CO_profile.bootMHz = SystemCoreClock / 1000000U;
+}
+
+void
+CO_profile_bootMark(CO_profile_boot_t phase) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if ((CO_profile.bootMHz != 0U) && ((CO_profile.bootMarked & (1UL << phase)) == 0U)) {
+        uint32_t cycles = DWT->CYCCNT;
+        uint32_t tick = HAL_GetTick();
+
+        if ((tick - CO_profile.bootTick) < CO_PROFILE_BOOT_TICK_MAX) {
+            uint32_t elapsed = cycles - CO_profile.bootCycles + CO_profile.bootRemainder;
+            CO_profile.bootElapsed_us += elapsed / CO_profile.bootMHz;
+            CO_profile.bootRemainder = elapsed % CO_profile.bootMHz;
+        } else {
+            /* The cycle counter may have wrapped */
+            CO_profile.bootElapsed_us += (tick - CO_profile.bootTick) * 1000U;
+            CO_profile.bootRemainder = 0;
+        }
+        CO_profile.bootTime_us[phase] = CO_profile.bootElapsed_us;
+        CO_profile.bootMarked |= 1UL << phase;
+        CO_profile.bootCycles = cycles;
+        CO_profile.bootTick = tick;
+        CO_profile.bootMHz = SystemCoreClock / 1000000U;
+    }
+    __set_PRIMASK(primask);
+}
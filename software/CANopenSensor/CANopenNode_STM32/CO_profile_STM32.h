@@ -0,0 +1,155 @@
+/*
+ * Interrupt latency profiling for the STM32 CANopenNode port.
+ *
+ * @file        CO_profile_STM32.h
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CO_PROFILE_STM32_H
+#define CO_PROFILE_STM32_H
+
+#include "main.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Set to 0 to remove the profiling code from the critical sections and the interrupt handlers */
+#ifndef CO_CONFIG_STM32_PROFILE
+#define CO_CONFIG_STM32_PROFILE 1
+#endif
+
+/*
+ * The DWT cycle counter is used to record the longest duration of every code section that delays other
+ * interrupts: the CANopen critical sections (CO_LOCK_xxx) and the interrupt handlers. The worst case entry
+ * latency of an interrupt is the longest of the sections it can not preempt, see CO_profile_worstLatency().
+ */
+typedef enum {
+    CO_PROFILE_LOCK = 0,   /* CANopen critical sections (CO_LOCK_xxx) */
+    CO_PROFILE_ISR_CAN_TX, /* CAN TX mailbox empty interrupt */
+    CO_PROFILE_ISR_CAN_RX, /* CAN RX FIFO interrupts */
+    CO_PROFILE_ISR_TIMER,  /* CANopen 1ms timer interrupt (canopen_app_interrupt) */
+    CO_PROFILE_ISR_EXTI,   /* Sensor inputs interrupts */
+    CO_PROFILE_ISR_UART,   /* Shell UART and UART TX DMA interrupts */
+    CO_PROFILE_ISR_PATTERN, /* Buzzer and LED pattern timer interrupt */
+    CO_PROFILE_RX_PROCESS, /* From the reception of a NMT/SDO/LSS/... frame to the end of its CO_process() */
+    CO_PROFILE_CAPTURE,    /* Bus capture of one frame, in the CAN interrupts (CO_capture_frame()) */
+    CO_PROFILE_COUNT
+} CO_profile_source_t;
+
+/*
+ * Boot timeline: end of each phase between the entry of main() and the boot-up frame, in microseconds. The cycles
+ * since the previous mark are converted with the core clock of that mark (the MSI until SystemClock_Config()). A
+ * phase which ends more than CO_PROFILE_BOOT_TICK_MAX after the previous one is measured with the HAL tick.
+ */
+typedef enum {
+    CO_PROFILE_BOOT_HAL_INIT = 0,  /* HAL_Init() */
+    CO_PROFILE_BOOT_CLOCK,         /* SystemClock_Config() */
+    CO_PROFILE_BOOT_PERIPHERALS,   /* MX_xxx_Init() */
+    CO_PROFILE_BOOT_SHELL,         /* cli_init(), and the banner unless it is deferred */
+    CO_PROFILE_BOOT_APP,           /* Journal, sensors and patterns */
+    CO_PROFILE_BOOT_CONFIGURATION, /* Configuration read from the flash */
+    CO_PROFILE_BOOT_CO_NEW,        /* CO_new(), allocation of the CANopen objects */
+    CO_PROFILE_BOOT_CAN_INIT,      /* CO_CANinit() */
+    CO_PROFILE_BOOT_CANOPEN_INIT,  /* CANopen objects initialized, CAN in normal mode */
+    CO_PROFILE_BOOT_BOOTUP,        /* Boot-up frame transmitted */
+    CO_PROFILE_BOOT_BANNER,        /* Shell banner printed, when it is deferred */
+    CO_PROFILE_BOOT_COUNT
+} CO_profile_boot_t;
+
+#define CO_PROFILE_BOOT_TICK_MAX 50000U /* ms, the cycle counter wraps after 53 s at 80 MHz */
+
+typedef struct {
+    volatile uint32_t maxCycles[CO_PROFILE_COUNT]; /* Longest duration of each source, in CPU cycles */
+    volatile int16_t irq[CO_PROFILE_COUNT];        /* IRQ number the source was last recorded from */
+    uint32_t lockStart;                            /* Start of the current critical section */
+    uint32_t bootTime_us[CO_PROFILE_BOOT_COUNT];   /* End of each boot phase, only the first one is recorded */
+    uint32_t bootMarked;                           /* Bit of each phase recorded */
+    uint32_t bootElapsed_us;                       /* Time of the last mark */
+    uint32_t bootCycles;                           /* Cycle counter at the last mark */
+    uint32_t bootRemainder;                        /* Cycles of the last mark not converted to microseconds */
+    uint32_t bootTick;                             /* HAL tick at the last mark */
+    uint32_t bootMHz;                              /* Core clock at the last mark, 0 before CO_profile_bootStart() */
+} CO_profile_t;
+
+extern CO_profile_t CO_profile;
+
+/* Enable the DWT cycle counter and clear the counters */
+void CO_profile_init(void);
+/* Clear the counters */
+void CO_profile_reset(void);
+/* Longest time the given interrupt may have waited before entering its handler, in CPU cycles */
+uint32_t CO_profile_worstLatency(IRQn_Type irq);
+/* Convert CPU cycles to microseconds */
+uint32_t CO_profile_cyclesToUs(uint32_t cycles);
+/* Start of the boot timeline, first statement of main() */
+void CO_profile_bootStart(void);
+/* End of a boot phase, from any context. The marks after the first one of each phase are ignored. */
+void CO_profile_bootMark(CO_profile_boot_t phase);
+
+#if CO_CONFIG_STM32_PROFILE
+
+static inline uint32_t
+CO_profile_now(void) {
+    return DWT->CYCCNT;
+}
+
+/* Record the duration of a section started at 'start', must be called from the section's own context */
+static inline void
+CO_profile_record(CO_profile_source_t source, uint32_t start) {
+    uint32_t elapsed = DWT->CYCCNT - start;
+    if (elapsed > CO_profile.maxCycles[source]) {
+        CO_profile.maxCycles[source] = elapsed;
+    }
+    CO_profile.irq[source] = (int16_t)__get_IPSR() - 16;
+}
+
+/* Only the outermost critical section is measured, 'prev' is the interrupt mask saved by the lock */
+#define CO_PROFILE_LOCK_ENTER(prev)                                                                                    \
+    do {                                                                                                               \
+        if ((prev) == 0U) {                                                                                            \
+            CO_profile.lockStart = DWT->CYCCNT;                                                                        \
+        }                                                                                                              \
+    } while (0)
+#define CO_PROFILE_LOCK_EXIT(prev)                                                                                     \
+    do {                                                                                                               \
+        if ((prev) == 0U) {                                                                                            \
+            CO_profile_record(CO_PROFILE_LOCK, CO_profile.lockStart);                                                  \
+        }                                                                                                              \
+    } while (0)
+
+#else
+
+static inline uint32_t
+CO_profile_now(void) {
+    return 0;
+}
+
+static inline void
+CO_profile_record(CO_profile_source_t source, uint32_t start) {
+    (void)source;
+    (void)start;
+}
+
+#define CO_PROFILE_LOCK_ENTER(prev)
+#define CO_PROFILE_LOCK_EXIT(prev)
+
+#endif /* CO_CONFIG_STM32_PROFILE */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CO_PROFILE_STM32_H */
@@ -70,31 +70,127 @@ OD_ATTR_PERSIST_COMM OD_PERSIST_COMM_t OD_PERSIST_COMM = {
         .eventTimer = 0x0000,
         .SYNCStartValue = 0x00
     },
+    .x1801_TPDOCommunicationParameter = {
+        .highestSub_indexSupported = 0x06,
+        .COB_IDUsedByTPDO = 0x00000280,
+        .transmissionType = 0xFE,
+        .inhibitTime = 0x0000,
+        .eventTimer = 0x03E8,
+        .SYNCStartValue = 0x00
+    },
+    .x1802_TPDOCommunicationParameter = {
+        .highestSub_indexSupported = 0x06,
+        .COB_IDUsedByTPDO = 0x00000380,
+        .transmissionType = 0xFE,
+        .inhibitTime = 0x2710,
+        .eventTimer = 0x2710,
+        .SYNCStartValue = 0x00
+    },
     .x1A00_TPDOMappingParameter = {
-        .numberOfMappedApplicationObjectsInPDO = 0x01,
-        .applicationObject1 = 0x60000008,
-        .applicationObject2 = 0x00000000,
-        .applicationObject3 = 0x00000000,
+        .numberOfMappedApplicationObjectsInPDO = 0x03,
+        .applicationObject1 = 0x60000108,
+        .applicationObject2 = 0x21110108,
+        .applicationObject3 = 0x21110208,
         .applicationObject4 = 0x00000000,
         .applicationObject5 = 0x00000000,
         .applicationObject6 = 0x00000000,
         .applicationObject7 = 0x00000000,
         .applicationObject8 = 0x00000000
     },
-    .x6000_state = 0x00,
+    .x1A01_TPDOMappingParameter = {
+        .numberOfMappedApplicationObjectsInPDO = 0x03,
+        .applicationObject1 = 0x21000110,
+        .applicationObject2 = 0x21000210,
+        .applicationObject3 = 0x21000310,
+        .applicationObject4 = 0x00000000,
+        .applicationObject5 = 0x00000000,
+        .applicationObject6 = 0x00000000,
+        .applicationObject7 = 0x00000000,
+        .applicationObject8 = 0x00000000
+    },
+    .x1A02_TPDOMappingParameter = {
+        .numberOfMappedApplicationObjectsInPDO = 0x06,
+        .applicationObject1 = 0x21420008,
+        .applicationObject2 = 0x21400110,
+        .applicationObject3 = 0x21400210,
+        .applicationObject4 = 0x21410108,
+        .applicationObject5 = 0x21410208,
+        .applicationObject6 = 0x60000108,
+        .applicationObject7 = 0x00000000,
+        .applicationObject8 = 0x00000000
+    },
+    .x6000_state_sub0 = 0x02,
+    .x6000_state = {0x00, 0x00},
     .x6001_controllerState = 0x00
 };
 
 OD_ATTR_RAM OD_RAM_t OD_RAM = {
     .x1001_errorRegister = 0x00,
     .x1010_storeParameters_sub0 = 0x04,
-    .x1010_storeParameters = {0x00000001, 0x00000001, 0x00000001, 0x00000001},
+    .x1010_storeParameters = {0x00000001, 0x00000000, 0x00000000, 0x00000001},
     .x1011_restoreDefaultParameters_sub0 = 0x04,
-    .x1011_restoreDefaultParameters = {0x00000001, 0x00000001, 0x00000001, 0x00000001},
+    .x1011_restoreDefaultParameters = {0x00000001, 0x00000000, 0x00000000, 0x00000001},
     .x1200_SDOServerParameter = {
         .highestSub_indexSupported = 0x02,
         .COB_IDClientToServerRx = 0x00000600,
         .COB_IDServerToClientTx = 0x00000580
+    },
+    .x2000_configuration = {
+        .highestSub_indexSupported = 0x04,
+        .nodeId = 0x02,
+        .buzzerConfig = 0x00,
+        .ledConfig = 0x00,
+        .bitRate = 0x00FA
+    },
+    .x2001_configurationStore = {
+        .highestSub_indexSupported = 0x04,
+        .quietPeriod = 0x07D0,
+        .state = 0x00,
+        .commitCount = 0x00000000,
+        .coalescedWrites = 0x00000000
+    },
+    .x2100_vibrationFeatures = {
+        .highestSub_indexSupported = 0x03,
+        .pulseRate = 0x0000,
+        .peakRate = 0x0000,
+        .burstLength = 0x0000
+    },
+    .x2110_fusionParameters = {
+        .highestSub_indexSupported = 0x06,
+        .enable = 0x01,
+        .correlationWindow = 0x0BB8,
+        .minimumEvidence = 0x02,
+        .suspectConfidence = 0x1E,
+        .confirmConfidence = 0x50,
+        .vibrationRate = 0x0014
+    },
+    .x2111_fusionStatus = {
+        .highestSub_indexSupported = 0x02,
+        .fusedState = 0x00,
+        .confidence = 0x00
+    },
+    .x2130_signalPatterns = {
+        .highestSub_indexSupported = 0x04,
+        .ledDetection = 0x01,
+        .ledArmed = 0x02,
+        .buzzerTempo = 0x02,
+        .buzzerAlarm = 0x03
+    },
+    .x2131_customPattern_sub0 = 0x08,
+    .x2131_customPattern = {0x0064, 0x0064, 0x0064, 0x0064, 0x0064, 0x0384, 0x0000, 0x0000},
+    .x2140_triggerCount_sub0 = 0x02,
+    .x2140_triggerCount = {0x0000, 0x0000},
+    .x2141_triggerAge_sub0 = 0x02,
+    .x2141_triggerAge = {0xFF, 0xFF},
+    .x2142_activitySequence = 0x00,
+    .x2150_logLevel_sub0 = 0x06,
+    .x2150_logLevel = {0x02, 0x03, 0x03, 0x03, 0x03, 0x03},
+    .x2160_bootTimeline_sub0 = 0x0B,
+    .x2160_bootTimeline = {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+    .x6002_vibrationStatistics = {
+        .highestSub_indexSupported = 0x02,
+        .pulseCount = 0x0000,
+        .dutyCycle = 0x00
     }
 };
 
@@ -124,9 +220,27 @@ typedef struct {
     OD_obj_record_t o_1400_RPDOCommunicationParameter[4];
     OD_obj_record_t o_1600_RPDOMappingParameter[9];
     OD_obj_record_t o_1800_TPDOCommunicationParameter[6];
+    OD_obj_record_t o_1801_TPDOCommunicationParameter[6];
+    OD_obj_record_t o_1802_TPDOCommunicationParameter[6];
     OD_obj_record_t o_1A00_TPDOMappingParameter[9];
-    OD_obj_var_t o_6000_state;
-    OD_obj_var_t o_6001_controllerState;
+    OD_obj_record_t o_1A01_TPDOMappingParameter[9];
+    OD_obj_record_t o_1A02_TPDOMappingParameter[9];
+    OD_obj_record_t o_2000_configuration[5];
+    OD_obj_record_t o_2001_configurationStore[5];
+    OD_obj_record_t o_2100_vibrationFeatures[4];
+    OD_obj_record_t o_2110_fusionParameters[7];
+    OD_obj_record_t o_2111_fusionStatus[3];
+    OD_obj_var_t o_2120_eventJournal;
+    OD_obj_record_t o_2130_signalPatterns[5];
+    OD_obj_array_t o_2131_customPattern;
+    OD_obj_array_t o_2140_triggerCount;
+    OD_obj_array_t o_2141_triggerAge;
+    OD_obj_var_t o_2142_activitySequence;
+    OD_obj_array_t o_2150_logLevel;
+    OD_obj_array_t o_2160_bootTimeline;
+    OD_obj_array_t o_6000_state;
+    OD_obj_var_t o_6001_controllerState;
+    OD_obj_record_t o_6002_vibrationStatistics[3];
 } ODObjs_t;
 
 static CO_PROGMEM ODObjs_t ODObjs = {
@@ -410,6 +524,82 @@ static CO_PROGMEM ODObjs_t ODObjs = {
             .dataLength = 1
         }
     },
+    .o_1801_TPDOCommunicationParameter = {
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1801_TPDOCommunicationParameter.highestSub_indexSupported,
+            .subIndex = 0,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1801_TPDOCommunicationParameter.COB_IDUsedByTPDO,
+            .subIndex = 1,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1801_TPDOCommunicationParameter.transmissionType,
+            .subIndex = 2,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1801_TPDOCommunicationParameter.inhibitTime,
+            .subIndex = 3,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 2
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1801_TPDOCommunicationParameter.eventTimer,
+            .subIndex = 5,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 2
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1801_TPDOCommunicationParameter.SYNCStartValue,
+            .subIndex = 6,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        }
+    },
+    .o_1802_TPDOCommunicationParameter = {
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1802_TPDOCommunicationParameter.highestSub_indexSupported,
+            .subIndex = 0,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1802_TPDOCommunicationParameter.COB_IDUsedByTPDO,
+            .subIndex = 1,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1802_TPDOCommunicationParameter.transmissionType,
+            .subIndex = 2,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1802_TPDOCommunicationParameter.inhibitTime,
+            .subIndex = 3,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 2
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1802_TPDOCommunicationParameter.eventTimer,
+            .subIndex = 5,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 2
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1802_TPDOCommunicationParameter.SYNCStartValue,
+            .subIndex = 6,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        }
+    },
     .o_1A00_TPDOMappingParameter = {
         {
             .dataOrig = &OD_PERSIST_COMM.x1A00_TPDOMappingParameter.numberOfMappedApplicationObjectsInPDO,
@@ -466,15 +656,386 @@ static CO_PROGMEM ODObjs_t ODObjs = {
             .dataLength = 4
         }
     },
-    .o_6000_state = {
-        .dataOrig = &OD_PERSIST_COMM.x6000_state,
+    .o_1A01_TPDOMappingParameter = {
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A01_TPDOMappingParameter.numberOfMappedApplicationObjectsInPDO,
+            .subIndex = 0,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A01_TPDOMappingParameter.applicationObject1,
+            .subIndex = 1,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A01_TPDOMappingParameter.applicationObject2,
+            .subIndex = 2,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A01_TPDOMappingParameter.applicationObject3,
+            .subIndex = 3,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A01_TPDOMappingParameter.applicationObject4,
+            .subIndex = 4,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A01_TPDOMappingParameter.applicationObject5,
+            .subIndex = 5,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A01_TPDOMappingParameter.applicationObject6,
+            .subIndex = 6,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A01_TPDOMappingParameter.applicationObject7,
+            .subIndex = 7,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A01_TPDOMappingParameter.applicationObject8,
+            .subIndex = 8,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        }
+    },
+    .o_1A02_TPDOMappingParameter = {
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A02_TPDOMappingParameter.numberOfMappedApplicationObjectsInPDO,
+            .subIndex = 0,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A02_TPDOMappingParameter.applicationObject1,
+            .subIndex = 1,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A02_TPDOMappingParameter.applicationObject2,
+            .subIndex = 2,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A02_TPDOMappingParameter.applicationObject3,
+            .subIndex = 3,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A02_TPDOMappingParameter.applicationObject4,
+            .subIndex = 4,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A02_TPDOMappingParameter.applicationObject5,
+            .subIndex = 5,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A02_TPDOMappingParameter.applicationObject6,
+            .subIndex = 6,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A02_TPDOMappingParameter.applicationObject7,
+            .subIndex = 7,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_PERSIST_COMM.x1A02_TPDOMappingParameter.applicationObject8,
+            .subIndex = 8,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 4
+        }
+    },
+    .o_2000_configuration = {
+        {
+            .dataOrig = &OD_RAM.x2000_configuration.highestSub_indexSupported,
+            .subIndex = 0,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2000_configuration.nodeId,
+            .subIndex = 1,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2000_configuration.buzzerConfig,
+            .subIndex = 2,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2000_configuration.ledConfig,
+            .subIndex = 3,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2000_configuration.bitRate,
+            .subIndex = 4,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 2
+        }
+    },
+    .o_2001_configurationStore = {
+        {
+            .dataOrig = &OD_RAM.x2001_configurationStore.highestSub_indexSupported,
+            .subIndex = 0,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2001_configurationStore.quietPeriod,
+            .subIndex = 1,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 2
+        },
+        {
+            .dataOrig = &OD_RAM.x2001_configurationStore.state,
+            .subIndex = 2,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2001_configurationStore.commitCount,
+            .subIndex = 3,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x2001_configurationStore.coalescedWrites,
+            .subIndex = 4,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        }
+    },
+    .o_2100_vibrationFeatures = {
+        {
+            .dataOrig = &OD_RAM.x2100_vibrationFeatures.highestSub_indexSupported,
+            .subIndex = 0,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2100_vibrationFeatures.pulseRate,
+            .subIndex = 1,
+            .attribute = ODA_SDO_R | ODA_TPDO | ODA_MB,
+            .dataLength = 2
+        },
+        {
+            .dataOrig = &OD_RAM.x2100_vibrationFeatures.peakRate,
+            .subIndex = 2,
+            .attribute = ODA_SDO_R | ODA_TPDO | ODA_MB,
+            .dataLength = 2
+        },
+        {
+            .dataOrig = &OD_RAM.x2100_vibrationFeatures.burstLength,
+            .subIndex = 3,
+            .attribute = ODA_SDO_R | ODA_TPDO | ODA_MB,
+            .dataLength = 2
+        }
+    },
+    .o_2110_fusionParameters = {
+        {
+            .dataOrig = &OD_RAM.x2110_fusionParameters.highestSub_indexSupported,
+            .subIndex = 0,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2110_fusionParameters.enable,
+            .subIndex = 1,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2110_fusionParameters.correlationWindow,
+            .subIndex = 2,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 2
+        },
+        {
+            .dataOrig = &OD_RAM.x2110_fusionParameters.minimumEvidence,
+            .subIndex = 3,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2110_fusionParameters.suspectConfidence,
+            .subIndex = 4,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2110_fusionParameters.confirmConfidence,
+            .subIndex = 5,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2110_fusionParameters.vibrationRate,
+            .subIndex = 6,
+            .attribute = ODA_SDO_RW | ODA_MB,
+            .dataLength = 2
+        }
+    },
+    .o_2111_fusionStatus = {
+        {
+            .dataOrig = &OD_RAM.x2111_fusionStatus.highestSub_indexSupported,
+            .subIndex = 0,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2111_fusionStatus.fusedState,
+            .subIndex = 1,
+            .attribute = ODA_SDO_R | ODA_TPDO,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2111_fusionStatus.confidence,
+            .subIndex = 2,
+            .attribute = ODA_SDO_R | ODA_TPDO,
+            .dataLength = 1
+        }
+    },
+    .o_2120_eventJournal = {
+        .dataOrig = NULL,
+        .attribute = ODA_SDO_R,
+        .dataLength = 0
+    },
+    .o_2130_signalPatterns = {
+        {
+            .dataOrig = &OD_RAM.x2130_signalPatterns.highestSub_indexSupported,
+            .subIndex = 0,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2130_signalPatterns.ledDetection,
+            .subIndex = 1,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2130_signalPatterns.ledArmed,
+            .subIndex = 2,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2130_signalPatterns.buzzerTempo,
+            .subIndex = 3,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x2130_signalPatterns.buzzerAlarm,
+            .subIndex = 4,
+            .attribute = ODA_SDO_RW,
+            .dataLength = 1
+        }
+    },
+    .o_2131_customPattern = {
+        .dataOrig0 = &OD_RAM.x2131_customPattern_sub0,
+        .dataOrig = &OD_RAM.x2131_customPattern[0],
+        .attribute0 = ODA_SDO_R,
+        .attribute = ODA_SDO_RW | ODA_MB,
+        .dataElementLength = 2,
+        .dataElementSizeof = sizeof(uint16_t)
+    },
+    .o_2140_triggerCount = {
+        .dataOrig0 = &OD_RAM.x2140_triggerCount_sub0,
+        .dataOrig = &OD_RAM.x2140_triggerCount[0],
+        .attribute0 = ODA_SDO_R,
+        .attribute = ODA_SDO_R | ODA_TPDO | ODA_MB,
+        .dataElementLength = 2,
+        .dataElementSizeof = sizeof(uint16_t)
+    },
+    .o_2141_triggerAge = {
+        .dataOrig0 = &OD_RAM.x2141_triggerAge_sub0,
+        .dataOrig = &OD_RAM.x2141_triggerAge[0],
+        .attribute0 = ODA_SDO_R,
+        .attribute = ODA_SDO_R | ODA_TPDO,
+        .dataElementLength = 1,
+        .dataElementSizeof = sizeof(uint8_t)
+    },
+    .o_2142_activitySequence = {
+        .dataOrig = &OD_RAM.x2142_activitySequence,
         .attribute = ODA_SDO_R | ODA_TPDO,
         .dataLength = 1
     },
+    .o_2150_logLevel = {
+        .dataOrig0 = &OD_RAM.x2150_logLevel_sub0,
+        .dataOrig = &OD_RAM.x2150_logLevel[0],
+        .attribute0 = ODA_SDO_R,
+        .attribute = ODA_SDO_RW,
+        .dataElementLength = 1,
+        .dataElementSizeof = sizeof(uint8_t)
+    },
+    .o_2160_bootTimeline = {
+        .dataOrig0 = &OD_RAM.x2160_bootTimeline_sub0,
+        .dataOrig = &OD_RAM.x2160_bootTimeline[0],
+        .attribute0 = ODA_SDO_R,
+        .attribute = ODA_SDO_R | ODA_MB,
+        .dataElementLength = 4,
+        .dataElementSizeof = sizeof(uint32_t)
+    },
+    .o_6000_state = {
+        .dataOrig0 = &OD_PERSIST_COMM.x6000_state_sub0,
+        .dataOrig = &OD_PERSIST_COMM.x6000_state[0],
+        .attribute0 = ODA_SDO_R,
+        .attribute = ODA_SDO_R | ODA_TPDO,
+        .dataElementLength = 1,
+        .dataElementSizeof = sizeof(uint8_t)
+    },
     .o_6001_controllerState = {
         .dataOrig = &OD_PERSIST_COMM.x6001_controllerState,
         .attribute = ODA_SDO_RW | ODA_RPDO,
         .dataLength = 1
+    },
+    .o_6002_vibrationStatistics = {
+        {
+            .dataOrig = &OD_RAM.x6002_vibrationStatistics.highestSub_indexSupported,
+            .subIndex = 0,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x6002_vibrationStatistics.pulseCount,
+            .subIndex = 1,
+            .attribute = ODA_SDO_R | ODA_TPDO | ODA_MB,
+            .dataLength = 2
+        },
+        {
+            .dataOrig = &OD_RAM.x6002_vibrationStatistics.dutyCycle,
+            .subIndex = 2,
+            .attribute = ODA_SDO_R | ODA_TPDO,
+            .dataLength = 1
+        }
     }
 };
 
@@ -503,9 +1064,27 @@ static OD_ATTR_OD OD_entry_t ODList[] = {
     {0x1400, 0x04, ODT_REC, &ODObjs.o_1400_RPDOCommunicationParameter, NULL},
     {0x1600, 0x09, ODT_REC, &ODObjs.o_1600_RPDOMappingParameter, NULL},
     {0x1800, 0x06, ODT_REC, &ODObjs.o_1800_TPDOCommunicationParameter, NULL},
+    {0x1801, 0x06, ODT_REC, &ODObjs.o_1801_TPDOCommunicationParameter, NULL},
+    {0x1802, 0x06, ODT_REC, &ODObjs.o_1802_TPDOCommunicationParameter, NULL},
     {0x1A00, 0x09, ODT_REC, &ODObjs.o_1A00_TPDOMappingParameter, NULL},
-    {0x6000, 0x01, ODT_VAR, &ODObjs.o_6000_state, NULL},
-    {0x6001, 0x01, ODT_VAR, &ODObjs.o_6001_controllerState, NULL},
+    {0x1A01, 0x09, ODT_REC, &ODObjs.o_1A01_TPDOMappingParameter, NULL},
+    {0x1A02, 0x09, ODT_REC, &ODObjs.o_1A02_TPDOMappingParameter, NULL},
+    {0x2000, 0x05, ODT_REC, &ODObjs.o_2000_configuration, NULL},
+    {0x2001, 0x05, ODT_REC, &ODObjs.o_2001_configurationStore, NULL},
+    {0x2100, 0x04, ODT_REC, &ODObjs.o_2100_vibrationFeatures, NULL},
+    {0x2110, 0x07, ODT_REC, &ODObjs.o_2110_fusionParameters, NULL},
+    {0x2111, 0x03, ODT_REC, &ODObjs.o_2111_fusionStatus, NULL},
+    {0x2120, 0x01, ODT_VAR, &ODObjs.o_2120_eventJournal, NULL},
+    {0x2130, 0x05, ODT_REC, &ODObjs.o_2130_signalPatterns, NULL},
+    {0x2131, 0x09, ODT_ARR, &ODObjs.o_2131_customPattern, NULL},
+    {0x2140, 0x03, ODT_ARR, &ODObjs.o_2140_triggerCount, NULL},
+    {0x2141, 0x03, ODT_ARR, &ODObjs.o_2141_triggerAge, NULL},
+    {0x2142, 0x01, ODT_VAR, &ODObjs.o_2142_activitySequence, NULL},
+    {0x2150, 0x07, ODT_ARR, &ODObjs.o_2150_logLevel, NULL},
+    {0x2160, 0x0C, ODT_ARR, &ODObjs.o_2160_bootTimeline, NULL},
+    {0x6000, 0x03, ODT_ARR, &ODObjs.o_6000_state, NULL},
+    {0x6001, 0x01, ODT_VAR, &ODObjs.o_6001_controllerState, NULL},
+    {0x6002, 0x03, ODT_REC, &ODObjs.o_6002_vibrationStatistics, NULL},
     {0x0000, 0x00, 0, NULL, NULL}
 };
 
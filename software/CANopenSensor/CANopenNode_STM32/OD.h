@@ -16,7 +16,7 @@
 
         Created:      23/11/2020 13:00:00
         Created By:   
-        Modified:     01/06/2024 20:51:38
+        Modified:     19/10/2026 10:00:00
         Modified By:  
 
     Device Info:
@@ -45,7 +45,7 @@
 #define OD_CNT_SDO_SRV 1
 #define OD_CNT_SDO_CLI 1
 #define OD_CNT_RPDO 1
-#define OD_CNT_TPDO 1
+#define OD_CNT_TPDO 3
 
 
 /*******************************************************************************
@@ -55,6 +55,12 @@
 #define OD_CNT_ARR_1010 4
 #define OD_CNT_ARR_1011 4
 #define OD_CNT_ARR_1016 8
+#define OD_CNT_ARR_2131 8
+#define OD_CNT_ARR_2140 2
+#define OD_CNT_ARR_2141 2
+#define OD_CNT_ARR_2150 6
+#define OD_CNT_ARR_2160 11
+#define OD_CNT_ARR_6000 2
 
 
 /*******************************************************************************
@@ -110,6 +116,22 @@ typedef struct {
         uint16_t eventTimer;
         uint8_t SYNCStartValue;
     } x1800_TPDOCommunicationParameter;
+    struct {
+        uint8_t highestSub_indexSupported;
+        uint32_t COB_IDUsedByTPDO;
+        uint8_t transmissionType;
+        uint16_t inhibitTime;
+        uint16_t eventTimer;
+        uint8_t SYNCStartValue;
+    } x1801_TPDOCommunicationParameter;
+    struct {
+        uint8_t highestSub_indexSupported;
+        uint32_t COB_IDUsedByTPDO;
+        uint8_t transmissionType;
+        uint16_t inhibitTime;
+        uint16_t eventTimer;
+        uint8_t SYNCStartValue;
+    } x1802_TPDOCommunicationParameter;
     struct {
         uint8_t numberOfMappedApplicationObjectsInPDO;
         uint32_t applicationObject1;
@@ -121,7 +143,30 @@ typedef struct {
         uint32_t applicationObject7;
         uint32_t applicationObject8;
     } x1A00_TPDOMappingParameter;
-    uint8_t x6000_state;
+    struct {
+        uint8_t numberOfMappedApplicationObjectsInPDO;
+        uint32_t applicationObject1;
+        uint32_t applicationObject2;
+        uint32_t applicationObject3;
+        uint32_t applicationObject4;
+        uint32_t applicationObject5;
+        uint32_t applicationObject6;
+        uint32_t applicationObject7;
+        uint32_t applicationObject8;
+    } x1A01_TPDOMappingParameter;
+    struct {
+        uint8_t numberOfMappedApplicationObjectsInPDO;
+        uint32_t applicationObject1;
+        uint32_t applicationObject2;
+        uint32_t applicationObject3;
+        uint32_t applicationObject4;
+        uint32_t applicationObject5;
+        uint32_t applicationObject6;
+        uint32_t applicationObject7;
+        uint32_t applicationObject8;
+    } x1A02_TPDOMappingParameter;
+    uint8_t x6000_state_sub0;
+    uint8_t x6000_state[OD_CNT_ARR_6000];
     uint8_t x6001_controllerState;
 } OD_PERSIST_COMM_t;
 
@@ -136,6 +181,63 @@ typedef struct {
         uint32_t COB_IDClientToServerRx;
         uint32_t COB_IDServerToClientTx;
     } x1200_SDOServerParameter;
+    struct {
+        uint8_t highestSub_indexSupported;
+        uint8_t nodeId;
+        uint8_t buzzerConfig;
+        uint8_t ledConfig;
+        uint16_t bitRate;
+    } x2000_configuration;
+    struct {
+        uint8_t highestSub_indexSupported;
+        uint16_t quietPeriod;
+        uint8_t state;
+        uint32_t commitCount;
+        uint32_t coalescedWrites;
+    } x2001_configurationStore;
+    struct {
+        uint8_t highestSub_indexSupported;
+        uint16_t pulseRate;
+        uint16_t peakRate;
+        uint16_t burstLength;
+    } x2100_vibrationFeatures;
+    struct {
+        uint8_t highestSub_indexSupported;
+        uint8_t enable;
+        uint16_t correlationWindow;
+        uint8_t minimumEvidence;
+        uint8_t suspectConfidence;
+        uint8_t confirmConfidence;
+        uint16_t vibrationRate;
+    } x2110_fusionParameters;
+    struct {
+        uint8_t highestSub_indexSupported;
+        uint8_t fusedState;
+        uint8_t confidence;
+    } x2111_fusionStatus;
+    struct {
+        uint8_t highestSub_indexSupported;
+        uint8_t ledDetection;
+        uint8_t ledArmed;
+        uint8_t buzzerTempo;
+        uint8_t buzzerAlarm;
+    } x2130_signalPatterns;
+    uint8_t x2131_customPattern_sub0;
+    uint16_t x2131_customPattern[OD_CNT_ARR_2131];
+    uint8_t x2140_triggerCount_sub0;
+    uint16_t x2140_triggerCount[OD_CNT_ARR_2140];
+    uint8_t x2141_triggerAge_sub0;
+    uint8_t x2141_triggerAge[OD_CNT_ARR_2141];
+    uint8_t x2142_activitySequence;
+    uint8_t x2150_logLevel_sub0;
+    uint8_t x2150_logLevel[OD_CNT_ARR_2150];
+    uint8_t x2160_bootTimeline_sub0;
+    uint32_t x2160_bootTimeline[OD_CNT_ARR_2160];
+    struct {
+        uint8_t highestSub_indexSupported;
+        uint16_t pulseCount;
+        uint8_t dutyCycle;
+    } x6002_vibrationStatistics;
 } OD_RAM_t;
 
 #ifndef OD_ATTR_PERSIST_COMM
@@ -177,9 +279,27 @@ extern OD_ATTR_OD OD_t *OD;
 #define OD_ENTRY_H1400 &OD->list[17]
 #define OD_ENTRY_H1600 &OD->list[18]
 #define OD_ENTRY_H1800 &OD->list[19]
-#define OD_ENTRY_H1A00 &OD->list[20]
-#define OD_ENTRY_H6000 &OD->list[21]
-#define OD_ENTRY_H6001 &OD->list[22]
+#define OD_ENTRY_H1801 &OD->list[20]
+#define OD_ENTRY_H1802 &OD->list[21]
+#define OD_ENTRY_H1A00 &OD->list[22]
+#define OD_ENTRY_H1A01 &OD->list[23]
+#define OD_ENTRY_H1A02 &OD->list[24]
+#define OD_ENTRY_H2000 &OD->list[25]
+#define OD_ENTRY_H2001 &OD->list[26]
+#define OD_ENTRY_H2100 &OD->list[27]
+#define OD_ENTRY_H2110 &OD->list[28]
+#define OD_ENTRY_H2111 &OD->list[29]
+#define OD_ENTRY_H2120 &OD->list[30]
+#define OD_ENTRY_H2130 &OD->list[31]
+#define OD_ENTRY_H2131 &OD->list[32]
+#define OD_ENTRY_H2140 &OD->list[33]
+#define OD_ENTRY_H2141 &OD->list[34]
+#define OD_ENTRY_H2142 &OD->list[35]
+#define OD_ENTRY_H2150 &OD->list[36]
+#define OD_ENTRY_H2160 &OD->list[37]
+#define OD_ENTRY_H6000 &OD->list[38]
+#define OD_ENTRY_H6001 &OD->list[39]
+#define OD_ENTRY_H6002 &OD->list[40]
 
 
 /*******************************************************************************
@@ -205,9 +325,27 @@ extern OD_ATTR_OD OD_t *OD;
 #define OD_ENTRY_H1400_RPDOCommunicationParameter &OD->list[17]
 #define OD_ENTRY_H1600_RPDOMappingParameter &OD->list[18]
 #define OD_ENTRY_H1800_TPDOCommunicationParameter &OD->list[19]
-#define OD_ENTRY_H1A00_TPDOMappingParameter &OD->list[20]
-#define OD_ENTRY_H6000_state &OD->list[21]
-#define OD_ENTRY_H6001_controllerState &OD->list[22]
+#define OD_ENTRY_H1801_TPDOCommunicationParameter &OD->list[20]
+#define OD_ENTRY_H1802_TPDOCommunicationParameter &OD->list[21]
+#define OD_ENTRY_H1A00_TPDOMappingParameter &OD->list[22]
+#define OD_ENTRY_H1A01_TPDOMappingParameter &OD->list[23]
+#define OD_ENTRY_H1A02_TPDOMappingParameter &OD->list[24]
+#define OD_ENTRY_H2000_configuration &OD->list[25]
+#define OD_ENTRY_H2001_configurationStore &OD->list[26]
+#define OD_ENTRY_H2100_vibrationFeatures &OD->list[27]
+#define OD_ENTRY_H2110_fusionParameters &OD->list[28]
+#define OD_ENTRY_H2111_fusionStatus &OD->list[29]
+#define OD_ENTRY_H2120_eventJournal &OD->list[30]
+#define OD_ENTRY_H2130_signalPatterns &OD->list[31]
+#define OD_ENTRY_H2131_customPattern &OD->list[32]
+#define OD_ENTRY_H2140_triggerCount &OD->list[33]
+#define OD_ENTRY_H2141_triggerAge &OD->list[34]
+#define OD_ENTRY_H2142_activitySequence &OD->list[35]
+#define OD_ENTRY_H2150_logLevel &OD->list[36]
+#define OD_ENTRY_H2160_bootTimeline &OD->list[37]
+#define OD_ENTRY_H6000_state &OD->list[38]
+#define OD_ENTRY_H6001_controllerState &OD->list[39]
+#define OD_ENTRY_H6002_vibrationStatistics &OD->list[40]
 
 
 /*******************************************************************************
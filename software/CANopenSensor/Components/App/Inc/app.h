@@ -43,8 +43,9 @@
  * Exported functions declaration
  ************************************************************************************************************/
 void APP_Init(CAN_HandleTypeDef *hCan, TIM_HandleTypeDef *hTim,
-		void (*hCanHWInitFunction)(), UART_HandleTypeDef *hUart,
-		TIM_HandleTypeDef *hTimPwm);
+		TIM_HandleTypeDef *hTimBase, void (*hCanHWInitFunction)(),
+		UART_HandleTypeDef *hUart, TIM_HandleTypeDef *hTimPwm,
+		TIM_HandleTypeDef *hTimCounter, TIM_HandleTypeDef *hTimPattern);
 void APP_Start(void);
 void APP_ExecFromMainLoop(void);
 /************************************************************************************************************
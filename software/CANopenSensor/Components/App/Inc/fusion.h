@@ -0,0 +1,78 @@
+/**
+ ************************************************************************************************************
+ *  \file               fusion.h
+ *  \brief              Motion/vibration correlation, fused detection state (OD 0x2110, 0x2111)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+
+#ifndef APP_INC_FUSION_H_
+#define APP_INC_FUSION_H_
+
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <stdint.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+// No target dependency: the module is also built on the host by Tools/fusion_replay
+/************************************************************************************************************
+ * Exported define
+ ************************************************************************************************************/
+// Evidence kept per source, enough to reach the maximal score of a source
+#define FUSION_EVIDENCE_DEPTH    (4)
+/************************************************************************************************************
+ * Exported types
+ ************************************************************************************************************/
+typedef enum {
+	FUSION_SOURCE_MOTION = 0,
+	FUSION_SOURCE_VIBRATION = 1,
+	FUSION_SOURCE_COUNT
+} FusionSource_t;
+
+typedef enum {
+	FUSION_STATE_QUIET = 0,
+	FUSION_STATE_SUSPECT = 1,
+	FUSION_STATE_CONFIRMED = 2,
+} FusionState_t;
+
+// Content of 0x2110. The object is in RAM, not stored: the defaults apply after each reset
+typedef struct {
+	uint8_t u8Enable;              // 0: TPDO on every input change, 1: TPDO on fused state change
+	uint16_t u16WindowMs;          // Evidence older than the window is forgotten
+	uint8_t u8MinEvidence;         // Evidence events required in the window to leave QUIET
+	uint8_t u8SuspectConfidence;   // %, SUSPECT threshold
+	uint8_t u8ConfirmConfidence;   // %, CONFIRMED threshold
+	uint16_t u16VibrationRate;     // Pulses/s above which the vibration is an evidence by itself
+} FusionParameters_t;
+
+// Content of 0x2111
+typedef struct {
+	uint8_t u8State;               // FusionState_t
+	uint8_t u8Confidence;          // %
+} FusionStatus_t;
+/************************************************************************************************************
+ * Exported Constant data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void FUSION_Init(void);
+void FUSION_AddEvidence(uint32_t u32CurrentTicks, FusionSource_t eSource);
+uint8_t FUSION_Process(uint32_t u32CurrentTicks,
+		const FusionParameters_t *pxParameters, uint16_t u16PulseRate,
+		FusionStatus_t *pxStatus);
+/************************************************************************************************************
+ * Exported macros
+ ************************************************************************************************************/
+
+#endif /* APP_INC_FUSION_H_ */
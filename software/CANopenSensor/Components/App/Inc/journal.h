@@ -0,0 +1,74 @@
+/**
+ ************************************************************************************************************
+ *  \file               journal.h
+ *  \brief              Timestamped event journal, read over SDO (OD 0x2120)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+
+#ifndef APP_INC_JOURNAL_H_
+#define APP_INC_JOURNAL_H_
+
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <stdint.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported define
+ ************************************************************************************************************/
+// Number of records kept, the oldest records are overwritten (power of 2)
+#define JOURNAL_DEPTH            (64)
+#define JOURNAL_VERSION          (1)
+// Channel of the records which are not related to a sensor channel
+#define JOURNAL_CHANNEL_NONE     (0xFF)
+/************************************************************************************************************
+ * Exported types
+ ************************************************************************************************************/
+typedef enum {
+	JOURNAL_EVENT_NONE = 0,       // Record overwritten or being written while it was read
+	JOURNAL_EVENT_TRIGGER = 1,    // Sensor channel triggered (EXTI edge)
+	JOURNAL_EVENT_RELEASE = 2,    // Sensor channel released (hold time elapsed, input inactive)
+	JOURNAL_EVENT_CONTROLLER = 3, // Controller state changed (0x6001)
+} JournalEvent_t;
+
+// Content of 0x2120: one header followed by the records, oldest first, little endian
+typedef struct __attribute__((packed)) {
+	uint32_t u32FirstSequence;    // Sequence number of the first record, gaps show lost records
+	uint16_t u16Count;            // Number of records following the header
+	uint8_t u8RecordSize;         // sizeof(JournalRecord_t)
+	uint8_t u8Version;            // JOURNAL_VERSION
+} JournalHeader_t;
+
+typedef struct __attribute__((packed)) {
+	uint32_t u32Ms;               // CO_TIME: milliseconds after midnight
+	uint16_t u16Days;             // CO_TIME: days since January 1, 1984 (0 until synchronized)
+	uint8_t u8Channel;            // Sensor channel or JOURNAL_CHANNEL_NONE
+	uint8_t u8Info;               // bits 0-3: JournalEvent_t, bits 4-7: controller state
+} JournalRecord_t;
+/************************************************************************************************************
+ * Exported Constant data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void JOURNAL_Init(void);
+void JOURNAL_SyncTime(uint16_t u16Days, uint32_t u32Ms, uint32_t u32CurrentTicks);
+void JOURNAL_SetControllerState(uint8_t u8ControllerState);
+void JOURNAL_Append(uint8_t u8Channel, JournalEvent_t eEvent);
+/************************************************************************************************************
+ * Exported macros
+ ************************************************************************************************************/
+
+#endif /* APP_INC_JOURNAL_H_ */
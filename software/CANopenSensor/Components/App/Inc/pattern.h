@@ -0,0 +1,65 @@
+/**
+ ************************************************************************************************************
+ *  \file               pattern.h
+ *  \brief              Buzzer and LED patterns played by a hardware timer (OD 0x2130, 0x2131)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+
+#ifndef APP_INC_PATTERN_H_
+#define APP_INC_PATTERN_H_
+
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <stdint.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+#include "main.h"
+/************************************************************************************************************
+ * Exported define
+ ************************************************************************************************************/
+// Steps of a pattern, in ms, alternately ON and OFF starting with ON. A zero ends the pattern.
+#define PATTERN_MAX_STEPS        (8)
+/************************************************************************************************************
+ * Exported types
+ ************************************************************************************************************/
+typedef enum {
+	PATTERN_OUTPUT_LED = 0,
+	PATTERN_OUTPUT_BUZZER = 1,
+	PATTERN_OUTPUT_COUNT
+} PatternOutput_t;
+
+// Values of the 0x2130 sub-indexes. 0x2130 and 0x2131 are in RAM, not stored: the defaults apply after each reset
+typedef enum {
+	PATTERN_OFF = 0,
+	PATTERN_ON = 1,
+	PATTERN_SLOW = 2,        // 100ms ON, 2s OFF
+	PATTERN_FAST = 3,        // 100ms ON, 0.5s OFF
+	PATTERN_DOUBLE = 4,      // 100ms ON, 100ms OFF, 100ms ON, 2s OFF
+	PATTERN_CUSTOM = 5,      // Steps of 0x2131, read when the pattern starts
+	PATTERN_COUNT
+} PatternId_t;
+/************************************************************************************************************
+ * Exported Constant data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void PATTERN_Init(TIM_HandleTypeDef *hTimSequencer, TIM_HandleTypeDef *hTimPwm);
+void PATTERN_Play(PatternOutput_t eOutput, uint8_t u8Pattern);
+void PATTERN_OnUpdate(TIM_HandleTypeDef *htim);
+/************************************************************************************************************
+ * Exported macros
+ ************************************************************************************************************/
+
+#endif /* APP_INC_PATTERN_H_ */
@@ -0,0 +1,71 @@
+/**
+ ************************************************************************************************************
+ *  \file               sensors.h
+ *  \brief              Table driven sensor inputs (debounce, hold time, OD 0x6000 mapping)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+
+#ifndef APP_INC_SENSORS_H_
+#define APP_INC_SENSORS_H_
+
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <stdint.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+#include "main.h"
+// CANopen Stack
+#include "301/CO_driver.h"
+/************************************************************************************************************
+ * Exported define
+ ************************************************************************************************************/
+// One bit per channel in the state masks, one EXTI line per channel
+#define SENSORS_MAX_CHANNELS    (16)
+/************************************************************************************************************
+ * Exported types
+ ************************************************************************************************************/
+typedef enum {
+	SENSOR_KIND_MOTION = 0,
+	SENSOR_KIND_VIBRATION = 1,
+} SensorKind_t;
+
+typedef struct {
+	SensorKind_t eKind;
+	GPIO_TypeDef *pxPort;
+	uint16_t u16Pin;         // GPIO_PIN_x, the EXTI trigger edge (CubeMX) must be the active edge
+	uint8_t u8ActiveLevel;   // GPIO_PIN_SET: active high, GPIO_PIN_RESET: active low
+	uint16_t u16DebounceMs;  // Edges closer than this to the previous accepted edge are ignored
+	uint32_t u32HoldMs;      // Minimal time the channel stays triggered after its last edge
+	uint8_t u8OdSubIndex;    // Sub-index of 0x6000 (1..OD_CNT_ARR_6000)
+	uint8_t u8OdBit;         // Bit of the sub-index (0..7)
+} SensorChannel_t;
+/************************************************************************************************************
+ * Exported Constant data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void SENSORS_Init(void);
+uint8_t SENSORS_Process(uint32_t u32CurrentTicks);
+uint16_t SENSORS_GetState(void);
+uint16_t SENSORS_TakeEdges(void);
+SensorKind_t SENSORS_GetKind(uint8_t u8Channel);
+void SENSORS_UpdateOd(void);
+uint8_t SENSORS_UpdateActivityOd(CO_CANmodule_t *pxCanModule);
+void SENSORS_OnEdge(uint16_t u16Pin);
+/************************************************************************************************************
+ * Exported macros
+ ************************************************************************************************************/
+
+#endif /* APP_INC_SENSORS_H_ */
@@ -0,0 +1,62 @@
+/**
+ ************************************************************************************************************
+ *  \file               store.h
+ *  \brief              Deferred store of the configuration, coalesces the writes (OD 0x2001)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+
+#ifndef APP_INC_STORE_H_
+#define APP_INC_STORE_H_
+
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <stdint.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported define
+ ************************************************************************************************************/
+// A pending configuration is committed after this delay even if the bus never becomes idle
+#define STORE_MAX_DEFER_MS       (60000)
+// After a failed commit the quiet period is doubled at each retry, up to this delay. The
+// automatic store gives up after STORE_MAX_RETRIES failures, until the next write. The shell
+// and 0x1010 can still store at any time.
+#define STORE_MAX_RETRY_DELAY_MS (60000)
+#define STORE_MAX_RETRIES        (5)
+/************************************************************************************************************
+ * Exported types
+ ************************************************************************************************************/
+// Values of 0x2001 sub 2
+typedef enum {
+	STORE_STATE_COMMITTED = 0,   // Nothing pending, the flash holds the last committed image
+	STORE_STATE_PENDING = 1,     // Changed, waiting for the quiet period and an idle bus
+	STORE_STATE_FAILED = 2,      // The last commit failed, retried with a backoff
+} StoreState_t;
+/************************************************************************************************************
+ * Exported Constant data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void STORE_Init(int32_t (*pfCommit)(const void *pvImage), const void *pvRunning);
+void STORE_MarkDirty(uint32_t u32CurrentTicks);
+int32_t STORE_Commit(uint32_t u32CurrentTicks);
+int32_t STORE_CommitImage(const void *pvImage);
+void STORE_Process(uint32_t u32CurrentTicks, uint8_t u8BusIdle);
+/************************************************************************************************************
+ * Exported macros
+ ************************************************************************************************************/
+
+#endif /* APP_INC_STORE_H_ */
@@ -0,0 +1,71 @@
+/**
+ ************************************************************************************************************
+ *  \file               vibration.h
+ *  \brief              Vibration input conditioning (EXTI masking, hardware pulse counting)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+
+#ifndef APP_INC_VIBRATION_H_
+#define APP_INC_VIBRATION_H_
+
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <stdint.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+#include "main.h"
+/************************************************************************************************************
+ * Exported define
+ ************************************************************************************************************/
+// Duration of a counting window, opened by the first edge, in us (TIM2 ticks)
+#define VIBRATION_WINDOW_US      (100000)
+// Features: the hardware pulse counter is sampled every slot, features cover the last slots
+#define VIBRATION_SLOT_MS        (100)
+#define VIBRATION_FEATURE_SLOTS  (10)
+/************************************************************************************************************
+ * Exported types
+ ************************************************************************************************************/
+typedef struct {
+	uint16_t u16PulseCount;  // Rising edges counted during the window (saturated)
+	uint8_t u8DutyCycle;     // Time the input was high between the captured edges, in %
+} VibrationStatistics_t;
+
+typedef enum {
+	VIBRATION_FEATURES_UNCHANGED = 0,
+	VIBRATION_FEATURES_UPDATED = 1,
+	VIBRATION_FEATURES_BURST_EDGE = 2, // Updated, and a burst started or ended
+} VibrationFeaturesEvent_t;
+
+typedef struct {
+	uint16_t u16PulseRate;   // Pulses/s, mean over the last VIBRATION_FEATURE_SLOTS slots
+	uint16_t u16PeakRate;    // Pulses/s, highest slot of the last VIBRATION_FEATURE_SLOTS slots
+	uint16_t u16BurstLength; // ms, current burst of active slots, or the last one when quiet
+} VibrationFeatures_t;
+/************************************************************************************************************
+ * Exported Constant data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void VIBRATION_Init(TIM_HandleTypeDef *hTimBase, TIM_HandleTypeDef *hTimCounter);
+uint8_t VIBRATION_GetStatistics(VibrationStatistics_t *pxStatistics);
+VibrationFeaturesEvent_t VIBRATION_Process(uint32_t u32CurrentTicks,
+		VibrationFeatures_t *pxFeatures);
+void VIBRATION_OnEdge(uint16_t u16Pin);
+uint8_t VIBRATION_OnDeadline(TIM_HandleTypeDef *htim);
+/************************************************************************************************************
+ * Exported macros
+ ************************************************************************************************************/
+
+#endif /* APP_INC_VIBRATION_H_ */
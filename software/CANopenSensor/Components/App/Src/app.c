@@ -18,33 +18,57 @@
 /************************************************************************************************************
  * Project included files
  ************************************************************************************************************/
-// uShell
+// uShell, the logs of this file are in the APP category
+#define CLI_LOG_MODULE CLI_LOG_APP
 #include "sys_command_line.h"
 // CANopen Stack
 #include "CO_app_STM32.h"
 #include "OD.h"
 // App includes
 #include "Inc/app.h"
+#include "Inc/sensors.h"
+#include "Inc/vibration.h"
+#include "Inc/journal.h"
+#include "Inc/pattern.h"
+#include "Inc/fusion.h"
+#include "Inc/store.h"
+#include "CO_bitTiming_STM32.h"
+#include "CO_capture_STM32.h"
 #include "main.h"
 /************************************************************************************************************
  * Local define
  ************************************************************************************************************/
-#define SENSOR_RESET_TIMEOUT_MS  (5000)
 // The NodeID in CANopen can be 1..127, but as we reserve the NodeID 1 for the controller
 // We configure the minimal value as 2
 #define NODE_ID_MIN              (2)
 #define NODE_ID_MAX              (127)
 #define DEFAULT_CAN_ID           (NODE_ID_MIN)
+// Bit rate of the CubeMX configuration, in kbit/s, used by the configurations stored without bit rate
+#define DEFAULT_BIT_RATE         (250)
+#define BUS_LOAD_PERIOD_MS       (1000)
+// RPDO which maps the controller state (0x6001)
+#define CONTROLLER_STATE_RPDO    (0)
+// TPDO which maps the vibration features (0x2100)
+#define VIBRATION_FEATURES_TPDO  (1)
+// TPDO which maps the trigger counters and ages (0x2140 to 0x2142)
+#define ACTIVITY_TPDO            (2)
+// Signatures written to 0x1010 ("save") and 0x1011 ("load"), CiA 301
+#define OD_STORE_SIGNATURE       (0x65766173)
+#define OD_RESTORE_SIGNATURE     (0x64616F6C)
+// Sub-indexes of 0x1010 and 0x1011 which cover the configuration (0x2000)
+#define OD_STORE_SUB_ALL         (1)
+#define OD_STORE_SUB_MANUFACTURER (4)
+// No frame received for this time before the configuration is committed to flash
+#define STORE_BUS_IDLE_US        (20000)
+// Fast boot (CLI_GREET_ON_INIT false): the shell banner is printed once the boot-up frame is sent,
+// or after this delay if no node acknowledges it
+#define BANNER_DELAY_MS          (500)
+// "profile log": calls timed per log backend, and the wait for the stdout ring to be sent before
+#define PROFILE_LOG_CALLS        (8)
+#define PROFILE_LOG_DRAIN_MS     (250)
 /************************************************************************************************************
  * Local Types
  ************************************************************************************************************/
-typedef enum {
-	SENSOR_STATE_IDLE = 0,
-	SENSOR_STATE_MOUVEMENT = 1,
-	SENSOR_STATE_VIBRATION = 2,
-	SENSOR_STATE_MOUVEMENT_AND_VIBRATION = 3,
-} SensorStates_t;
-
 typedef enum {
 	CONTROLLER_STATE_IDLE,
 	CONTROLLER_STATE_ARMED,
@@ -72,28 +96,38 @@ typedef struct {
 	uint8_t u8CanId;
 	uint8_t u8BuzzerConfig; // BuzzerConfig_t
 	uint8_t u8LedConfig; // LedConfig_t
-	uint8_t au8Reserved[5];
+	uint16_t u16BitRate; // kbit/s, set by the LSS store command, 0: DEFAULT_BIT_RATE
+	uint8_t au8Reserved[3];
 } Configuration_t;
 #pragma pack(pop)
-
-typedef struct {
-	uint8_t u8Enabled;
-	uint8_t u8CurrentState;
-	uint32_t u32NextSwitchTick;
-} BuzzerWorkingStruct_t;
 /************************************************************************************************************
  * Local data
  ************************************************************************************************************/
-uint8_t g_u8GlobalState = SENSOR_STATE_IDLE;
-uint8_t g_u8PreviousState = SENSOR_STATE_IDLE;
 uint8_t g_u8ControllerState = 0;
-uint32_t g_u32MouvementTriggeredTick = 0;
-uint32_t g_u32VibrationTriggeredTick = 0;
 Configuration_t g_xConfiguration;
 CANopenNodeSTM32 g_xCanOpenNodeSTM32;
-TIM_HandleTypeDef *g_pxPwmTimer;
-BuzzerWorkingStruct_t buzzerWorkingStruct;
-BuzzerWorkingStruct_t ledWorkingStruct;
+// Last vibration pulse rate (0x2100 sub 1), evidence of the fusion
+uint16_t g_u16PulseRate = 0;
+static OD_extension_t g_xConfigurationOdExtension;
+static OD_extension_t g_xStoreOdExtension;
+static OD_extension_t g_xRestoreOdExtension;
+static OD_extension_t g_xLogLevelOdExtension;
+static OD_extension_t g_xBootTimelineOdExtension;
+#if !CLI_GREET_ON_INIT
+static bool_t g_bBannerPrinted = false;
+#endif
+// Bits of the CAN frames received and transmitted during the last BUS_LOAD_PERIOD_MS
+static uint32_t g_u32BusBits = 0;
+static uint32_t g_u32BusBitsTotal = 0;
+static uint32_t g_u32BusLoadTick = 0;
+// Bus capture export, written to the shell UART in stream mode
+static CO_capture_reader_t g_xCaptureReader;
+static bool_t g_bCaptureOutput = false;
+static bool_t g_bCaptureFollow = false;
+static bool_t g_bCapturePcap = false;
+static uint8_t g_au8CaptureBuf[CO_CAPTURE_CANDUMP_MAX];
+static uint8_t g_u8CaptureLen = 0;
+static uint8_t g_u8CaptureSent = 0;
 /************************************************************************************************************
  * Constant local data
  ************************************************************************************************************/
@@ -104,6 +138,44 @@ const char cli_set_buzzer_config_help[] = "Change the buzzer configuration.";
 const char cli_set_led_config_help[] = "Change the LED configuration.";
 const char cli_store_config_help[] = "Store the configuration in flash.";
 const char cli_load_config_help[] = "Load the configuration from flash.";
+const char cli_profile_help[] =
+		"Display the interrupt latency profiling, \"profile log\" times a log call with binlog and printf.";
+const char cli_can_timing_help[] =
+		"Display the CAN bit timings and the bus load at each bit rate.";
+const char cli_gateway_help[] =
+		"CiA 309-3 ASCII gateway to the nodes of the bus (SDO, NMT, LSS), Ctrl-D to leave.";
+const char cli_gateway_bin_help[] =
+		"Binary gateway (COBS frames, see CO_gatewayBin_STM32.h): raw CAN frames and batched SDO, closed by the host.";
+const char cli_capture_help[] =
+		"Capture the bus frames in RAM (trigger on a COB-ID, EMCY or NMT), dump or stream them as a candump log or pcap.";
+const char *const cli_profile_names[CO_PROFILE_COUNT] = {
+	[CO_PROFILE_LOCK] = "CANopen locks",
+	[CO_PROFILE_ISR_CAN_TX] = "CAN TX interrupt",
+	[CO_PROFILE_ISR_CAN_RX] = "CAN RX interrupt",
+	[CO_PROFILE_ISR_TIMER] = "CANopen timer interrupt",
+	[CO_PROFILE_ISR_EXTI] = "Sensors interrupt",
+	[CO_PROFILE_ISR_UART] = "Shell UART interrupt",
+	[CO_PROFILE_ISR_PATTERN] = "Buzzer/LED pattern interrupt",
+	[CO_PROFILE_RX_PROCESS] = "CANopen RX to response",
+	[CO_PROFILE_CAPTURE] = "Bus capture (per frame)",
+};
+const char *const cli_boot_names[CO_PROFILE_BOOT_COUNT] = {
+	[CO_PROFILE_BOOT_HAL_INIT] = "HAL_Init",
+	[CO_PROFILE_BOOT_CLOCK] = "Clock configuration",
+	[CO_PROFILE_BOOT_PERIPHERALS] = "Peripherals",
+	[CO_PROFILE_BOOT_SHELL] = "Shell",
+	[CO_PROFILE_BOOT_APP] = "Journal, sensors, patterns",
+	[CO_PROFILE_BOOT_CONFIGURATION] = "Configuration",
+	[CO_PROFILE_BOOT_CO_NEW] = "CANopen objects (CO_new)",
+	[CO_PROFILE_BOOT_CAN_INIT] = "CAN (CO_CANinit)",
+	[CO_PROFILE_BOOT_CANOPEN_INIT] = "CANopen initialized",
+	[CO_PROFILE_BOOT_BOOTUP] = "Boot-up frame sent",
+	[CO_PROFILE_BOOT_BANNER] = "Shell banner",
+};
+_Static_assert(OD_CNT_ARR_2150 == CLI_LAST_LOG_CATEGORY,
+		"0x2150 must hold one level per log category");
+_Static_assert(OD_CNT_ARR_2160 == CO_PROFILE_BOOT_COUNT,
+		"0x2160 must hold one time per boot phase");
 /************************************************************************************************************
  * Constant exported data
  ************************************************************************************************************/
@@ -126,130 +198,261 @@ static uint8_t ClitLoadConfig(int argc, char *argv[]);
 static uint8_t CliSetNodeId(int argc, char *argv[]);
 static uint8_t CliSetBuzzerConfig(int argc, char *argv[]);
 static uint8_t CliSetLedConfig(int argc, char *argv[]);
+static uint8_t CliProfile(int argc, char *argv[]);
+static uint8_t CliCanTiming(int argc, char *argv[]);
+static uint8_t CliGateway(int argc, char *argv[]);
+static size_t GatewayReceive(const uint8_t *data, size_t len);
+static size_t GatewayRespond(void *object, const char *buf, size_t count,
+		uint8_t *connectionOK);
+static uint8_t CliGatewayBin(int argc, char *argv[]);
+static size_t GatewayBinReceive(const uint8_t *data, size_t len);
+static size_t GatewayBinRespond(void *object, const uint8_t *buf, size_t count);
+static void GatewayBinClose(void *object);
+static uint8_t CliCapture(int argc, char *argv[]);
+static void CaptureOutputStart(bool_t bPcap, bool_t bFollow);
+static size_t CaptureReceive(const uint8_t *data, size_t len);
+static void CaptureOutputStop(void);
+static void CaptureProcess(void);
+static void DisplayCapture(void);
 static void DisplayConfiguration(Configuration_t *config,
 		CANopenNodeSTM32 *canOpenNodeSTM32);
+static void DisplayProfile(void);
+static void ProfileLog(void);
 static void RestoreFactoryDefault(Configuration_t *config);
 static void LoadConfiguration(Configuration_t *config);
-static int32_t StoreConfiguration(Configuration_t *config);
+static int32_t StoreConfiguration(const Configuration_t *config);
 static int32_t CheckConfiguration(Configuration_t *config);
-static void vProcessBuzzerOrLed(uint32_t u32CurrentTicks,
-		uint32_t u32HighDuration, uint32_t u32LowDuration,
-		uint8_t u8BuzzerOrLed);
-static void vChangeBuzzerOrLedState(uint8_t u8State, uint8_t u8BuzzerOrLed);
+static int32_t CommitConfiguration(const void *pvImage);
+static bool_t StoreLssConfiguration(uint8_t u8NodeId, uint16_t u16BitRate);
+static void InitConfigurationOd(void);
+static ODR_t ReadConfiguration(OD_stream_t *stream, void *buf, OD_size_t count,
+		OD_size_t *countRead);
+static ODR_t WriteConfiguration(OD_stream_t *stream, const void *buf,
+		OD_size_t count, OD_size_t *countWritten);
+static ODR_t WriteStore(OD_stream_t *stream, const void *buf, OD_size_t count,
+		OD_size_t *countWritten);
+static ODR_t WriteRestore(OD_stream_t *stream, const void *buf, OD_size_t count,
+		OD_size_t *countWritten);
+static void InitLogLevelOd(void);
+static ODR_t ReadLogLevel(OD_stream_t *stream, void *buf, OD_size_t count,
+		OD_size_t *countRead);
+static ODR_t WriteLogLevel(OD_stream_t *stream, const void *buf, OD_size_t count,
+		OD_size_t *countWritten);
+static void InitBootTimelineOd(void);
+static ODR_t ReadBootTimeline(OD_stream_t *stream, void *buf, OD_size_t count,
+		OD_size_t *countRead);
+
+// Shell commands
+CLI_COMMAND("display", cli_display_help, CliDisplay);
+CLI_COMMAND("restore", cli_restore_help, CliRestoreConfiguration);
+CLI_COMMAND("store-config", cli_store_config_help, CliStoreConfig);
+CLI_COMMAND("load-config", cli_load_config_help, ClitLoadConfig);
+CLI_COMMAND("set-node-id", cli_set_node_id_help, CliSetNodeId);
+CLI_COMMAND("set-buzzer-config", cli_set_buzzer_config_help,
+		CliSetBuzzerConfig);
+CLI_COMMAND("set-led-config", cli_set_led_config_help, CliSetLedConfig);
+CLI_COMMAND("profile", cli_profile_help, CliProfile);
+CLI_COMMAND("can-timing", cli_can_timing_help, CliCanTiming);
+CLI_COMMAND("gateway", cli_gateway_help, CliGateway);
+CLI_COMMAND("gateway-bin", cli_gateway_bin_help, CliGatewayBin);
+CLI_COMMAND("capture", cli_capture_help, CliCapture);
 /************************************************************************************************************
  * Exported functions declaration
  ************************************************************************************************************/
 void APP_Init(CAN_HandleTypeDef *hCan, TIM_HandleTypeDef *hTim,
-		void (*hCanHWInitFunction)(), UART_HandleTypeDef *hUart,
-		TIM_HandleTypeDef *hTimPwm) {
-	g_pxPwmTimer = hTimPwm;
+		TIM_HandleTypeDef *hTimBase, void (*hCanHWInitFunction)(),
+		UART_HandleTypeDef *hUart, TIM_HandleTypeDef *hTimPwm,
+		TIM_HandleTypeDef *hTimCounter, TIM_HandleTypeDef *hTimPattern) {
+	// Interrupt latency profiling
+	CO_profile_init();
 
 	CLI_INIT(hUart, USART2_IRQn);
-	CLI_ADD_CMD("display", cli_display_help, CliDisplay);
-	CLI_ADD_CMD("restore", cli_restore_help, CliRestoreConfiguration);
-	CLI_ADD_CMD("store-config", cli_store_config_help, CliStoreConfig);
-	CLI_ADD_CMD("load-config", cli_load_config_help, ClitLoadConfig);
-	CLI_ADD_CMD("set-node-id", cli_set_node_id_help, CliSetNodeId);
-	CLI_ADD_CMD("set-buzzer-config", cli_set_buzzer_config_help,
-			CliSetBuzzerConfig);
-	CLI_ADD_CMD("set-led-config", cli_set_led_config_help, CliSetLedConfig);
-
-	// Load the configuration from NVS
+	CO_profile_bootMark(CO_PROFILE_BOOT_SHELL);
+
+	// Event journal (OD 0x2120)
+	JOURNAL_Init();
+
+	// Sensor inputs
+	SENSORS_Init();
+	FUSION_Init();
+	VIBRATION_Init(hTimBase, hTimCounter);
+
+	// Buzzer and LED patterns
+	PATTERN_Init(hTimPattern, hTimPwm);
+	CO_profile_bootMark(CO_PROFILE_BOOT_APP);
+
+	// Load the configuration from NVS, also accessible from the network (0x2000, 0x1010). The
+	// defaults of a first boot are stored later by STORE_Process, not before the boot-up frame.
+	STORE_Init(CommitConfiguration, &g_xConfiguration);
 	LoadConfiguration(&g_xConfiguration);
+	InitConfigurationOd();
+	CO_profile_bootMark(CO_PROFILE_BOOT_CONFIGURATION);
+
+	// Log levels of the shell categories, also accessible from the network (0x2150)
+	InitLogLevelOd();
+
+	// Boot timeline, readable from the network (0x2160)
+	InitBootTimelineOd();
 
 	// CANopen Stack
 	g_xCanOpenNodeSTM32.CANHandle = hCan;
 	g_xCanOpenNodeSTM32.HWInitFunction = hCanHWInitFunction;
 	g_xCanOpenNodeSTM32.timerHandle = hTim;
+	g_xCanOpenNodeSTM32.timebaseHandle = hTimBase;
 	g_xCanOpenNodeSTM32.desiredNodeID = g_xConfiguration.u8CanId;
-	g_xCanOpenNodeSTM32.baudrate = 250;
+	g_xCanOpenNodeSTM32.baudrate =
+			(g_xConfiguration.u16BitRate != 0) ?
+					g_xConfiguration.u16BitRate : DEFAULT_BIT_RATE;
+	g_xCanOpenNodeSTM32.LSSstoreFunction = StoreLssConfiguration;
 	canopen_app_init(&g_xCanOpenNodeSTM32);
 }
 
 void APP_Start(void) {
 	// Configure default state
-	OD_set_u8(OD_find(OD, 0x6000), 0X00, g_u8GlobalState, false);
+	SENSORS_UpdateOd();
 }
 
 void APP_ExecFromMainLoop(void) {
 	uint32_t u32CurrentTicks = HAL_GetTick();
 	// uShell
 	CLI_RUN();
+	// Bus capture, sent while the shell is in stream mode
+	CaptureProcess();
+#if !CLI_GREET_ON_INIT
+	// Fast boot: the banner waits for the UART, it is printed once the node is on the bus
+	if (!g_bBannerPrinted
+			&& (!g_xCanOpenNodeSTM32.canOpenStack->CANmodule->firstCANtxMessage
+					|| u32CurrentTicks >= BANNER_DELAY_MS)) {
+		g_bBannerPrinted = true;
+		cli_greet();
+		CO_profile_bootMark(CO_PROFILE_BOOT_BANNER);
+	}
+#endif
 	// CANopen Stack
 	canopen_app_process();
-	// Read OD variables
-	if (OD_PERSIST_COMM.x6001_controllerState != g_u8ControllerState) {
-		g_u8ControllerState = OD_PERSIST_COMM.x6001_controllerState;
+	// Bus load, measured from the frames counted by the CAN driver
+	if ((u32CurrentTicks - g_u32BusLoadTick) >= BUS_LOAD_PERIOD_MS) {
+		uint32_t u32BusBitsTotal =
+				g_xCanOpenNodeSTM32.canOpenStack->CANmodule->busBits;
+		// The counter restarts from 0 when the communication is reset
+		g_u32BusBits = (u32BusBitsTotal >= g_u32BusBitsTotal) ?
+				(u32BusBitsTotal - g_u32BusBitsTotal) : u32BusBitsTotal;
+		g_u32BusBitsTotal = u32BusBitsTotal;
+		g_u32BusLoadTick = u32CurrentTicks;
+	}
+	// Journal timestamps follow the CO_TIME object (TIME message from the network)
+	CO_TIME_t *pxTime = g_xCanOpenNodeSTM32.canOpenStack->TIME;
+	JOURNAL_SyncTime(pxTime->days, pxTime->ms, HAL_GetTick());
+	// Read OD variables (consistent snapshot of the RPDO, written from the CANopen interrupt)
+	uint8_t u8ControllerState;
+	CANOPEN_APP_RPDO_READ(CONTROLLER_STATE_RPDO, u8ControllerState,
+			OD_PERSIST_COMM.x6001_controllerState);
+	if (u8ControllerState != g_u8ControllerState) {
+		g_u8ControllerState = u8ControllerState;
+		JOURNAL_SetControllerState(g_u8ControllerState);
+		JOURNAL_Append(JOURNAL_CHANNEL_NONE, JOURNAL_EVENT_CONTROLLER);
 		DBG("Controller state changed to: 0x%02x", g_u8ControllerState);
 	}
-	// Check motion detection sensor
-	if (((g_u8GlobalState & SENSOR_STATE_MOUVEMENT) == SENSOR_STATE_MOUVEMENT)
-			&& (u32CurrentTicks - g_u32MouvementTriggeredTick
-					> SENSOR_RESET_TIMEOUT_MS)
-			&& (HAL_GPIO_ReadPin(GPIO_Mouvement_GPIO_Port, GPIO_Mouvement_Pin)
-					== GPIO_PIN_RESET)) {
-		// Reset the sensor state if current state is cleared and
-		// the time since the last trigger is greater than SENSOR_RESET_TIMEOUT_MS
-		g_u8GlobalState &= ~SENSOR_STATE_MOUVEMENT;
-		g_u32MouvementTriggeredTick = 0;
-	}
-	// Check vibration detection sensor
-	if (((g_u8GlobalState & SENSOR_STATE_VIBRATION) == SENSOR_STATE_VIBRATION)
-			&& (u32CurrentTicks - g_u32VibrationTriggeredTick
-					> SENSOR_RESET_TIMEOUT_MS)
-			&& (HAL_GPIO_ReadPin(GPIO_Vibration_GPIO_Port, GPIO_Vibration_Pin)
-					== GPIO_PIN_RESET)) {
-		// Reset the sensor state if current state is cleared and
-		// the time since the last trigger is greater than SENSOR_RESET_TIMEOUT_MS
-		g_u8GlobalState &= ~SENSOR_STATE_VIBRATION;
-		g_u32VibrationTriggeredTick = 0;
-	}
-	// Update the OD if the global state changes
-	if (g_u8GlobalState != g_u8PreviousState) {
-		g_u8PreviousState = g_u8GlobalState;
-		OD_set_u8(OD_find(OD, 0x6000), 0X00, g_u8GlobalState, false);
+	// Sensor inputs, update the OD if the state changes
+	uint8_t u8StateChanged = SENSORS_Process(u32CurrentTicks);
+	if (u8StateChanged) {
+		SENSORS_UpdateOd();
+	}
+	// Configuration changed from the shell or the network, stored when the bus is idle
+	STORE_Process(u32CurrentTicks, canopen_app_isBusIdle(STORE_BUS_IDLE_US));
+	// Trigger counters, the activity TPDO is sent when they change (inhibit time of 0x1802)
+	// and by its event timer
+	if (SENSORS_UpdateActivityOd(
+			g_xCanOpenNodeSTM32.canOpenStack->CANmodule)) {
+		CO_TPDOsendRequest(
+				&g_xCanOpenNodeSTM32.canOpenStack->TPDO[ACTIVITY_TPDO]);
+	}
+	// Vibration statistics of the last counting window
+	VibrationStatistics_t xVibration;
+	if (VIBRATION_GetStatistics(&xVibration)) {
+		CO_LOCK_OD(g_xCanOpenNodeSTM32.canOpenStack->CANmodule);
+		OD_set_u16(OD_ENTRY_H6002_vibrationStatistics, 0x01,
+				xVibration.u16PulseCount, false);
+		OD_set_u8(OD_ENTRY_H6002_vibrationStatistics, 0x02,
+				xVibration.u8DutyCycle, false);
+		CO_UNLOCK_OD(g_xCanOpenNodeSTM32.canOpenStack->CANmodule);
+	}
+	// Vibration features, sent by the TPDO event timer and when a burst starts or ends
+	VibrationFeatures_t xFeatures;
+	VibrationFeaturesEvent_t eFeatures = VIBRATION_Process(u32CurrentTicks,
+			&xFeatures);
+	if (eFeatures != VIBRATION_FEATURES_UNCHANGED) {
+		// Locked, the TPDO 2 is processed from the CANopen interrupt and maps the three features
+		CO_LOCK_OD(g_xCanOpenNodeSTM32.canOpenStack->CANmodule);
+		OD_set_u16(OD_ENTRY_H2100_vibrationFeatures, 0x01,
+				xFeatures.u16PulseRate, false);
+		OD_set_u16(OD_ENTRY_H2100_vibrationFeatures, 0x02,
+				xFeatures.u16PeakRate, false);
+		OD_set_u16(OD_ENTRY_H2100_vibrationFeatures, 0x03,
+				xFeatures.u16BurstLength, false);
+		CO_UNLOCK_OD(g_xCanOpenNodeSTM32.canOpenStack->CANmodule);
+		if (eFeatures == VIBRATION_FEATURES_BURST_EDGE) {
+			CO_TPDOsendRequest(
+					&g_xCanOpenNodeSTM32.canOpenStack->TPDO[VIBRATION_FEATURES_TPDO]);
+		}
+		g_u16PulseRate = xFeatures.u16PulseRate;
+	}
+	// Motion/vibration fusion (0x2110), the state TPDO is sent when the fused state changes
+	for (uint16_t m = SENSORS_TakeEdges(); m != 0; m &= m - 1) {
+		FUSION_AddEvidence(u32CurrentTicks,
+				(SENSORS_GetKind(__builtin_ctz(m)) == SENSOR_KIND_MOTION) ?
+						FUSION_SOURCE_MOTION : FUSION_SOURCE_VIBRATION);
+	}
+	FusionParameters_t xFusionParameters = {
+		.u8Enable = OD_RAM.x2110_fusionParameters.enable,
+		.u16WindowMs = OD_RAM.x2110_fusionParameters.correlationWindow,
+		.u8MinEvidence = OD_RAM.x2110_fusionParameters.minimumEvidence,
+		.u8SuspectConfidence =
+				OD_RAM.x2110_fusionParameters.suspectConfidence,
+		.u8ConfirmConfidence =
+				OD_RAM.x2110_fusionParameters.confirmConfidence,
+		.u16VibrationRate = OD_RAM.x2110_fusionParameters.vibrationRate,
+	};
+	FusionStatus_t xFusion;
+	uint8_t u8FusionChanged = FUSION_Process(u32CurrentTicks,
+			&xFusionParameters, g_u16PulseRate, &xFusion);
+	if (u8FusionChanged
+			|| xFusion.u8Confidence != OD_RAM.x2111_fusionStatus.confidence) {
+		// Locked, the TPDO 1 maps the state and the confidence together
+		CO_LOCK_OD(g_xCanOpenNodeSTM32.canOpenStack->CANmodule);
+		OD_set_u8(OD_ENTRY_H2111_fusionStatus, 0x01, xFusion.u8State, false);
+		OD_set_u8(OD_ENTRY_H2111_fusionStatus, 0x02, xFusion.u8Confidence,
+				false);
+		CO_UNLOCK_OD(g_xCanOpenNodeSTM32.canOpenStack->CANmodule);
+	}
+	if ((xFusionParameters.u8Enable != 0) ? u8FusionChanged : u8StateChanged) {
 		CO_TPDOsendRequest(&g_xCanOpenNodeSTM32.canOpenStack->TPDO[0]);
 	}
 
-	if ((g_u8GlobalState != SENSOR_STATE_IDLE)
+	// Buzzer and LED patterns (0x2130), played by the pattern timer
+	uint8_t u8LedPattern = PATTERN_OFF;
+	if ((SENSORS_GetState() != 0)
 			&& ((g_xConfiguration.u8LedConfig & LED_ENABLE_ON_DETECTION)
 					== LED_ENABLE_ON_DETECTION)) {
-		// Led ON
-		HAL_GPIO_WritePin(LD3_GPIO_Port, LD3_Pin, GPIO_PIN_SET);
+		u8LedPattern = OD_RAM.x2130_signalPatterns.ledDetection;
 	} else if ((g_u8ControllerState != CONTROLLER_STATE_IDLE)
 			&& ((g_xConfiguration.u8LedConfig & LED_BLINK_ON_ARMED)
 					== LED_BLINK_ON_ARMED)) {
-		// Blink (Blink 100ms every 2s)
-		vProcessBuzzerOrLed(u32CurrentTicks, 100, 2000, 0);
-	} else {
-		if (ledWorkingStruct.u8Enabled == 1) {
-			ledWorkingStruct.u8Enabled = 0;
-			ledWorkingStruct.u8CurrentState = 0;
-			ledWorkingStruct.u32NextSwitchTick = 0;
-			DBG("Led: Stop");
-		}
-		HAL_GPIO_WritePin(LD3_GPIO_Port, LD3_Pin, GPIO_PIN_RESET);
+		u8LedPattern = OD_RAM.x2130_signalPatterns.ledArmed;
 	}
+	PATTERN_Play(PATTERN_OUTPUT_LED, u8LedPattern);
 
+	uint8_t u8BuzzerPattern = PATTERN_OFF;
 	if ((g_u8ControllerState == CONTROLLER_STATE_ALARM)
 			&& ((g_xConfiguration.u8BuzzerConfig & BUZZER_BEEP_ON_ALARM)
 					== BUZZER_BEEP_ON_ALARM)) {
-		// Beep for alarm. (Beep 100ms every 0.5s)
-		vProcessBuzzerOrLed(u32CurrentTicks, 100, 500, 1);
+		u8BuzzerPattern = OD_RAM.x2130_signalPatterns.buzzerAlarm;
 	} else if ((g_u8ControllerState == CONTROLLER_STATE_TEMPO)
 			&& ((g_xConfiguration.u8BuzzerConfig & BUZZER_BEEP_ON_TEMPO)
 					== BUZZER_BEEP_ON_TEMPO)) {
-		// Beep for tempo. (Beep 100ms every 2s)
-		vProcessBuzzerOrLed(u32CurrentTicks, 100, 2000, 1);
-	} else {
-		if (buzzerWorkingStruct.u8Enabled == 1) {
-			buzzerWorkingStruct.u8Enabled = 0;
-			buzzerWorkingStruct.u8CurrentState = 0;
-			buzzerWorkingStruct.u32NextSwitchTick = 0;
-			DBG("Buzzer: Stop");
-			HAL_TIM_PWM_Stop(g_pxPwmTimer, TIM_CHANNEL_1);
-		}
+		u8BuzzerPattern = OD_RAM.x2130_signalPatterns.buzzerTempo;
 	}
+	PATTERN_Play(PATTERN_OUTPUT_BUZZER, u8BuzzerPattern);
 }
 /************************************************************************************************************
  * Local functions declaration
@@ -262,6 +465,9 @@ static void DisplayConfiguration(Configuration_t *config,
 		printf("  - Buzzer configuration: %d\n",
 				g_xConfiguration.u8BuzzerConfig);
 		printf("  - LED configuration: %d\n", g_xConfiguration.u8LedConfig);
+		printf("  - Bit rate: %d kbit/s\n",
+				(g_xConfiguration.u16BitRate != 0) ?
+						g_xConfiguration.u16BitRate : DEFAULT_BIT_RATE);
 		printf("---------------- Status ----------------\n");
 		if (canOpenNodeSTM32 != NULL) {
 			printf("  - Active NodeID: %d\n", canOpenNodeSTM32->activeNodeID);
@@ -270,12 +476,83 @@ static void DisplayConfiguration(Configuration_t *config,
 	}
 }
 
+static void DisplayProfile(void) {
+	printf("------------- Max duration -------------\n");
+	for (uint8_t i = 0; i < CO_PROFILE_COUNT; i++) {
+		uint32_t u32Cycles = CO_profile.maxCycles[i];
+		printf("  - %s: %" PRIu32 " us (%" PRIu32 " cycles)\n",
+				cli_profile_names[i], CO_profile_cyclesToUs(u32Cycles),
+				u32Cycles);
+	}
+	printf("--------- Worst case IRQ latency -------\n");
+	printf("  - Sensors (EXTI): %" PRIu32 " us\n",
+			CO_profile_cyclesToUs(
+					CO_profile_worstLatency(GPIO_Mouvement_EXTI_IRQn)));
+	printf("  - CAN RX: %" PRIu32 " us\n",
+			CO_profile_cyclesToUs(CO_profile_worstLatency(CAN1_RX0_IRQn)));
+	printf("------------- Boot timeline ------------\n");
+	for (uint8_t i = 0; i < CO_PROFILE_BOOT_COUNT; i++) {
+		if ((CO_profile.bootMarked & (1UL << i)) != 0) {
+			printf("  - %s: %" PRIu32 " us\n", cli_boot_names[i],
+					CO_profile.bootTime_us[i]);
+		}
+	}
+	printf("--------- CANopen timer period ---------\n");
+	printf("  - Min: %" PRIu32 " us, Max: %" PRIu32 " us\n",
+			g_xCanOpenNodeSTM32.timerPeriodMin_us,
+			g_xCanOpenNodeSTM32.timerPeriodMax_us);
+	printf("----------------------------------------\n");
+}
+
+// Cost of one log call for the caller, from the call to the bytes in the stdout ring: the same DBG line
+// (file, line, 2 integers) as a binary record (CLI_BINARY_LOG) and formatted by printf (text logs).
+// Each series starts with an empty stdout ring, the records show as binary bytes without binlog_decode.
+static void ProfileLog(void) {
+#if CO_CONFIG_STM32_PROFILE
+	uint32_t au32Min[2] = { UINT32_MAX, UINT32_MAX };
+	uint32_t au32Sum[2] = { 0, 0 };
+
+	for (uint8_t u8Backend = 0; u8Backend < 2; u8Backend++) {
+		fflush(stdout);
+		HAL_Delay(PROFILE_LOG_DRAIN_MS);
+		for (uint32_t i = 0; i < PROFILE_LOG_CALLS; i++) {
+			uint32_t u32Start = CO_profile_now();
+			if (u8Backend == 0) {
+				BINLOG("D", "profile log %d of %d", (int) i, PROFILE_LOG_CALLS);
+			} else {
+				printf(CLI_FONT_YELLOW "[Debug] %s:%d: profile log %d of %d\n"
+						CLI_FONT_DEFAULT, __FILE__, __LINE__, (int) i,
+						PROFILE_LOG_CALLS);
+			}
+			uint32_t u32Cycles = CO_profile_now() - u32Start;
+			if (u32Cycles < au32Min[u8Backend]) {
+				au32Min[u8Backend] = u32Cycles;
+			}
+			au32Sum[u8Backend] += u32Cycles;
+		}
+	}
+
+	fflush(stdout);
+	HAL_Delay(PROFILE_LOG_DRAIN_MS);
+	NL1();
+	printf("------------ Log call cost -------------\n");
+	printf("  - binlog: min %" PRIu32 " cycles, mean %" PRIu32 " cycles\n",
+			au32Min[0], au32Sum[0] / PROFILE_LOG_CALLS);
+	printf("  - printf: min %" PRIu32 " cycles, mean %" PRIu32 " cycles\n",
+			au32Min[1], au32Sum[1] / PROFILE_LOG_CALLS);
+	printf("----------------------------------------\n");
+#else
+	printf("The profiling is disabled (CO_CONFIG_STM32_PROFILE).\n");
+#endif
+}
+
 static void RestoreFactoryDefault(Configuration_t *config) {
 	if (config != NULL) {
 		memset(config, 0x00, sizeof(Configuration_t));
 		config->u8CanId = DEFAULT_CAN_ID;
 		config->u8BuzzerConfig = BUZZER_DISABLED;
 		config->u8LedConfig = LED_DISABLED;
+		config->u16BitRate = DEFAULT_BIT_RATE;
 	}
 }
 
@@ -294,14 +571,21 @@ static void LoadConfiguration(Configuration_t *config) {
 		DBG(
 				"Invalid or no configuration in NVS, initializing default configuration..");
 		RestoreFactoryDefault(config);
-		StoreConfiguration(config);
+		STORE_MarkDirty(HAL_GetTick());
 	}
 }
 
-static int32_t StoreConfiguration(Configuration_t *config) {
+static int32_t StoreConfiguration(const Configuration_t *config) {
 	int32_t result = EXIT_SUCCESS;
 	uint32_t PAGEError = 0;
 
+	// Nothing to erase if the flash already holds this configuration
+	if (memcmp((const void*) FLASH_USER_START_ADDR, config,
+			sizeof(Configuration_t)) == 0) {
+		DBG("Configuration unchanged");
+		return result;
+	}
+
 	// STM32L432xx devices feature up to 256 Kbyte of embedded Flash memory available for
 	// storing programs and data in single bank architecture. The Flash memory contains 128
 	// pages of 2 Kbyte.
@@ -318,7 +602,7 @@ static int32_t StoreConfiguration(Configuration_t *config) {
 		ERR("Failed to erase flash");
 	} else {
 		uint32_t offset = 0;
-		uint64_t *data = (uint64_t*) config;
+		const uint64_t *data = (const uint64_t*) config;
 		uint32_t address = FLASH_USER_START_ADDR;
 		for (int i = 0; i < FLASH_ROW_SIZE; i++) {
 			if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD,
@@ -354,9 +638,223 @@ static int32_t CheckConfiguration(Configuration_t *config) {
 		return EXIT_FAILURE;
 	}
 
+	CO_bitTiming_t xTiming;
+	if (config->u16BitRate != 0
+			&& !CO_bitTiming_compute(HAL_RCC_GetPCLK1Freq(),
+					config->u16BitRate, &xTiming)) {
+		return EXIT_FAILURE;
+	}
+
 	return EXIT_SUCCESS;
 }
 
+static int32_t CommitConfiguration(const void *pvImage) {
+	return StoreConfiguration((const Configuration_t*) pvImage);
+}
+
+// LSS store configuration: the bit rate and the node-id are used at the next start. An
+// unconfigured node-id (0xFF) keeps the stored one.
+static bool_t StoreLssConfiguration(uint8_t u8NodeId, uint16_t u16BitRate) {
+	Configuration_t xConfiguration = g_xConfiguration;
+	if (u8NodeId != CO_LSS_NODE_ID_ASSIGNMENT) {
+		xConfiguration.u8CanId = u8NodeId;
+	}
+	xConfiguration.u16BitRate = u16BitRate;
+	if (CheckConfiguration(&xConfiguration) != EXIT_SUCCESS) {
+		return false;
+	}
+
+	g_xConfiguration = xConfiguration;
+	return (STORE_Commit(HAL_GetTick()) == EXIT_SUCCESS);
+}
+
+static void InitConfigurationOd(void) {
+	g_xConfigurationOdExtension.object = NULL;
+	g_xConfigurationOdExtension.read = ReadConfiguration;
+	g_xConfigurationOdExtension.write = WriteConfiguration;
+	g_xStoreOdExtension.object = NULL;
+	g_xStoreOdExtension.read = OD_readOriginal;
+	g_xStoreOdExtension.write = WriteStore;
+	g_xRestoreOdExtension.object = NULL;
+	g_xRestoreOdExtension.read = OD_readOriginal;
+	g_xRestoreOdExtension.write = WriteRestore;
+	if (OD_extension_init(OD_ENTRY_H2000_configuration,
+			&g_xConfigurationOdExtension) != ODR_OK
+			|| OD_extension_init(OD_ENTRY_H1010_storeParameters,
+					&g_xStoreOdExtension) != ODR_OK
+			|| OD_extension_init(OD_ENTRY_H1011_restoreDefaultParameters,
+					&g_xRestoreOdExtension) != ODR_OK) {
+		ERR("Configuration: OD 0x2000, 0x1010 or 0x1011 not found");
+	}
+}
+
+// Read of 0x2000: g_xConfiguration is the reference, it is also changed from the shell
+static ODR_t ReadConfiguration(OD_stream_t *stream, void *buf, OD_size_t count,
+		OD_size_t *countRead) {
+	if (stream == NULL || buf == NULL || countRead == NULL) {
+		return ODR_DEV_INCOMPAT;
+	}
+
+	OD_RAM.x2000_configuration.nodeId = g_xConfiguration.u8CanId;
+	OD_RAM.x2000_configuration.buzzerConfig = g_xConfiguration.u8BuzzerConfig;
+	OD_RAM.x2000_configuration.ledConfig = g_xConfiguration.u8LedConfig;
+	OD_RAM.x2000_configuration.bitRate =
+			(g_xConfiguration.u16BitRate != 0) ?
+					g_xConfiguration.u16BitRate : DEFAULT_BIT_RATE;
+	return OD_readOriginal(stream, buf, count, countRead);
+}
+
+// Write of 0x2000, validated like the shell commands. The node-id is applied by the next
+// NMT reset communication, the bit rate at the next start (like the LSS store command). The
+// configuration is stored after the quiet period of 0x2001, or immediately by 0x1010.
+static ODR_t WriteConfiguration(OD_stream_t *stream, const void *buf,
+		OD_size_t count, OD_size_t *countWritten) {
+	if (stream == NULL || buf == NULL || countWritten == NULL
+			|| count != stream->dataLength) {
+		return ODR_DEV_INCOMPAT;
+	}
+
+	Configuration_t xConfiguration = g_xConfiguration;
+	switch (stream->subIndex) {
+	case 1:
+		xConfiguration.u8CanId = CO_getUint8(buf);
+		break;
+	case 2:
+		xConfiguration.u8BuzzerConfig = CO_getUint8(buf);
+		break;
+	case 3:
+		xConfiguration.u8LedConfig = CO_getUint8(buf);
+		break;
+	case 4:
+		xConfiguration.u16BitRate = CO_getUint16(buf);
+		break;
+	default:
+		return ODR_READONLY;
+	}
+	if (CheckConfiguration(&xConfiguration) != EXIT_SUCCESS) {
+		return ODR_INVALID_VALUE;
+	}
+
+	g_xConfiguration = xConfiguration;
+	g_xCanOpenNodeSTM32.desiredNodeID = xConfiguration.u8CanId;
+	STORE_MarkDirty(HAL_GetTick());
+	return OD_writeOriginal(stream, buf, count, countWritten);
+}
+
+// Write of 0x1010: only the configuration (0x2000) is kept in flash, the communication and
+// application parameters are not stored (their sub-index reads 0).
+static ODR_t WriteStore(OD_stream_t *stream, const void *buf, OD_size_t count,
+		OD_size_t *countWritten) {
+	if (stream == NULL || buf == NULL || countWritten == NULL || count != 4) {
+		return ODR_DEV_INCOMPAT;
+	}
+	if (CO_getUint32(buf) != OD_STORE_SIGNATURE
+			|| (stream->subIndex != OD_STORE_SUB_ALL
+					&& stream->subIndex != OD_STORE_SUB_MANUFACTURER)) {
+		return ODR_DATA_TRANSF;
+	}
+
+	if (STORE_Commit(HAL_GetTick()) != EXIT_SUCCESS) {
+		return ODR_HW;
+	}
+	*countWritten = count;
+	return ODR_OK;
+}
+
+// Write of 0x1011: the default configuration is stored in flash, it is used after the next
+// reset (CiA 301). The running configuration is not changed, its pending store is cancelled.
+static ODR_t WriteRestore(OD_stream_t *stream, const void *buf, OD_size_t count,
+		OD_size_t *countWritten) {
+	if (stream == NULL || buf == NULL || countWritten == NULL || count != 4) {
+		return ODR_DEV_INCOMPAT;
+	}
+	if (CO_getUint32(buf) != OD_RESTORE_SIGNATURE
+			|| (stream->subIndex != OD_STORE_SUB_ALL
+					&& stream->subIndex != OD_STORE_SUB_MANUFACTURER)) {
+		return ODR_DATA_TRANSF;
+	}
+
+	Configuration_t xConfiguration;
+	RestoreFactoryDefault(&xConfiguration);
+	if (STORE_CommitImage(&xConfiguration) != EXIT_SUCCESS) {
+		return ODR_HW;
+	}
+	*countWritten = count;
+	return ODR_OK;
+}
+
+static void InitLogLevelOd(void) {
+	for (uint8_t i = 0; i < OD_CNT_ARR_2150; i++) {
+		OD_RAM.x2150_logLevel[i] = cli_log_levels[i];
+	}
+
+	g_xLogLevelOdExtension.object = NULL;
+	g_xLogLevelOdExtension.read = ReadLogLevel;
+	g_xLogLevelOdExtension.write = WriteLogLevel;
+	if (OD_extension_init(OD_ENTRY_H2150_logLevel, &g_xLogLevelOdExtension)
+			!= ODR_OK) {
+		ERR("Logs: OD 0x2150 not found");
+	}
+}
+
+// Read of 0x2150: the levels of the shell are the reference, they are also changed by "log"
+static ODR_t ReadLogLevel(OD_stream_t *stream, void *buf, OD_size_t count,
+		OD_size_t *countRead) {
+	if (stream == NULL || buf == NULL || countRead == NULL) {
+		return ODR_DEV_INCOMPAT;
+	}
+
+	if (stream->subIndex >= 1 && stream->subIndex <= OD_CNT_ARR_2150) {
+		OD_RAM.x2150_logLevel[stream->subIndex - 1] =
+				cli_log_levels[stream->subIndex - 1];
+	}
+	return OD_readOriginal(stream, buf, count, countRead);
+}
+
+// Write of 0x2150: CLI_LEVEL_OFF (0) to CLI_LEVEL_DEBUG (4), applied to the next log calls. The
+// levels above CLI_LOG_LEVEL are accepted but those calls are not compiled in.
+static ODR_t WriteLogLevel(OD_stream_t *stream, const void *buf, OD_size_t count,
+		OD_size_t *countWritten) {
+	if (stream == NULL || buf == NULL || countWritten == NULL || count != 1) {
+		return ODR_DEV_INCOMPAT;
+	}
+	if (stream->subIndex < 1 || stream->subIndex > OD_CNT_ARR_2150) {
+		return ODR_READONLY;
+	}
+	uint8_t u8Level = CO_getUint8(buf);
+	if (u8Level > CLI_LEVEL_DEBUG) {
+		return ODR_INVALID_VALUE;
+	}
+
+	cli_log_levels[stream->subIndex - 1] = u8Level;
+	return OD_writeOriginal(stream, buf, count, countWritten);
+}
+
+static void InitBootTimelineOd(void) {
+	g_xBootTimelineOdExtension.object = NULL;
+	g_xBootTimelineOdExtension.read = ReadBootTimeline;
+	g_xBootTimelineOdExtension.write = OD_writeOriginal;
+	if (OD_extension_init(OD_ENTRY_H2160_bootTimeline,
+			&g_xBootTimelineOdExtension) != ODR_OK) {
+		ERR("Boot: OD 0x2160 not found");
+	}
+}
+
+// Read of 0x2160: microseconds from the entry of main() to the end of each boot phase, 0 if not
+// reached yet
+static ODR_t ReadBootTimeline(OD_stream_t *stream, void *buf, OD_size_t count,
+		OD_size_t *countRead) {
+	if (stream == NULL || buf == NULL || countRead == NULL) {
+		return ODR_DEV_INCOMPAT;
+	}
+
+	if (stream->subIndex >= 1 && stream->subIndex <= OD_CNT_ARR_2160) {
+		OD_RAM.x2160_bootTimeline[stream->subIndex - 1] =
+				CO_profile.bootTime_us[stream->subIndex - 1];
+	}
+	return OD_readOriginal(stream, buf, count, countRead);
+}
+
 static uint8_t CliDisplay(int argc, char *argv[]) {
 	DisplayConfiguration(&g_xConfiguration, &g_xCanOpenNodeSTM32);
 	return EXIT_SUCCESS;
@@ -364,11 +862,14 @@ static uint8_t CliDisplay(int argc, char *argv[]) {
 
 static uint8_t CliRestoreConfiguration(int argc, char *argv[]) {
 	RestoreFactoryDefault(&g_xConfiguration);
+	STORE_MarkDirty(HAL_GetTick());
 	return EXIT_SUCCESS;
 }
 
 static uint8_t CliStoreConfig(int argc, char *argv[]) {
-	StoreConfiguration(&g_xConfiguration);
+	if (STORE_Commit(HAL_GetTick()) != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
 	return EXIT_SUCCESS;
 }
 
@@ -391,6 +892,7 @@ static uint8_t CliSetNodeId(int argc, char *argv[]) {
 	}
 
 	g_xConfiguration.u8CanId = u8Id;
+	STORE_MarkDirty(HAL_GetTick());
 
 	return EXIT_SUCCESS;
 }
@@ -413,6 +915,7 @@ static uint8_t CliSetBuzzerConfig(int argc, char *argv[]) {
 	}
 
 	g_xConfiguration.u8BuzzerConfig = u8Value;
+	STORE_MarkDirty(HAL_GetTick());
 
 	return EXIT_SUCCESS;
 }
@@ -435,80 +938,304 @@ static uint8_t CliSetLedConfig(int argc, char *argv[]) {
 	}
 
 	g_xConfiguration.u8LedConfig = u8Value;
+	STORE_MarkDirty(HAL_GetTick());
 
 	return EXIT_SUCCESS;
 }
 
-static void vProcessBuzzerOrLed(uint32_t u32CurrentTicks,
-		uint32_t u32HighDuration, uint32_t u32LowDuration,
-		uint8_t u8BuzzerOrLed) {
-	BuzzerWorkingStruct_t *pWorkingStruct =
-			(u8BuzzerOrLed == 1) ? &buzzerWorkingStruct : &ledWorkingStruct;
-	const char *pcPeripheralName = (u8BuzzerOrLed == 1) ? "Buzzer" : "Led";
-
-	if (pWorkingStruct->u8Enabled == 0) {
-		// We have to start the buzzer, we start HIGH
-		pWorkingStruct->u32NextSwitchTick = u32HighDuration + u32CurrentTicks;
-		pWorkingStruct->u8CurrentState = 1;
-		pWorkingStruct->u8Enabled = 1;
-		// Start the timer
-		DBG("%s: Start (HighT=%" PRIu32 ", LowT=%" PRIu32 ")", pcPeripheralName,
-				u32HighDuration, u32LowDuration);
-		vChangeBuzzerOrLedState(1, u8BuzzerOrLed);
-	} else {
-		// The buzzer is already started, detect if we have to change the state
-		if (u32CurrentTicks > pWorkingStruct->u32NextSwitchTick) {
-			// Switch the state
-			if (pWorkingStruct->u8CurrentState == 1) {
-				pWorkingStruct->u32NextSwitchTick = u32LowDuration
-						+ u32CurrentTicks;
-				pWorkingStruct->u8CurrentState = 0;
-				vChangeBuzzerOrLedState(0, u8BuzzerOrLed);
-				DBG("%s: Switch OFF", pcPeripheralName);
-			} else {
-				pWorkingStruct->u32NextSwitchTick = u32HighDuration
-						+ u32CurrentTicks;
-				pWorkingStruct->u8CurrentState = 1;
-				vChangeBuzzerOrLedState(1, u8BuzzerOrLed);
-				DBG("%s: Switch ON", pcPeripheralName);
+static uint8_t CliProfile(int argc, char *argv[]) {
+	if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+		CO_profile_reset();
+		canopen_app_resetTimerPeriod();
+		return EXIT_SUCCESS;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "log") == 0) {
+		ProfileLog();
+		return EXIT_SUCCESS;
+	}
+
+	if (argc != 1) {
+		printf("Usage: \"%s [reset|log]\".\n", argv[0]);
+		printf("  - reset: Clear the recorded durations.\n");
+		printf("  - log: Cycles of one DBG line sent as a binary record and with printf.\n");
+		NL1();
+		return EXIT_FAILURE;
+	}
+
+	DisplayProfile();
+	return EXIT_SUCCESS;
+}
+
+static uint8_t CliCanTiming(int argc, char *argv[]) {
+	if (argc != 1) {
+		printf("Usage: \"%s\".\n", argv[0]);
+		NL1();
+		return EXIT_FAILURE;
+	}
+
+	uint32_t u32Clock = HAL_RCC_GetPCLK1Freq();
+	printf("CAN clock: %" PRIu32 " Hz, traffic: %" PRIu32 " bits/s\n",
+			u32Clock, g_u32BusBits);
+	printf("  kbit/s  prescaler  BS1  BS2  SJW  sample point  bus load\n");
+	for (uint8_t i = 0; i < CO_BIT_TIMING_RATE_COUNT; i++) {
+		uint16_t u16Rate = CO_bitTiming_rates[i];
+		CO_bitTiming_t xTiming;
+		char cActive = (u16Rate == g_xCanOpenNodeSTM32.baudrate) ? '*' : ' ';
+		if (!CO_bitTiming_compute(u32Clock, u16Rate, &xTiming)) {
+			printf("%c %6u  not available\n", cActive, u16Rate);
+			continue;
+		}
+		// Permille of the bit rate used by the traffic measured at the active bit rate
+		uint32_t u32Load = g_u32BusBits / u16Rate;
+		printf("%c %6u  %9u  %3u  %3u  %3u  %7u.%u %%  %5" PRIu32 ".%" PRIu32 " %%\n",
+				cActive, u16Rate, xTiming.prescaler, xTiming.timeSeg1,
+				xTiming.timeSeg2, xTiming.syncJump, xTiming.samplePoint / 10,
+				xTiming.samplePoint % 10, u32Load / 10, u32Load % 10);
+	}
+	return EXIT_SUCCESS;
+}
+
+static uint8_t CliGateway(int argc, char *argv[]) {
+	if (argc != 1) {
+		printf("Usage: \"%s\".\n", argv[0]);
+		NL1();
+		return EXIT_FAILURE;
+	}
+
+	printf("CiA 309-3 gateway, \"help\" for the commands, Ctrl-D to leave.\n");
+	// The UART is given to the gateway until Ctrl-D, the logs are not sent meanwhile
+	canopen_app_gatewayEnable(GatewayRespond, NULL);
+	cli_stream_start(GatewayReceive, canopen_app_gatewayDisable, true);
+	return EXIT_SUCCESS;
+}
+
+// Commands from the UART, straight from the shell stdin ring
+static size_t GatewayReceive(const uint8_t *data, size_t len) {
+	return canopen_app_gatewayWrite((const char*) data, len);
+}
+
+// Responses of the gateway, what does not fit in the stdout ring is given again later
+static size_t GatewayRespond(void *object, const char *buf, size_t count,
+		uint8_t *connectionOK) {
+	(void) object;
+	*connectionOK = 1;
+	return cli_stream_write(buf, count);
+}
+
+static uint8_t CliGatewayBin(int argc, char *argv[]) {
+	if (argc != 1) {
+		printf("Usage: \"%s\".\n", argv[0]);
+		NL1();
+		return EXIT_FAILURE;
+	}
+
+	// Ctrl-D may be part of a frame, the host ends the session with a close frame
+	canopen_app_binaryGatewayEnable(GatewayBinRespond, GatewayBinClose, NULL);
+	cli_stream_start(GatewayBinReceive, canopen_app_binaryGatewayDisable, false);
+	return EXIT_SUCCESS;
+}
+
+static size_t GatewayBinReceive(const uint8_t *data, size_t len) {
+	return canopen_app_binaryGatewayWrite(data, len);
+}
+
+static size_t GatewayBinRespond(void *object, const uint8_t *buf, size_t count) {
+	(void) object;
+	return cli_stream_write((const char*) buf, count);
+}
+
+static void GatewayBinClose(void *object) {
+	(void) object;
+	cli_stream_end();
+}
+
+static uint8_t CliCapture(int argc, char *argv[]) {
+	if (argc == 1 || (argc == 2 && strcmp(argv[1], "status") == 0)) {
+		DisplayCapture();
+		return EXIT_SUCCESS;
+	}
+
+	if (strcmp(argv[1], "start") == 0 && argc <= 3) {
+		CO_capture_start(CO_CAPTURE_TRIGGER_NONE, 0, 0,
+				(argc == 3) ? strtoul(argv[2], NULL, 0) : 0);
+		return EXIT_SUCCESS;
+	}
+
+	if (strcmp(argv[1], "trigger") == 0 && argc >= 3) {
+		CO_capture_trigger_t eTrigger = CO_CAPTURE_TRIGGER_NONE;
+		uint16_t u16Id = 0;
+		uint16_t u16Mask = 0;
+		int iFrames = 3;
+		if (strcmp(argv[2], "id") == 0 && argc >= 5) {
+			eTrigger = CO_CAPTURE_TRIGGER_ID;
+			u16Id = strtoul(argv[3], NULL, 0);
+			u16Mask = strtoul(argv[4], NULL, 0);
+			iFrames = 5;
+		} else if (strcmp(argv[2], "emcy") == 0) {
+			eTrigger = CO_CAPTURE_TRIGGER_EMCY;
+		} else if (strcmp(argv[2], "nmt") == 0) {
+			eTrigger = CO_CAPTURE_TRIGGER_NMT;
+		}
+		if (eTrigger != CO_CAPTURE_TRIGGER_NONE && argc <= iFrames + 1) {
+			// By default the ring keeps as many frames before the trigger as after
+			CO_capture_start(eTrigger, u16Id, u16Mask,
+					(argc > iFrames) ?
+							strtoul(argv[iFrames], NULL, 0) : CO_CAPTURE_SIZE / 2);
+			return EXIT_SUCCESS;
+		}
+	}
+
+	if (strcmp(argv[1], "stop") == 0 && argc == 2) {
+		CO_capture_stop();
+		return EXIT_SUCCESS;
+	}
+
+	bool_t bDump = (strcmp(argv[1], "dump") == 0);
+	if ((bDump || strcmp(argv[1], "stream") == 0)
+			&& (argc == 2 || strcmp(argv[2], "candump") == 0
+					|| strcmp(argv[2], "pcap") == 0) && argc <= 3) {
+		bool_t bPcap = (argc == 3 && strcmp(argv[2], "pcap") == 0);
+		if (bDump) {
+			if (CO_capture.state == CO_CAPTURE_IDLE) {
+				printf("No capture.\n");
+				return EXIT_FAILURE;
+			}
+			// The ring does not change during the dump, the host can read the exact size
+			CO_capture_stop();
+			uint32_t u32Frames = (CO_capture.head < CO_CAPTURE_SIZE) ?
+					CO_capture.head : CO_CAPTURE_SIZE;
+			if (bPcap) {
+				printf("%" PRIu32 " frames, %" PRIu32 " bytes follow.\n",
+						u32Frames,
+						CO_CAPTURE_PCAP_HEADER
+								+ u32Frames * CO_CAPTURE_PCAP_RECORD);
 			}
+		} else if (CO_capture.state == CO_CAPTURE_IDLE
+				|| CO_capture.state == CO_CAPTURE_STOPPED) {
+			CO_capture_start(CO_CAPTURE_TRIGGER_NONE, 0, 0, 0);
 		}
+		CaptureOutputStart(bPcap, !bDump);
+		return EXIT_SUCCESS;
 	}
+
+	printf("Usage: \"%s [status | start [frames] | trigger {id cob-id mask | emcy | nmt} [frames] | stop |"
+			" dump [candump | pcap] | stream [candump | pcap]]\".\n", argv[0]);
+	printf("  - start: Record from now on, frames: stop after them (0: on \"stop\").\n");
+	printf("  - trigger: Keep the frames before the trigger, then record frames (default %u) from it on.\n",
+			CO_CAPTURE_SIZE / 2);
+	printf("       - id: Frames with ((COB-ID ^ cob-id) & mask) == 0, RTR is 0x8000\n");
+	printf("       - emcy: Emergency of any node\n");
+	printf("       - nmt: NMT command or boot-up of any node\n");
+	printf("  - dump: Stop and send the %u last frames.\n", CO_CAPTURE_SIZE);
+	printf("  - stream: Send the frames as they are recorded, Ctrl-D to leave.\n");
+	NL1();
+	return EXIT_FAILURE;
+}
+
+// The UART is given to the capture output until its end or Ctrl-D, the logs are not sent meanwhile
+static void CaptureOutputStart(bool_t bPcap, bool_t bFollow) {
+	CO_capture_readerInit(&g_xCaptureReader);
+	g_bCapturePcap = bPcap;
+	g_bCaptureFollow = bFollow;
+	g_u8CaptureLen = bPcap ? CO_capture_pcapHeader(g_au8CaptureBuf) : 0;
+	g_u8CaptureSent = 0;
+	g_bCaptureOutput = true;
+	cli_stream_start(CaptureReceive, CaptureOutputStop, true);
 }
 
-static void vChangeBuzzerOrLedState(uint8_t u8State, uint8_t u8BuzzerOrLed) {
-	if (u8State) {
-		if (u8BuzzerOrLed == 1) {
-			HAL_TIM_PWM_Start(g_pxPwmTimer, TIM_CHANNEL_1);
-		} else {
-			HAL_GPIO_WritePin(LD3_GPIO_Port, LD3_Pin, GPIO_PIN_SET);
+// Nothing is expected from the host but Ctrl-D
+static size_t CaptureReceive(const uint8_t *data, size_t len) {
+	(void) data;
+	return len;
+}
+
+static void CaptureOutputStop(void) {
+	g_bCaptureOutput = false;
+	if (g_xCaptureReader.lost != 0) {
+		printf("\n%" PRIu32 " frames lost, the UART is slower than the bus.\n",
+				g_xCaptureReader.lost);
+	}
+}
+
+// One frame at a time, a frame is formatted when the previous one is in the stdout ring
+static void CaptureProcess(void) {
+	while (g_bCaptureOutput) {
+		if (g_u8CaptureSent < g_u8CaptureLen) {
+			g_u8CaptureSent += cli_stream_write(
+					(const char*) &g_au8CaptureBuf[g_u8CaptureSent],
+					g_u8CaptureLen - g_u8CaptureSent);
+			if (g_u8CaptureSent < g_u8CaptureLen) {
+				return;
+			}
 		}
-	} else {
-		if (u8BuzzerOrLed == 1) {
-			HAL_TIM_PWM_Stop(g_pxPwmTimer, TIM_CHANNEL_1);
-		} else {
-			HAL_GPIO_WritePin(LD3_GPIO_Port, LD3_Pin, GPIO_PIN_RESET);
+
+		// Read before the frames: when it is stopped, no frame comes after the last one read
+		uint8_t u8State = CO_capture.state;
+		CO_capture_frame_t xFrame;
+		uint64_t u64Time;
+		if (!CO_capture_read(&g_xCaptureReader, &xFrame, &u64Time)) {
+			if (!g_bCaptureFollow || u8State == CO_CAPTURE_STOPPED) {
+				cli_stream_end();
+			}
+			return;
 		}
+		g_u8CaptureLen = g_bCapturePcap ?
+				CO_capture_pcapRecord(&xFrame, u64Time, g_au8CaptureBuf) :
+				CO_capture_candump(&xFrame, u64Time, (char*) g_au8CaptureBuf);
+		g_u8CaptureSent = 0;
 	}
 }
 
+static void DisplayCapture(void) {
+	static const char *const apcStates[] = { "idle", "armed", "triggered",
+			"stopped" };
+	uint32_t u32Head = CO_capture.head;
+	uint32_t u32Kept = (u32Head < CO_CAPTURE_SIZE) ? u32Head : CO_CAPTURE_SIZE;
+	uint32_t u32Trigger = CO_capture.triggerIndex;
+	printf("-------------- Bus capture -------------\n");
+	printf("  - State: %s\n", apcStates[CO_capture.state]);
+	switch (CO_capture.trigger) {
+	case CO_CAPTURE_TRIGGER_ID:
+		printf("  - Trigger: COB-ID 0x%03X, mask 0x%04X\n", CO_capture.triggerId,
+				CO_capture.triggerMask);
+		break;
+	case CO_CAPTURE_TRIGGER_EMCY:
+		printf("  - Trigger: EMCY\n");
+		break;
+	case CO_CAPTURE_TRIGGER_NMT:
+		printf("  - Trigger: NMT, boot-up\n");
+		break;
+	default:
+		printf("  - Trigger: none\n");
+		break;
+	}
+	printf("  - Frames recorded: %" PRIu32 ", kept: %" PRIu32 " (from #%" PRIu32 ")\n",
+			u32Head, u32Kept, u32Head - u32Kept);
+	if (u32Trigger != UINT32_MAX) {
+		printf("  - Trigger frame: #%" PRIu32 "\n", u32Trigger);
+	}
+	printf("  - Longest recording: %" PRIu32 " cycles per frame\n",
+			CO_profile.maxCycles[CO_PROFILE_CAPTURE]);
+	printf("----------------------------------------\n");
+}
+
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
 	// Handle CANOpen app interrupts
 	if (htim == canopenNodeSTM32->timerHandle) {
 		canopen_app_interrupt();
 	}
+	PATTERN_OnUpdate(htim);
 }
 
-void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
-	// We only read when the sensor is triggered! We automatically clear the triggered in main loop!
-	switch (GPIO_Pin) {
-	case GPIO_Mouvement_Pin:
-		g_u8GlobalState |= SENSOR_STATE_MOUVEMENT;
-		g_u32MouvementTriggeredTick = HAL_GetTick();
-		break;
-	case GPIO_Vibration_Pin:
-		g_u8GlobalState |= SENSOR_STATE_VIBRATION;
-		g_u32VibrationTriggeredTick = HAL_GetTick();
-		break;
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim) {
+	// End of a vibration counting window, edges after the first one re-trigger the sensor
+	if (VIBRATION_OnDeadline(htim)) {
+		SENSORS_OnEdge(GPIO_Vibration_Pin);
 	}
 }
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+	SENSORS_OnEdge(GPIO_Pin);
+	VIBRATION_OnEdge(GPIO_Pin);
+}
@@ -0,0 +1,142 @@
+/**
+ ************************************************************************************************************
+ *  \file               fusion.c
+ *  \brief              Motion/vibration correlation, fused detection state (OD 0x2110, 0x2111)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <string.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+// App includes
+#include "Inc/fusion.h"
+/************************************************************************************************************
+ * Local define
+ ************************************************************************************************************/
+// Confidence score: the first evidence of a source, each following one (up to the source
+// maximum), and both sources seen in the same window
+#define FUSION_SCORE_FIRST       (30)
+#define FUSION_SCORE_REPEAT      (10)
+#define FUSION_SCORE_SOURCE_MAX  (50)
+#define FUSION_SCORE_CORRELATION (30)
+#define FUSION_CONFIDENCE_MAX    (100)
+/************************************************************************************************************
+ * Local Types
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local data
+ ************************************************************************************************************/
+// Ticks of the last evidence events of each source, only used from the main loop
+static uint32_t g_aau32Evidence[FUSION_SOURCE_COUNT][FUSION_EVIDENCE_DEPTH];
+static uint8_t g_au8EvidenceCount[FUSION_SOURCE_COUNT];
+static uint8_t g_au8EvidenceNext[FUSION_SOURCE_COUNT];
+static FusionStatus_t g_xStatus;
+/************************************************************************************************************
+ * Constant local data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Constant exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local macros
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local function prototypes
+ ************************************************************************************************************/
+static uint8_t CountEvidence(uint32_t u32CurrentTicks, FusionSource_t eSource,
+		uint16_t u16WindowMs);
+static uint8_t SourceScore(uint8_t u8Evidence);
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void FUSION_Init(void) {
+	memset(g_au8EvidenceCount, 0, sizeof(g_au8EvidenceCount));
+	memset(g_au8EvidenceNext, 0, sizeof(g_au8EvidenceNext));
+	g_xStatus.u8State = FUSION_STATE_QUIET;
+	g_xStatus.u8Confidence = 0;
+}
+
+void FUSION_AddEvidence(uint32_t u32CurrentTicks, FusionSource_t eSource) {
+	g_aau32Evidence[eSource][g_au8EvidenceNext[eSource]] = u32CurrentTicks;
+	g_au8EvidenceNext[eSource] = (g_au8EvidenceNext[eSource] + 1)
+			% FUSION_EVIDENCE_DEPTH;
+	if (g_au8EvidenceCount[eSource] < FUSION_EVIDENCE_DEPTH) {
+		g_au8EvidenceCount[eSource]++;
+	}
+}
+
+// Returns 1 when the fused state changed. The cost is a few comparisons, it is evaluated on
+// every call so the parameters written over SDO apply immediately.
+uint8_t FUSION_Process(uint32_t u32CurrentTicks,
+		const FusionParameters_t *pxParameters, uint16_t u16PulseRate,
+		FusionStatus_t *pxStatus) {
+	uint8_t u8Motion = CountEvidence(u32CurrentTicks, FUSION_SOURCE_MOTION,
+			pxParameters->u16WindowMs);
+	uint8_t u8Vibration = CountEvidence(u32CurrentTicks,
+			FUSION_SOURCE_VIBRATION, pxParameters->u16WindowMs);
+	if ((pxParameters->u16VibrationRate != 0)
+			&& (u16PulseRate >= pxParameters->u16VibrationRate)) {
+		u8Vibration++;
+	}
+
+	uint16_t u16Confidence = SourceScore(u8Motion) + SourceScore(u8Vibration);
+	if (u8Motion != 0 && u8Vibration != 0) {
+		u16Confidence += FUSION_SCORE_CORRELATION;
+	}
+	if (u16Confidence > FUSION_CONFIDENCE_MAX) {
+		u16Confidence = FUSION_CONFIDENCE_MAX;
+	}
+
+	uint8_t u8State = FUSION_STATE_QUIET;
+	if ((u8Motion + u8Vibration) >= pxParameters->u8MinEvidence) {
+		if (u16Confidence >= pxParameters->u8ConfirmConfidence) {
+			u8State = FUSION_STATE_CONFIRMED;
+		} else if (u16Confidence >= pxParameters->u8SuspectConfidence) {
+			u8State = FUSION_STATE_SUSPECT;
+		}
+	}
+
+	uint8_t u8Changed = (u8State != g_xStatus.u8State) ? 1 : 0;
+	g_xStatus.u8State = u8State;
+	g_xStatus.u8Confidence = u16Confidence;
+	*pxStatus = g_xStatus;
+	return u8Changed;
+}
+/************************************************************************************************************
+ * Local functions declaration
+ ************************************************************************************************************/
+static uint8_t CountEvidence(uint32_t u32CurrentTicks, FusionSource_t eSource,
+		uint16_t u16WindowMs) {
+	uint8_t u8Count = 0;
+	for (uint8_t i = 0; i < g_au8EvidenceCount[eSource]; i++) {
+		if ((u32CurrentTicks - g_aau32Evidence[eSource][i]) < u16WindowMs) {
+			u8Count++;
+		}
+	}
+	return u8Count;
+}
+
+static uint8_t SourceScore(uint8_t u8Evidence) {
+	if (u8Evidence == 0) {
+		return 0;
+	}
+	uint16_t u16Score = FUSION_SCORE_FIRST
+			+ (u8Evidence - 1) * FUSION_SCORE_REPEAT;
+	return (u16Score > FUSION_SCORE_SOURCE_MAX) ?
+			FUSION_SCORE_SOURCE_MAX : u16Score;
+}
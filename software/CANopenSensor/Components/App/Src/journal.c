@@ -0,0 +1,215 @@
+/**
+ ************************************************************************************************************
+ *  \file               journal.c
+ *  \brief              Timestamped event journal, read over SDO (OD 0x2120)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <string.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+// uShell, the logs of this file are in the JOURNAL category
+#define CLI_LOG_MODULE CLI_LOG_JOURNAL
+#include "sys_command_line.h"
+// CANopen Stack
+#include "CO_app_STM32.h"
+#include "OD.h"
+// App includes
+#include "Inc/journal.h"
+#include "main.h"
+/************************************************************************************************************
+ * Local define
+ ************************************************************************************************************/
+#define JOURNAL_MS_PER_DAY       (86400000UL)
+#define JOURNAL_EVENT_MASK       (0x0F)
+#define JOURNAL_STATE_MAX        (0x0F)
+/************************************************************************************************************
+ * Local Types
+ ************************************************************************************************************/
+typedef struct {
+	volatile uint32_t u32Stamp;   // Sequence number + 1 once the record is complete, 0 while written
+	JournalRecord_t xRecord;
+} JournalSlot_t;
+
+// CO_TIME reference, the timestamps are extrapolated from it with the HAL tick
+typedef struct {
+	uint32_t u32Ms;
+	uint32_t u32Tick;
+	uint16_t u16Days;
+} JournalTimeRef_t;
+/************************************************************************************************************
+ * Local data
+ ************************************************************************************************************/
+static JournalSlot_t g_axSlots[JOURNAL_DEPTH];
+// Next sequence number, reserved by the writers (interrupts and main loop)
+static volatile uint32_t g_u32Reserved = 0;
+// Written by the main loop only, an interrupt always sees a complete reference
+static JournalTimeRef_t g_axTimeRef[2];
+static volatile uint8_t g_u8TimeRefIndex = 0;
+static volatile uint8_t g_u8ControllerState = 0;
+// SDO read of 0x2120, only used from the main loop
+static uint32_t g_u32ReadBegin = 0;
+static JournalHeader_t g_xReadHeader;
+// Record being copied, kept when it is split between two reads
+static JournalRecord_t g_xReadRecord;
+static OD_extension_t g_xOdExtension;
+/************************************************************************************************************
+ * Constant local data
+ ************************************************************************************************************/
+_Static_assert((JOURNAL_DEPTH & (JOURNAL_DEPTH - 1)) == 0,
+		"JOURNAL_DEPTH must be a power of 2");
+_Static_assert(sizeof(JournalRecord_t) == 8, "Unexpected record size");
+/************************************************************************************************************
+ * Constant exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local macros
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local function prototypes
+ ************************************************************************************************************/
+static ODR_t ReadJournal(OD_stream_t *stream, void *buf, OD_size_t count,
+		OD_size_t *countRead);
+static void ReadRecord(uint32_t u32Sequence, JournalRecord_t *pxRecord);
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void JOURNAL_Init(void) {
+	g_xOdExtension.object = NULL;
+	g_xOdExtension.read = ReadJournal;
+	g_xOdExtension.write = NULL;
+	if (OD_extension_init(OD_ENTRY_H2120_eventJournal, &g_xOdExtension)
+			!= ODR_OK) {
+		ERR("Journal: OD 0x2120 not found");
+	}
+}
+
+// Called from the main loop with the current CO_TIME value
+void JOURNAL_SyncTime(uint16_t u16Days, uint32_t u32Ms, uint32_t u32CurrentTicks) {
+	uint8_t u8Index = g_u8TimeRefIndex ^ 1;
+	g_axTimeRef[u8Index].u32Ms = u32Ms;
+	g_axTimeRef[u8Index].u32Tick = u32CurrentTicks;
+	g_axTimeRef[u8Index].u16Days = u16Days;
+	__DMB();
+	g_u8TimeRefIndex = u8Index;
+}
+
+void JOURNAL_SetControllerState(uint8_t u8ControllerState) {
+	g_u8ControllerState = u8ControllerState;
+}
+
+// May be called from any interrupt: the slot is reserved with an exclusive access, then
+// invalidated while it is written so a reader never returns a mixed record.
+void JOURNAL_Append(uint8_t u8Channel, JournalEvent_t eEvent) {
+	uint32_t u32Sequence;
+	do {
+		u32Sequence = __LDREXW(&g_u32Reserved);
+	} while (__STREXW(u32Sequence + 1, &g_u32Reserved) != 0U);
+
+	const JournalTimeRef_t *pxTimeRef = &g_axTimeRef[g_u8TimeRefIndex];
+	uint32_t u32Ms = pxTimeRef->u32Ms + (HAL_GetTick() - pxTimeRef->u32Tick);
+	uint16_t u16Days = pxTimeRef->u16Days;
+	while (u32Ms >= JOURNAL_MS_PER_DAY) {
+		u32Ms -= JOURNAL_MS_PER_DAY;
+		u16Days++;
+	}
+	uint8_t u8State = g_u8ControllerState;
+	if (u8State > JOURNAL_STATE_MAX) {
+		u8State = JOURNAL_STATE_MAX;
+	}
+
+	JournalSlot_t *pxSlot = &g_axSlots[u32Sequence & (JOURNAL_DEPTH - 1)];
+	pxSlot->u32Stamp = 0;
+	__DMB();
+	pxSlot->xRecord.u32Ms = u32Ms;
+	pxSlot->xRecord.u16Days = u16Days;
+	pxSlot->xRecord.u8Channel = u8Channel;
+	pxSlot->xRecord.u8Info = (eEvent & JOURNAL_EVENT_MASK) | (u8State << 4);
+	__DMB();
+	pxSlot->u32Stamp = u32Sequence + 1;
+}
+/************************************************************************************************************
+ * Local functions declaration
+ ************************************************************************************************************/
+// OD 0x2120 read, called by the SDO server (segmented or block upload) from the main loop.
+// The records present when the upload starts are returned, the size is indicated.
+static ODR_t ReadJournal(OD_stream_t *stream, void *buf, OD_size_t count,
+		OD_size_t *countRead) {
+	if (stream == NULL || buf == NULL || countRead == NULL) {
+		return ODR_DEV_INCOMPAT;
+	}
+
+	if (stream->dataOffset == 0) {
+		uint32_t u32End = g_u32Reserved;
+		g_u32ReadBegin = (u32End > JOURNAL_DEPTH) ? (u32End - JOURNAL_DEPTH) : 0;
+		g_xReadHeader.u32FirstSequence = g_u32ReadBegin;
+		g_xReadHeader.u16Count = u32End - g_u32ReadBegin;
+		g_xReadHeader.u8RecordSize = sizeof(JournalRecord_t);
+		g_xReadHeader.u8Version = JOURNAL_VERSION;
+		stream->dataLength = sizeof(JournalHeader_t)
+				+ g_xReadHeader.u16Count * sizeof(JournalRecord_t);
+	}
+
+	uint8_t *pu8Buf = buf;
+	OD_size_t u32Offset = stream->dataOffset;
+	OD_size_t u32Copied = 0;
+	while (u32Copied < count && u32Offset < stream->dataLength) {
+		const uint8_t *pu8Src;
+		OD_size_t u32Length;
+		if (u32Offset < sizeof(JournalHeader_t)) {
+			pu8Src = (const uint8_t*) &g_xReadHeader + u32Offset;
+			u32Length = sizeof(JournalHeader_t) - u32Offset;
+		} else {
+			OD_size_t u32RecordOffset = u32Offset - sizeof(JournalHeader_t);
+			OD_size_t u32InRecord = u32RecordOffset % sizeof(JournalRecord_t);
+			if (u32InRecord == 0) {
+				ReadRecord(
+						g_u32ReadBegin + u32RecordOffset / sizeof(JournalRecord_t),
+						&g_xReadRecord);
+			}
+			pu8Src = (const uint8_t*) &g_xReadRecord + u32InRecord;
+			u32Length = sizeof(JournalRecord_t) - u32InRecord;
+		}
+		if (u32Length > count - u32Copied) {
+			u32Length = count - u32Copied;
+		}
+		memcpy(&pu8Buf[u32Copied], pu8Src, u32Length);
+		u32Copied += u32Length;
+		u32Offset += u32Length;
+	}
+	*countRead = u32Copied;
+
+	if (u32Offset < stream->dataLength) {
+		stream->dataOffset = u32Offset;
+		return ODR_PARTIAL;
+	}
+	stream->dataOffset = 0;
+	return ODR_OK;
+}
+
+// Copies a record, an overwritten record or a record being written is returned as
+// JOURNAL_EVENT_NONE with its channel set to JOURNAL_CHANNEL_NONE.
+static void ReadRecord(uint32_t u32Sequence, JournalRecord_t *pxRecord) {
+	const JournalSlot_t *pxSlot = &g_axSlots[u32Sequence & (JOURNAL_DEPTH - 1)];
+	uint32_t u32Stamp = pxSlot->u32Stamp;
+	__DMB();
+	*pxRecord = pxSlot->xRecord;
+	__DMB();
+	if (u32Stamp != u32Sequence + 1 || pxSlot->u32Stamp != u32Stamp) {
+		memset(pxRecord, 0, sizeof(*pxRecord));
+		pxRecord->u8Channel = JOURNAL_CHANNEL_NONE;
+	}
+}
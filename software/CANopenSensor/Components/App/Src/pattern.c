@@ -0,0 +1,205 @@
+/**
+ ************************************************************************************************************
+ *  \file               pattern.c
+ *  \brief              Buzzer and LED patterns played by a hardware timer (OD 0x2130, 0x2131)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <string.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+// uShell, the logs of this file are in the PATTERN category
+#define CLI_LOG_MODULE CLI_LOG_PATTERN
+#include "sys_command_line.h"
+// CANopen Stack
+#include "CO_app_STM32.h"
+#include "OD.h"
+// App includes
+#include "Inc/pattern.h"
+/************************************************************************************************************
+ * Local define
+ ************************************************************************************************************/
+// The sequencer timer counts at 2kHz (one-pulse mode), a longer step is armed in several times
+#define PATTERN_TICKS_PER_MS     (2)
+#define PATTERN_MAX_ARM_MS       (0xFFFF / PATTERN_TICKS_PER_MS)
+/************************************************************************************************************
+ * Local Types
+ ************************************************************************************************************/
+typedef struct {
+	uint16_t au16Steps[PATTERN_MAX_STEPS];
+	uint8_t u8Count;          // 0: OFF, 1: steady ON, more: played by the timer
+	uint8_t u8Step;
+	uint16_t u16Remaining;    // ms before the end of the current step
+	uint8_t u8Pattern;        // PatternId_t
+} PatternTrack_t;
+/************************************************************************************************************
+ * Local data
+ ************************************************************************************************************/
+static TIM_HandleTypeDef *g_pxTimSequencer;
+static TIM_HandleTypeDef *g_pxTimPwm;
+static uint32_t g_u32BuzzerPulse;
+// Tracks and timer state, updated from the timer interrupt or with its interrupt disabled
+static PatternTrack_t g_axTracks[PATTERN_OUTPUT_COUNT];
+static uint16_t g_u16ArmedMs = 0;
+/************************************************************************************************************
+ * Constant local data
+ ************************************************************************************************************/
+static const uint16_t g_aau16Patterns[PATTERN_CUSTOM][PATTERN_MAX_STEPS] = {
+	[PATTERN_OFF] = { 0 },
+	[PATTERN_ON] = { 1 },
+	[PATTERN_SLOW] = { 100, 2000 },
+	[PATTERN_FAST] = { 100, 500 },
+	[PATTERN_DOUBLE] = { 100, 100, 100, 2000 },
+};
+_Static_assert(OD_CNT_ARR_2131 == PATTERN_MAX_STEPS,
+		"0x2131 must hold PATTERN_MAX_STEPS steps");
+/************************************************************************************************************
+ * Constant exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local macros
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local function prototypes
+ ************************************************************************************************************/
+static void SetOutput(PatternOutput_t eOutput, uint8_t u8On);
+static void Advance(uint16_t u16ElapsedMs);
+static void Arm(void);
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void PATTERN_Init(TIM_HandleTypeDef *hTimSequencer, TIM_HandleTypeDef *hTimPwm) {
+	g_pxTimSequencer = hTimSequencer;
+	g_pxTimPwm = hTimPwm;
+
+	// The buzzer PWM runs all the time, the pattern only changes its pulse (0 is silent)
+	g_u32BuzzerPulse = __HAL_TIM_GET_COMPARE(hTimPwm, TIM_CHANNEL_1);
+	__HAL_TIM_SET_COMPARE(hTimPwm, TIM_CHANNEL_1, 0);
+	HAL_TIM_PWM_Start(hTimPwm, TIM_CHANNEL_1);
+
+	// Each step is one run of the sequencer timer, which stops by itself at its update
+	SET_BIT(hTimSequencer->Instance->CR1, TIM_CR1_OPM);
+	__HAL_TIM_CLEAR_FLAG(hTimSequencer, TIM_FLAG_UPDATE);
+	__HAL_TIM_ENABLE_IT(hTimSequencer, TIM_IT_UPDATE);
+
+	for (uint8_t i = 0; i < PATTERN_OUTPUT_COUNT; i++) {
+		g_axTracks[i].u8Pattern = PATTERN_OFF;
+		SetOutput(i, 0);
+	}
+}
+
+// Called from the main loop, does nothing while the pattern of the output is unchanged
+void PATTERN_Play(PatternOutput_t eOutput, uint8_t u8Pattern) {
+	if (u8Pattern >= PATTERN_COUNT) {
+		u8Pattern = PATTERN_OFF;
+	}
+	PatternTrack_t *pxTrack = &g_axTracks[eOutput];
+	if (pxTrack->u8Pattern == u8Pattern) {
+		return;
+	}
+	DBG("%s: Pattern %d", (eOutput == PATTERN_OUTPUT_BUZZER) ? "Buzzer" : "Led",
+			u8Pattern);
+
+	// Stop the sequencer and account the time elapsed for the other output
+	__HAL_TIM_DISABLE_IT(g_pxTimSequencer, TIM_IT_UPDATE);
+	__HAL_TIM_DISABLE(g_pxTimSequencer);
+	uint16_t u16ElapsedMs = __HAL_TIM_GET_COUNTER(g_pxTimSequencer)
+			/ PATTERN_TICKS_PER_MS;
+	if (__HAL_TIM_GET_FLAG(g_pxTimSequencer, TIM_FLAG_UPDATE)) {
+		__HAL_TIM_CLEAR_FLAG(g_pxTimSequencer, TIM_FLAG_UPDATE);
+		u16ElapsedMs = g_u16ArmedMs;
+	}
+	Advance(u16ElapsedMs);
+
+	const uint16_t *pu16Steps = (u8Pattern == PATTERN_CUSTOM) ?
+			OD_RAM.x2131_customPattern : g_aau16Patterns[u8Pattern];
+	memcpy(pxTrack->au16Steps, pu16Steps, sizeof(pxTrack->au16Steps));
+	pxTrack->u8Count = 0;
+	while (pxTrack->u8Count < PATTERN_MAX_STEPS
+			&& pxTrack->au16Steps[pxTrack->u8Count] != 0) {
+		pxTrack->u8Count++;
+	}
+	pxTrack->u8Pattern = u8Pattern;
+	pxTrack->u8Step = 0;
+	pxTrack->u16Remaining = pxTrack->au16Steps[0];
+	SetOutput(eOutput, (pxTrack->u8Count > 0) ? 1 : 0);
+
+	Arm();
+	__HAL_TIM_ENABLE_IT(g_pxTimSequencer, TIM_IT_UPDATE);
+}
+
+// Update interrupt of the sequencer timer: end of the armed duration
+void PATTERN_OnUpdate(TIM_HandleTypeDef *htim) {
+	if (htim != g_pxTimSequencer) {
+		return;
+	}
+	Advance(g_u16ArmedMs);
+	Arm();
+}
+/************************************************************************************************************
+ * Local functions declaration
+ ************************************************************************************************************/
+static void SetOutput(PatternOutput_t eOutput, uint8_t u8On) {
+	if (eOutput == PATTERN_OUTPUT_BUZZER) {
+		__HAL_TIM_SET_COMPARE(g_pxTimPwm, TIM_CHANNEL_1,
+				u8On ? g_u32BuzzerPulse : 0);
+	} else {
+		HAL_GPIO_WritePin(LD3_GPIO_Port, LD3_Pin,
+				u8On ? GPIO_PIN_SET : GPIO_PIN_RESET);
+	}
+}
+
+// The armed duration is the shortest remaining step, so a track moves by one step at most
+static void Advance(uint16_t u16ElapsedMs) {
+	g_u16ArmedMs = 0;
+	for (uint8_t i = 0; i < PATTERN_OUTPUT_COUNT; i++) {
+		PatternTrack_t *pxTrack = &g_axTracks[i];
+		if (pxTrack->u8Count < 2) {
+			continue;
+		}
+		if (pxTrack->u16Remaining > u16ElapsedMs) {
+			pxTrack->u16Remaining -= u16ElapsedMs;
+			continue;
+		}
+		pxTrack->u8Step = (pxTrack->u8Step + 1) % pxTrack->u8Count;
+		pxTrack->u16Remaining = pxTrack->au16Steps[pxTrack->u8Step];
+		SetOutput(i, ((pxTrack->u8Step & 1) == 0) ? 1 : 0);
+	}
+}
+
+static void Arm(void) {
+	uint16_t u16ArmMs = PATTERN_MAX_ARM_MS;
+	uint8_t u8Timed = 0;
+	for (uint8_t i = 0; i < PATTERN_OUTPUT_COUNT; i++) {
+		const PatternTrack_t *pxTrack = &g_axTracks[i];
+		if (pxTrack->u8Count < 2) {
+			continue;
+		}
+		u8Timed = 1;
+		if (pxTrack->u16Remaining < u16ArmMs) {
+			u16ArmMs = pxTrack->u16Remaining;
+		}
+	}
+	__HAL_TIM_SET_COUNTER(g_pxTimSequencer, 0);
+	if (u8Timed == 0) {
+		// Nothing to play, the timer stays stopped
+		return;
+	}
+	g_u16ArmedMs = u16ArmMs;
+	__HAL_TIM_SET_AUTORELOAD(g_pxTimSequencer,
+			u16ArmMs * PATTERN_TICKS_PER_MS - 1);
+	__HAL_TIM_ENABLE(g_pxTimSequencer);
+}
@@ -0,0 +1,304 @@
+/**
+ ************************************************************************************************************
+ *  \file               sensors.c
+ *  \brief              Table driven sensor inputs (debounce, hold time, OD 0x6000 mapping)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <string.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+// uShell, the logs of this file are in the SENSORS category
+#define CLI_LOG_MODULE CLI_LOG_SENSORS
+#include "sys_command_line.h"
+// CANopen Stack
+#include "CO_app_STM32.h"
+#include "OD.h"
+// App includes
+#include "Inc/sensors.h"
+#include "Inc/journal.h"
+/************************************************************************************************************
+ * Local define
+ ************************************************************************************************************/
+#define SENSOR_RESET_TIMEOUT_MS  (5000)
+// Period used to re-check the level of a channel still active at the end of its hold time
+#define SENSOR_POLL_MS           (10)
+#define SENSOR_NO_CHANNEL        (0xFF)
+// Unit of the trigger age (0x2141), the maximal value also means "never triggered"
+#define SENSOR_AGE_UNIT_MS       (100)
+#define SENSOR_AGE_MAX           (0xFF)
+/************************************************************************************************************
+ * Local Types
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local data
+ ************************************************************************************************************/
+// EXTI line (pin number) to channel index
+static uint8_t g_au8LineChannel[16];
+// Channels triggered from the EXTI interrupt, consumed by SENSORS_Process
+static volatile uint16_t g_u16Triggered = 0;
+// Debounce state, only used from the EXTI interrupt
+static uint16_t g_u16EdgeSeen = 0;
+static uint32_t g_au32EdgeTick[SENSORS_MAX_CHANNELS];
+// Accepted edges per channel (0x2140), incremented from the EXTI interrupt, wraps at 0xFFFF
+static volatile uint16_t g_au16TriggerCount[SENSORS_MAX_CHANNELS];
+// Channels whose trigger is in the journal, set from the EXTI interrupt, cleared on release
+static uint16_t g_u16Journaled = 0;
+// Main loop state
+static uint16_t g_u16State = 0;
+static uint16_t g_u16Edges = 0;
+static uint32_t g_au32HoldStartTick[SENSORS_MAX_CHANNELS];
+static uint32_t g_u32NextCheckTick = 0;
+static uint16_t g_au16PublishedCount[OD_CNT_ARR_2140];
+static OD_extension_t g_xAgeOdExtension;
+/************************************************************************************************************
+ * Constant local data
+ ************************************************************************************************************/
+// The channel index is the bit of the channel in the state masks
+static const SensorChannel_t g_axChannels[] = {
+	{ SENSOR_KIND_MOTION, GPIO_Mouvement_GPIO_Port, GPIO_Mouvement_Pin,
+			GPIO_PIN_SET, 0, SENSOR_RESET_TIMEOUT_MS, 1, 0 },
+	{ SENSOR_KIND_VIBRATION, GPIO_Vibration_GPIO_Port, GPIO_Vibration_Pin,
+			GPIO_PIN_SET, 0, SENSOR_RESET_TIMEOUT_MS, 1, 1 },
+};
+#define SENSOR_CHANNEL_COUNT     (sizeof(g_axChannels) / sizeof(g_axChannels[0]))
+_Static_assert(SENSOR_CHANNEL_COUNT <= SENSORS_MAX_CHANNELS,
+		"Too many sensor channels");
+_Static_assert(SENSOR_CHANNEL_COUNT <= OD_CNT_ARR_2140
+		&& SENSOR_CHANNEL_COUNT <= OD_CNT_ARR_2141,
+		"0x2140 and 0x2141 must hold one sub-index per channel");
+/************************************************************************************************************
+ * Constant exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local macros
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local function prototypes
+ ************************************************************************************************************/
+static uint16_t TakeTriggered(void);
+static uint8_t IsTimeReached(uint32_t u32CurrentTicks, uint32_t u32Tick);
+static void ReleaseChannel(uint8_t u8Channel);
+static ODR_t ReadTriggerAge(OD_stream_t *stream, void *buf, OD_size_t count,
+		OD_size_t *countRead);
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void SENSORS_Init(void) {
+	memset(g_au8LineChannel, SENSOR_NO_CHANNEL, sizeof(g_au8LineChannel));
+	for (uint8_t i = 0; i < SENSOR_CHANNEL_COUNT; i++) {
+		const SensorChannel_t *pxChannel = &g_axChannels[i];
+		uint8_t u8Line = __builtin_ctz(pxChannel->u16Pin);
+		if (g_au8LineChannel[u8Line] != SENSOR_NO_CHANNEL) {
+			ERR("Sensor %d: EXTI line %d already used", i, u8Line);
+			continue;
+		}
+		if (pxChannel->u8OdSubIndex < 1
+				|| pxChannel->u8OdSubIndex > OD_CNT_ARR_6000
+				|| pxChannel->u8OdBit > 7) {
+			ERR("Sensor %d: invalid OD mapping", i);
+			continue;
+		}
+		g_au8LineChannel[u8Line] = i;
+	}
+
+	g_xAgeOdExtension.object = NULL;
+	g_xAgeOdExtension.read = ReadTriggerAge;
+	g_xAgeOdExtension.write = NULL;
+	if (OD_extension_init(OD_ENTRY_H2141_triggerAge, &g_xAgeOdExtension)
+			!= ODR_OK) {
+		ERR("Sensors: OD 0x2141 not found");
+	}
+}
+
+// Returns 1 when the state changed, the per call cost only depends on the channels
+// triggered or released, not on the number of channels.
+uint8_t SENSORS_Process(uint32_t u32CurrentTicks) {
+	uint16_t u16PreviousState = g_u16State;
+	uint16_t u16Triggered = TakeTriggered();
+
+	if (u16Triggered != 0) {
+		if (g_u16State == 0) {
+			g_u32NextCheckTick = u32CurrentTicks + INT32_MAX;
+		}
+		g_u16State |= u16Triggered;
+		g_u16Edges |= u16Triggered;
+		for (uint16_t m = u16Triggered; m != 0; m &= m - 1) {
+			uint8_t u8Channel = __builtin_ctz(m);
+			g_au32HoldStartTick[u8Channel] = u32CurrentTicks;
+			uint32_t u32Release = u32CurrentTicks
+					+ g_axChannels[u8Channel].u32HoldMs;
+			if (IsTimeReached(g_u32NextCheckTick, u32Release)) {
+				g_u32NextCheckTick = u32Release;
+			}
+		}
+	}
+
+	if (g_u16State != 0 && IsTimeReached(u32CurrentTicks, g_u32NextCheckTick)) {
+		// Release the channels whose hold time elapsed and whose input is back to the
+		// inactive level, and schedule the next check
+		uint32_t u32NextCheckTick = u32CurrentTicks + SENSOR_POLL_MS;
+		for (uint16_t m = g_u16State; m != 0; m &= m - 1) {
+			uint8_t u8Channel = __builtin_ctz(m);
+			const SensorChannel_t *pxChannel = &g_axChannels[u8Channel];
+			uint32_t u32Release = g_au32HoldStartTick[u8Channel]
+					+ pxChannel->u32HoldMs;
+			if (!IsTimeReached(u32CurrentTicks, u32Release)) {
+				if (IsTimeReached(u32NextCheckTick, u32Release)) {
+					u32NextCheckTick = u32Release;
+				}
+			} else if (HAL_GPIO_ReadPin(pxChannel->pxPort, pxChannel->u16Pin)
+					!= pxChannel->u8ActiveLevel) {
+				ReleaseChannel(u8Channel);
+			}
+		}
+		g_u32NextCheckTick = u32NextCheckTick;
+	}
+
+	return (g_u16State != u16PreviousState) ? 1 : 0;
+}
+
+uint16_t SENSORS_GetState(void) {
+	return g_u16State;
+}
+
+// Channels triggered since the previous call, including the channels already active
+uint16_t SENSORS_TakeEdges(void) {
+	uint16_t u16Edges = g_u16Edges;
+	g_u16Edges = 0;
+	return u16Edges;
+}
+
+SensorKind_t SENSORS_GetKind(uint8_t u8Channel) {
+	return g_axChannels[u8Channel].eKind;
+}
+
+void SENSORS_UpdateOd(void) {
+	uint8_t au8State[OD_CNT_ARR_6000] = { 0 };
+	for (uint16_t m = g_u16State; m != 0; m &= m - 1) {
+		const SensorChannel_t *pxChannel = &g_axChannels[__builtin_ctz(m)];
+		au8State[pxChannel->u8OdSubIndex - 1] |= (1U << pxChannel->u8OdBit);
+	}
+	for (uint8_t i = 0; i < OD_CNT_ARR_6000; i++) {
+		OD_set_u8(OD_ENTRY_H6000, i + 1, au8State[i], false);
+	}
+}
+
+// Copies the trigger counters to 0x2140 and increments the activity sequence (0x2142) when
+// one of them changed. Returns 1 in this case, the activity TPDO has to be sent. The OD is locked
+// so the TPDO, processed from the CANopen timer interrupt, never maps a partial update. The
+// counters are written by the EXTI, they are already copied.
+uint8_t SENSORS_UpdateActivityOd(CO_CANmodule_t *pxCanModule) {
+	uint16_t au16Count[OD_CNT_ARR_2140];
+	uint8_t u8Changed = 0;
+	for (uint8_t i = 0; i < SENSOR_CHANNEL_COUNT; i++) {
+		au16Count[i] = g_au16TriggerCount[i];
+		if (au16Count[i] != g_au16PublishedCount[i]) {
+			g_au16PublishedCount[i] = au16Count[i];
+			u8Changed = 1;
+		}
+	}
+	if (u8Changed == 0) {
+		return 0;
+	}
+
+	CO_LOCK_OD(pxCanModule);
+	for (uint8_t i = 0; i < SENSOR_CHANNEL_COUNT; i++) {
+		OD_RAM.x2140_triggerCount[i] = au16Count[i];
+	}
+	OD_RAM.x2142_activitySequence++;
+	CO_UNLOCK_OD(pxCanModule);
+	return 1;
+}
+
+void SENSORS_OnEdge(uint16_t u16Pin) {
+	// We only read when the sensor is triggered! The state is cleared by SENSORS_Process
+	uint8_t u8Channel = g_au8LineChannel[__builtin_ctz(u16Pin)];
+	if (u8Channel == SENSOR_NO_CHANNEL) {
+		return;
+	}
+
+	uint16_t u16Mask = 1U << u8Channel;
+	uint32_t u32CurrentTicks = HAL_GetTick();
+	if (((g_u16EdgeSeen & u16Mask) != 0)
+			&& (u32CurrentTicks - g_au32EdgeTick[u8Channel]
+					< g_axChannels[u8Channel].u16DebounceMs)) {
+		return;
+	}
+	g_u16EdgeSeen |= u16Mask;
+	g_au32EdgeTick[u8Channel] = u32CurrentTicks;
+	g_au16TriggerCount[u8Channel]++;
+	g_u16Triggered |= u16Mask;
+	if ((g_u16Journaled & u16Mask) == 0) {
+		g_u16Journaled |= u16Mask;
+		JOURNAL_Append(u8Channel, JOURNAL_EVENT_TRIGGER);
+	}
+}
+/************************************************************************************************************
+ * Local functions declaration
+ ************************************************************************************************************/
+// Atomically read and clear the channels triggered from the EXTI interrupt
+static uint16_t TakeTriggered(void) {
+	uint16_t u16Triggered;
+	do {
+		u16Triggered = __LDREXH(&g_u16Triggered);
+	} while (__STREXH(0, &g_u16Triggered) != 0U);
+	return u16Triggered;
+}
+
+static uint8_t IsTimeReached(uint32_t u32CurrentTicks, uint32_t u32Tick) {
+	return ((int32_t) (u32CurrentTicks - u32Tick) >= 0) ? 1 : 0;
+}
+
+// The release is skipped if an edge is pending. The interrupts are masked so that an edge
+// is either taken by the next SENSORS_Process or journaled as a new trigger.
+static void ReleaseChannel(uint8_t u8Channel) {
+	uint16_t u16Mask = 1U << u8Channel;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if ((g_u16Triggered & u16Mask) == 0) {
+		g_u16State &= ~u16Mask;
+		g_u16Journaled &= ~u16Mask;
+		JOURNAL_Append(u8Channel, JOURNAL_EVENT_RELEASE);
+	}
+	__set_PRIMASK(primask);
+}
+
+// Read of 0x2141 (SDO or TPDO): the age is computed when the object is read, so the value
+// sent by the event timer is not the one of the last count update.
+static ODR_t ReadTriggerAge(OD_stream_t *stream, void *buf, OD_size_t count,
+		OD_size_t *countRead) {
+	if (stream == NULL || buf == NULL || countRead == NULL) {
+		return ODR_DEV_INCOMPAT;
+	}
+
+	uint8_t u8Channel = stream->subIndex - 1;
+	if (stream->subIndex != 0 && u8Channel < SENSOR_CHANNEL_COUNT) {
+		uint32_t u32Age = SENSOR_AGE_MAX;
+		uint16_t u16Mask = 1U << u8Channel;
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		if ((g_u16EdgeSeen & u16Mask) != 0) {
+			u32Age = (HAL_GetTick() - g_au32EdgeTick[u8Channel])
+					/ SENSOR_AGE_UNIT_MS;
+		}
+		__set_PRIMASK(primask);
+		OD_RAM.x2141_triggerAge[u8Channel] =
+				(u32Age > SENSOR_AGE_MAX) ? SENSOR_AGE_MAX : u32Age;
+	}
+	return OD_readOriginal(stream, buf, count, countRead);
+}
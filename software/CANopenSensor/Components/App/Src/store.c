@@ -0,0 +1,160 @@
+/**
+ ************************************************************************************************************
+ *  \file               store.c
+ *  \brief              Deferred store of the configuration, coalesces the writes (OD 0x2001)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <stdlib.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+// uShell, the logs of this file are in the STORE category
+#define CLI_LOG_MODULE CLI_LOG_STORE
+#include "sys_command_line.h"
+// CANopen Stack
+#include "CO_app_STM32.h"
+#include "OD.h"
+// App includes
+#include "Inc/store.h"
+/************************************************************************************************************
+ * Local define
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local Types
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local data
+ ************************************************************************************************************/
+// Only used from the main loop (shell, SDO server and APP_ExecFromMainLoop)
+static int32_t (*g_pfCommit)(const void *pvImage) = NULL;
+static const void *g_pvRunning = NULL;
+static uint8_t g_u8Dirty = 0;
+static uint32_t g_u32FirstWriteTick = 0;
+static uint32_t g_u32LastWriteTick = 0;
+static uint8_t g_u8Failures = 0;
+/************************************************************************************************************
+ * Constant local data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Constant exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local macros
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local function prototypes
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+// pfCommit writes an image of the configuration in flash, it returns EXIT_SUCCESS or
+// EXIT_FAILURE. pvRunning is the running configuration, committed by the deferred store.
+void STORE_Init(int32_t (*pfCommit)(const void *pvImage), const void *pvRunning) {
+	g_pfCommit = pfCommit;
+	g_pvRunning = pvRunning;
+	g_u8Dirty = 0;
+	g_u8Failures = 0;
+	OD_RAM.x2001_configurationStore.state = STORE_STATE_COMMITTED;
+}
+
+// Called after each change of the configuration. A change while a commit is already
+// pending restarts the quiet period and is counted as coalesced. It also restarts the
+// retries of a failed commit.
+void STORE_MarkDirty(uint32_t u32CurrentTicks) {
+	g_u8Failures = 0;
+	if (g_u8Dirty) {
+		OD_RAM.x2001_configurationStore.coalescedWrites++;
+	} else {
+		g_u8Dirty = 1;
+		g_u32FirstWriteTick = u32CurrentTicks;
+	}
+	g_u32LastWriteTick = u32CurrentTicks;
+	if (OD_RAM.x2001_configurationStore.state != STORE_STATE_FAILED) {
+		OD_RAM.x2001_configurationStore.state = STORE_STATE_PENDING;
+	}
+}
+
+// Explicit store (shell, 0x1010), done immediately even if nothing is pending
+int32_t STORE_Commit(uint32_t u32CurrentTicks) {
+	if (g_pfCommit == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	if (g_pfCommit(g_pvRunning) != EXIT_SUCCESS) {
+		ERR("Store: commit failed");
+		OD_RAM.x2001_configurationStore.state = STORE_STATE_FAILED;
+		if (g_u8Failures < STORE_MAX_RETRIES) {
+			g_u8Failures++;
+		}
+		// The retry waits again for an idle bus, the backoff counts from this failure
+		g_u8Dirty = 1;
+		g_u32FirstWriteTick = u32CurrentTicks;
+		g_u32LastWriteTick = u32CurrentTicks;
+		return EXIT_FAILURE;
+	}
+
+	g_u8Dirty = 0;
+	g_u8Failures = 0;
+	OD_RAM.x2001_configurationStore.commitCount++;
+	OD_RAM.x2001_configurationStore.state = STORE_STATE_COMMITTED;
+	return EXIT_SUCCESS;
+}
+
+// Stores another image than the running configuration (0x1011 restore). The pending commit
+// is cancelled, it would overwrite the image. A failure leaves the pending state unchanged.
+int32_t STORE_CommitImage(const void *pvImage) {
+	if (g_pfCommit == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	if (g_pfCommit(pvImage) != EXIT_SUCCESS) {
+		ERR("Store: commit failed");
+		return EXIT_FAILURE;
+	}
+
+	g_u8Dirty = 0;
+	g_u8Failures = 0;
+	OD_RAM.x2001_configurationStore.commitCount++;
+	OD_RAM.x2001_configurationStore.state = STORE_STATE_COMMITTED;
+	return EXIT_SUCCESS;
+}
+
+// Commits the pending configuration once the quiet period (0x2001 sub 1) elapsed and the bus
+// is idle, the flash erase stalls the CPU. A quiet period of 0 disables the automatic store.
+// After a failure the delay doubles at each retry (STORE_MAX_RETRY_DELAY_MS at most), so a
+// faulty flash is not erased every quiet period, and the retries stop after STORE_MAX_RETRIES.
+void STORE_Process(uint32_t u32CurrentTicks, uint8_t u8BusIdle) {
+	uint16_t u16QuietMs = OD_RAM.x2001_configurationStore.quietPeriod;
+	if (g_u8Dirty == 0 || u16QuietMs == 0 || g_u8Failures >= STORE_MAX_RETRIES) {
+		return;
+	}
+	uint32_t u32DelayMs = (uint32_t) u16QuietMs << g_u8Failures;
+	if (u32DelayMs > STORE_MAX_RETRY_DELAY_MS) {
+		u32DelayMs = STORE_MAX_RETRY_DELAY_MS;
+	}
+	if ((u32CurrentTicks - g_u32LastWriteTick) < u32DelayMs) {
+		return;
+	}
+	if (u8BusIdle == 0
+			&& (u32CurrentTicks - g_u32FirstWriteTick) < STORE_MAX_DEFER_MS) {
+		return;
+	}
+	STORE_Commit(u32CurrentTicks);
+}
@@ -0,0 +1,347 @@
+/**
+ ************************************************************************************************************
+ *  \file               vibration.c
+ *  \brief              Vibration input conditioning (EXTI masking, hardware pulse counting)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ */
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+// App includes
+#include "Inc/vibration.h"
+/************************************************************************************************************
+ * Local define
+ ************************************************************************************************************/
+// Number of edges kept by the capture DMA for the duty cycle computation
+#define VIBRATION_CAPTURE_DEPTH  (32)
+// TIM2 DMA burst on each rising edge: CCR1 (this rising edge) and CCR2 (the previous falling edge)
+#define VIBRATION_BURST_BASE     (TIM_DMABASE_CCR1)
+#define VIBRATION_BURST_LENGTH   (TIM_DMABURSTLENGTH_2TRANSFERS)
+// Input capture filter: fDTS/32, 8 samples (~5us at 48MHz)
+#define VIBRATION_IC_FILTER      (0x0F)
+// Converts a number of pulses counted over a number of slots to pulses/s
+#define SLOTS_TO_RATE(pulses, slots) (((pulses) * 1000U) / ((slots) * VIBRATION_SLOT_MS))
+/************************************************************************************************************
+ * Local Types
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local data
+ ************************************************************************************************************/
+static TIM_HandleTypeDef *g_pxTimBase;
+static TIM_HandleTypeDef *g_pxTimCounter;
+static DMA_HandleTypeDef g_xDmaCapture;
+// TIM2 captures (1us) written by the DMA on each rising edge: the rising edge, then the falling
+// edge which precedes it
+static uint32_t g_au32Capture[VIBRATION_CAPTURE_DEPTH][2];
+// Window state, only used from the EXTI and TIM2 interrupts (same priority)
+static uint8_t g_u8WindowOpen = 0;
+static uint8_t g_u8WindowChained = 0;
+static uint16_t g_u16CounterStart = 0;
+// Statistics of the last window, written from the TIM2 interrupt
+static volatile uint32_t g_u32Sequence = 0;
+static VibrationStatistics_t g_xStatistics;
+// Last sequence read by the main loop
+static uint32_t g_u32ReadSequence = 0;
+// Features, only used from the main loop
+static uint16_t g_au16SlotCount[VIBRATION_FEATURE_SLOTS];
+static uint32_t g_u32SlotSum = 0;
+static uint8_t g_u8SlotIndex = 0;
+static uint32_t g_u32NextSlotTick = 0;
+static uint16_t g_u16SlotCounterStart = 0;
+static uint16_t g_u16BurstSlots = 0;
+static uint16_t g_u16LastBurstSlots = 0;
+/************************************************************************************************************
+ * Constant local data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Constant exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Exported data
+ ************************************************************************************************************/
+
+/************************************************************************************************************
+ * Local macros
+ ************************************************************************************************************/
+// Next edge pair written by the DMA, a pair being written is not counted
+#define CAPTURE_INDEX(dma)       (((2 * VIBRATION_CAPTURE_DEPTH - __HAL_DMA_GET_COUNTER(dma)) / 2) \
+		% VIBRATION_CAPTURE_DEPTH)
+/************************************************************************************************************
+ * Local function prototypes
+ ************************************************************************************************************/
+static void InitCaptureDma(DMA_HandleTypeDef *pxDma,
+		DMA_Channel_TypeDef *pxChannel, volatile uint32_t *pu32Dmar,
+		uint32_t *pu32Buffer);
+static uint8_t ComputeDutyCycle(uint16_t u16Count);
+static uint8_t CloseSlot(uint16_t u16Count);
+static uint16_t Saturate16(uint32_t u32Value);
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+void VIBRATION_Init(TIM_HandleTypeDef *hTimBase, TIM_HandleTypeDef *hTimCounter) {
+	GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+	TIM_IC_InitTypeDef sConfigIC = { 0 };
+	TIM_OC_InitTypeDef sConfigOC = { 0 };
+
+	g_pxTimBase = hTimBase;
+	g_pxTimCounter = hTimCounter;
+
+	// The pin is switched to TIM2_CH1, the EXTI line configured by MX_GPIO_Init stays active
+	// and only opens the counting windows
+	GPIO_InitStruct.Pin = GPIO_Vibration_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	GPIO_InitStruct.Pull = GPIO_PULLDOWN;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	GPIO_InitStruct.Alternate = GPIO_AF1_TIM2;
+	HAL_GPIO_Init(GPIO_Vibration_GPIO_Port, &GPIO_InitStruct);
+
+	// CH1 captures the rising edges, CH2 the falling edges of the same input. Every CH1
+	// capture pulses TIM2 TRGO which clocks TIM1 (ITR1): the pulses are counted by hardware.
+	// Only CH1 requests the DMA: TIM2_CH2 shares DMA1 channel 7 with USART2_TX, its captures
+	// are read by the burst of the next rising edge.
+	sConfigIC.ICPolarity = TIM_ICPOLARITY_RISING;
+	sConfigIC.ICSelection = TIM_ICSELECTION_DIRECTTI;
+	sConfigIC.ICPrescaler = TIM_ICPSC_DIV1;
+	sConfigIC.ICFilter = VIBRATION_IC_FILTER;
+	if (HAL_TIM_IC_ConfigChannel(hTimBase, &sConfigIC, TIM_CHANNEL_1)
+			!= HAL_OK) {
+		Error_Handler();
+	}
+	sConfigIC.ICPolarity = TIM_ICPOLARITY_FALLING;
+	sConfigIC.ICSelection = TIM_ICSELECTION_INDIRECTTI;
+	if (HAL_TIM_IC_ConfigChannel(hTimBase, &sConfigIC, TIM_CHANNEL_2)
+			!= HAL_OK) {
+		Error_Handler();
+	}
+	// CH3 is the deadline of the counting window
+	sConfigOC.OCMode = TIM_OCMODE_TIMING;
+	sConfigOC.Pulse = 0;
+	sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+	sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+	if (HAL_TIM_OC_ConfigChannel(hTimBase, &sConfigOC, TIM_CHANNEL_3)
+			!= HAL_OK) {
+		Error_Handler();
+	}
+
+	// The captures are copied by the DMA without any interrupt
+	__HAL_RCC_DMA1_CLK_ENABLE();
+	hTimBase->Instance->DCR = VIBRATION_BURST_BASE | VIBRATION_BURST_LENGTH;
+	InitCaptureDma(&g_xDmaCapture, DMA1_Channel5, &hTimBase->Instance->DMAR,
+			&g_au32Capture[0][0]);
+	__HAL_TIM_ENABLE_DMA(hTimBase, TIM_DMA_CC1);
+
+	HAL_TIM_Base_Start(hTimCounter);
+	g_u16CounterStart = __HAL_TIM_GET_COUNTER(hTimCounter);
+	g_u16SlotCounterStart = g_u16CounterStart;
+	g_u32NextSlotTick = HAL_GetTick() + VIBRATION_SLOT_MS;
+	HAL_TIM_IC_Start(hTimBase, TIM_CHANNEL_1);
+	HAL_TIM_IC_Start(hTimBase, TIM_CHANNEL_2);
+}
+
+// Returns 1 when a new window was closed since the previous call
+uint8_t VIBRATION_GetStatistics(VibrationStatistics_t *pxStatistics) {
+	uint32_t u32Sequence;
+	// The writer is an interrupt, it always completes before the main loop resumes
+	do {
+		u32Sequence = g_u32Sequence;
+		__DMB();
+		*pxStatistics = g_xStatistics;
+		__DMB();
+	} while (u32Sequence != g_u32Sequence);
+
+	if (u32Sequence == g_u32ReadSequence) {
+		return 0;
+	}
+	g_u32ReadSequence = u32Sequence;
+	return 1;
+}
+
+// Samples the hardware pulse counter every slot and updates the features
+VibrationFeaturesEvent_t VIBRATION_Process(uint32_t u32CurrentTicks,
+		VibrationFeatures_t *pxFeatures) {
+	VibrationFeaturesEvent_t eResult = VIBRATION_FEATURES_UNCHANGED;
+	uint8_t u8Slots = 0;
+
+	while (((int32_t) (u32CurrentTicks - g_u32NextSlotTick) >= 0)
+			&& (u8Slots < VIBRATION_FEATURE_SLOTS)) {
+		// The first slot gets all the pulses counted since the previous call
+		uint16_t u16Counter = __HAL_TIM_GET_COUNTER(g_pxTimCounter);
+		if (CloseSlot(u16Counter - g_u16SlotCounterStart)) {
+			eResult = VIBRATION_FEATURES_BURST_EDGE;
+		} else if (eResult == VIBRATION_FEATURES_UNCHANGED) {
+			eResult = VIBRATION_FEATURES_UPDATED;
+		}
+		g_u16SlotCounterStart = u16Counter;
+		g_u32NextSlotTick += VIBRATION_SLOT_MS;
+		u8Slots++;
+	}
+	if (u8Slots == VIBRATION_FEATURE_SLOTS) {
+		// The main loop was blocked for a long time, resynchronize the slots
+		g_u32NextSlotTick = u32CurrentTicks + VIBRATION_SLOT_MS;
+	}
+
+	if (eResult != VIBRATION_FEATURES_UNCHANGED) {
+		uint16_t u16PeakCount = 0;
+		for (uint8_t i = 0; i < VIBRATION_FEATURE_SLOTS; i++) {
+			if (g_au16SlotCount[i] > u16PeakCount) {
+				u16PeakCount = g_au16SlotCount[i];
+			}
+		}
+		pxFeatures->u16PulseRate = Saturate16(
+				SLOTS_TO_RATE(g_u32SlotSum, VIBRATION_FEATURE_SLOTS));
+		pxFeatures->u16PeakRate = Saturate16(
+				SLOTS_TO_RATE((uint32_t) u16PeakCount, 1U));
+		pxFeatures->u16BurstLength = Saturate16(
+				(uint32_t) ((g_u16BurstSlots != 0) ?
+						g_u16BurstSlots : g_u16LastBurstSlots)
+						* VIBRATION_SLOT_MS);
+	}
+	return eResult;
+}
+
+void VIBRATION_OnEdge(uint16_t u16Pin) {
+	if ((u16Pin != GPIO_Vibration_Pin) || g_u8WindowOpen) {
+		return;
+	}
+
+	// Mask the EXTI line: until the deadline, the edges are only counted by the timers
+	EXTI->IMR1 &= ~((uint32_t) GPIO_Vibration_Pin);
+	g_u8WindowOpen = 1;
+	g_u8WindowChained = 0;
+	__HAL_TIM_SET_COMPARE(g_pxTimBase, TIM_CHANNEL_3,
+			__HAL_TIM_GET_COUNTER(g_pxTimBase) + VIBRATION_WINDOW_US);
+	__HAL_TIM_CLEAR_FLAG(g_pxTimBase, TIM_FLAG_CC3);
+	__HAL_TIM_ENABLE_IT(g_pxTimBase, TIM_IT_CC3);
+}
+
+// Returns 1 when edges were counted after the one which opened the window
+uint8_t VIBRATION_OnDeadline(TIM_HandleTypeDef *htim) {
+	if ((htim != g_pxTimBase) || (htim->Channel != HAL_TIM_ACTIVE_CHANNEL_3)
+			|| !g_u8WindowOpen) {
+		return 0;
+	}
+
+	// Edges counted since the end of the previous window
+	uint16_t u16CounterEnd = __HAL_TIM_GET_COUNTER(g_pxTimCounter);
+	uint16_t u16Count = u16CounterEnd - g_u16CounterStart;
+
+	g_xStatistics.u16PulseCount = u16Count;
+	g_xStatistics.u8DutyCycle = ComputeDutyCycle(u16Count);
+	__DMB();
+	g_u32Sequence++;
+	g_u16CounterStart = u16CounterEnd;
+
+	uint8_t u8Active = (u16Count > (g_u8WindowChained ? 0 : 1)) ? 1 : 0;
+	if (u8Active) {
+		// Still chattering: chain the next window, the EXTI line stays masked
+		g_u8WindowChained = 1;
+		__HAL_TIM_SET_COMPARE(g_pxTimBase, TIM_CHANNEL_3,
+				__HAL_TIM_GET_COMPARE(g_pxTimBase, TIM_CHANNEL_3)
+						+ VIBRATION_WINDOW_US);
+	} else {
+		__HAL_TIM_DISABLE_IT(g_pxTimBase, TIM_IT_CC3);
+		g_u8WindowOpen = 0;
+		__HAL_GPIO_EXTI_CLEAR_IT(GPIO_Vibration_Pin);
+		EXTI->IMR1 |= (uint32_t) GPIO_Vibration_Pin;
+	}
+	return u8Active;
+}
+/************************************************************************************************************
+ * Local functions declaration
+ ************************************************************************************************************/
+static void InitCaptureDma(DMA_HandleTypeDef *pxDma,
+		DMA_Channel_TypeDef *pxChannel, volatile uint32_t *pu32Dmar,
+		uint32_t *pu32Buffer) {
+	// MX_DMA_Init and the UART DMA run before: a configured channel belongs to another request
+	if (pxChannel->CCR != 0) {
+		Error_Handler();
+	}
+	pxDma->Instance = pxChannel;
+	pxDma->Init.Request = DMA_REQUEST_4;
+	pxDma->Init.Direction = DMA_PERIPH_TO_MEMORY;
+	pxDma->Init.PeriphInc = DMA_PINC_DISABLE;
+	pxDma->Init.MemInc = DMA_MINC_ENABLE;
+	pxDma->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+	pxDma->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+	pxDma->Init.Mode = DMA_CIRCULAR;
+	pxDma->Init.Priority = DMA_PRIORITY_LOW;
+	if (HAL_DMA_Init(pxDma) != HAL_OK) {
+		Error_Handler();
+	}
+	if (HAL_DMA_Start(pxDma, (uint32_t) pu32Dmar, (uint32_t) pu32Buffer,
+			2 * VIBRATION_CAPTURE_DEPTH) != HAL_OK) {
+		Error_Handler();
+	}
+}
+
+// Pushes the pulses counted during a slot, returns 1 when a burst started or ended
+static uint8_t CloseSlot(uint16_t u16Count) {
+	uint8_t u8Edge = 0;
+
+	g_u32SlotSum -= g_au16SlotCount[g_u8SlotIndex];
+	g_au16SlotCount[g_u8SlotIndex] = u16Count;
+	g_u32SlotSum += u16Count;
+	g_u8SlotIndex = (g_u8SlotIndex + 1) % VIBRATION_FEATURE_SLOTS;
+
+	if (u16Count != 0) {
+		u8Edge = (g_u16BurstSlots == 0) ? 1 : 0;
+		if (g_u16BurstSlots < UINT16_MAX) {
+			g_u16BurstSlots++;
+		}
+	} else if (g_u16BurstSlots != 0) {
+		g_u16LastBurstSlots = g_u16BurstSlots;
+		g_u16BurstSlots = 0;
+		u8Edge = 1;
+	}
+	return u8Edge;
+}
+
+static uint16_t Saturate16(uint32_t u32Value) {
+	return (u32Value > UINT16_MAX) ? UINT16_MAX : (uint16_t) u32Value;
+}
+
+// High time between the first and the last captured rising edges of the window, over
+// the last VIBRATION_CAPTURE_DEPTH edges when more were counted
+static uint8_t ComputeDutyCycle(uint16_t u16Count) {
+	uint32_t u32Rises =
+			(u16Count < VIBRATION_CAPTURE_DEPTH) ?
+					u16Count : VIBRATION_CAPTURE_DEPTH;
+	if (u32Rises < 2) {
+		return 0;
+	}
+	uint32_t u32Rise = (CAPTURE_INDEX(&g_xDmaCapture) + VIBRATION_CAPTURE_DEPTH
+			- u32Rises) % VIBRATION_CAPTURE_DEPTH;
+	uint32_t u32First = g_au32Capture[u32Rise][0];
+	uint32_t u32Last = u32First;
+	uint32_t u32High = 0;
+
+	for (uint32_t i = 1; i < u32Rises; i++) {
+		uint32_t u32Start = g_au32Capture[u32Rise][0];
+		u32Rise = (u32Rise + 1) % VIBRATION_CAPTURE_DEPTH;
+		u32Last = g_au32Capture[u32Rise][0];
+		// Falling edge captured before this rising edge, it ends the previous pulse unless
+		// it was missed (the capture still holds an older edge)
+		uint32_t u32Fall = g_au32Capture[u32Rise][1];
+		if (((int32_t) (u32Fall - u32Start) > 0)
+				&& (u32Fall - u32Start <= u32Last - u32Start)) {
+			u32High += u32Fall - u32Start;
+		}
+	}
+
+	uint32_t u32Period = u32Last - u32First;
+	if (u32Period == 0) {
+		return 0;
+	}
+	return (uint8_t) ((u32High >= u32Period) ? 100 : (u32High * 100) / u32Period);
+}
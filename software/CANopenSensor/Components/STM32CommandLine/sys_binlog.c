@@ -0,0 +1,34 @@
+/**
+  ******************************************************************************
+  * @file:      sys_binlog.c
+  * @author:    caipiblack
+  * @version:   V1.0
+  * @date:      2024-06-01
+  * @brief:     binary log records, formatted on the host
+  *
+  ******************************************************************************
+  */
+
+#include "main.h"
+#include <unistd.h>
+#include "sys_binlog.h"
+
+_Static_assert(BINLOG_MAX_RECORD - 2 <= 0xFF, "The record length is sent on 1 byte");
+
+/* stdio backend, in sys_command_line.c */
+int _write(int file, char *data, int len);
+
+void binlog_send(uint8_t *buf, uint32_t len, uint32_t site)
+{
+	uint32_t tick = HAL_GetTick();
+
+	buf[0] = BINLOG_SYNC;
+	buf[1] = len - 2;
+	buf[2] = site;
+	buf[3] = site >> 8;
+	memcpy(&buf[4], &tick, sizeof(tick));
+
+	/* Straight to the stdout ring, the record must not be split by the stdio buffer. Sent as stderr
+	 * so that the batch mode never mixes it with the records of a command. */
+	_write(STDERR_FILENO, (char *)buf, len);
+}
@@ -0,0 +1,124 @@
+/**
+  ******************************************************************************
+  * @file:      sys_binlog.h
+  * @author:    caipiblack
+  * @version:   V1.0
+  * @date:      2024-06-01
+  * @brief:     binary log records, formatted on the host
+  *
+  ******************************************************************************
+  */
+
+#ifndef __SYS_BINLOG_H
+#define __SYS_BINLOG_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ *  Record sent on stderr (same UART as stdout), little endian:
+ *      BINLOG_SYNC, length of the rest (1 byte), call site id (2 bytes), HAL tick (4 bytes), arguments
+ *
+ *  The call site id is the offset of "<kind>|<file>|<line>|<format>" in the .logfmt section. This
+ *  section is not loaded in the target, Tools/binlog_decode reads it from the ELF file.
+ *  Arguments: integers on 4 bytes (8 bytes for long long), float and double as float, strings as
+ *  their length (1 byte) followed by their characters. The arguments that do not fit in
+ *  BINLOG_MAX_RECORD are not sent.
+ */
+#define BINLOG_SYNC			0x01				/* never part of the text output */
+#define BINLOG_MAX_RECORD	64
+#define BINLOG_HEADER_LEN	8
+
+#define BINLOG_STRING(s)	#s
+#define BINLOG_XSTRING(s)	BINLOG_STRING(s)
+
+#define BINLOG(kind, fmt, ...)	do {											\
+			static const char binlog_site[]										\
+				__attribute__((section(".logfmt"), used))						\
+				= kind "|" __FILE__ "|" BINLOG_XSTRING(__LINE__) "|" fmt;		\
+			uint8_t binlog_buf[BINLOG_MAX_RECORD];								\
+			uint32_t binlog_len = BINLOG_HEADER_LEN;							\
+			BINLOG_FOR_EACH(BINLOG_ARG, ##__VA_ARGS__)							\
+			binlog_send(binlog_buf, binlog_len, (uint32_t)(uintptr_t)binlog_site);	\
+		} while(0)
+
+#define BINLOG_ARG(x)	binlog_len = _Generic((x) + 0,							\
+			char *: binlog_str,													\
+			const char *: binlog_str,											\
+			float: binlog_float,												\
+			double: binlog_float,												\
+			long long: binlog_u64,												\
+			unsigned long long: binlog_u64,										\
+			default: binlog_u32)(binlog_buf, binlog_len, (x));
+
+/*
+ *  Up to 8 arguments
+ */
+#define BINLOG_NARGS(...)		BINLOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define BINLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...)	n
+#define BINLOG_CONCAT(a, b)		BINLOG_CONCAT_(a, b)
+#define BINLOG_CONCAT_(a, b)	a##b
+#define BINLOG_FOR_EACH(f, ...)	BINLOG_CONCAT(BINLOG_FOR_EACH_, BINLOG_NARGS(__VA_ARGS__))(f, ##__VA_ARGS__)
+#define BINLOG_FOR_EACH_0(f)
+#define BINLOG_FOR_EACH_1(f, a)			f(a)
+#define BINLOG_FOR_EACH_2(f, a, ...)	f(a) BINLOG_FOR_EACH_1(f, __VA_ARGS__)
+#define BINLOG_FOR_EACH_3(f, a, ...)	f(a) BINLOG_FOR_EACH_2(f, __VA_ARGS__)
+#define BINLOG_FOR_EACH_4(f, a, ...)	f(a) BINLOG_FOR_EACH_3(f, __VA_ARGS__)
+#define BINLOG_FOR_EACH_5(f, a, ...)	f(a) BINLOG_FOR_EACH_4(f, __VA_ARGS__)
+#define BINLOG_FOR_EACH_6(f, a, ...)	f(a) BINLOG_FOR_EACH_5(f, __VA_ARGS__)
+#define BINLOG_FOR_EACH_7(f, a, ...)	f(a) BINLOG_FOR_EACH_6(f, __VA_ARGS__)
+#define BINLOG_FOR_EACH_8(f, a, ...)	f(a) BINLOG_FOR_EACH_7(f, __VA_ARGS__)
+
+/**
+  * @brief          fills the header and sends a record
+  * @param  buf:    record, the arguments start at BINLOG_HEADER_LEN
+  * @param  len:    length of the record
+  * @param  site:   address of the call site description in .logfmt
+  * @retval         null
+  */
+void binlog_send(uint8_t *buf, uint32_t len, uint32_t site);
+
+/*
+ *  Argument encoders, they return the new length of the record. An argument that does not fit
+ *  fills the record so that the following ones are not sent either.
+ */
+static inline uint32_t binlog_u32(uint8_t *buf, uint32_t len, uint32_t value)
+{
+	if(len + sizeof(value) > BINLOG_MAX_RECORD){
+		return BINLOG_MAX_RECORD;
+	}
+	memcpy(&buf[len], &value, sizeof(value));
+	return len + sizeof(value);
+}
+
+static inline uint32_t binlog_u64(uint8_t *buf, uint32_t len, uint64_t value)
+{
+	if(len + sizeof(value) > BINLOG_MAX_RECORD){
+		return BINLOG_MAX_RECORD;
+	}
+	memcpy(&buf[len], &value, sizeof(value));
+	return len + sizeof(value);
+}
+
+static inline uint32_t binlog_float(uint8_t *buf, uint32_t len, float value)
+{
+	if(len + sizeof(value) > BINLOG_MAX_RECORD){
+		return BINLOG_MAX_RECORD;
+	}
+	memcpy(&buf[len], &value, sizeof(value));
+	return len + sizeof(value);
+}
+
+/* The string is cut to the room left in the record */
+static inline uint32_t binlog_str(uint8_t *buf, uint32_t len, const char *value)
+{
+	if(len + 1 > BINLOG_MAX_RECORD){
+		return BINLOG_MAX_RECORD;
+	}
+	uint32_t n = strnlen(value, BINLOG_MAX_RECORD - len - 1);
+	buf[len] = n;
+	memcpy(&buf[len + 1], value, n);
+	return len + 1 + n;
+}
+
+#endif /* __SYS_BINLOG_H */
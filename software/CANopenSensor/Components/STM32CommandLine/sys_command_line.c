@@ -16,6 +16,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include "sys_command_line.h"
 
 /*******************************************************************************
@@ -33,15 +34,6 @@ typedef struct {
     uint8_t len;
 } HANDLE_TYPE_S;
 
-/*
- * Command entry
- */
-typedef struct {
-    const char *pCmd;
-    const char *pHelp;
-    uint8_t (*pFun)(int argc, char *argv[]);
-} COMMAND_S;
-
 /*
  * Command line history
  */
@@ -58,37 +50,102 @@ typedef struct {
  *
  ******************************************************************************/
 
-unsigned char 			cBuffer;
-shell_queue_s 			cli_rx_buff; 				/* 64 bytes FIFO, saving commands from the terminal */
 UART_HandleTypeDef 		*huart_shell;
-COMMAND_S				CLI_commands[MAX_COMMAND_NB];
 static HISTORY_S 		history;
 char *cli_logs_names[] = {"SHELL",
 #ifdef CLI_ADDITIONAL_LOG_CATEGORIES
-#define X(name, b) #name,
+#define X(name, level) #name,
 		CLI_ADDITIONAL_LOG_CATEGORIES
 #undef X
 #endif
 };
 
-uint32_t cli_log_stat = 0
+uint8_t cli_log_levels[CLI_LAST_LOG_CATEGORY] = {CLI_LEVEL_WARN,
 #ifdef CLI_ADDITIONAL_LOG_CATEGORIES
-#define X(name, b) | (b<<CLI_LOG_##name)
+#define X(name, level) level,
 		CLI_ADDITIONAL_LOG_CATEGORIES
 #undef X
 #endif
-;
+};
+const char				*cli_level_names[]			= {"off", "error", "warn", "info", "debug"};
 
 const char 				cli_help_help[] 			= "show commands";
 const char 				cli_clear_help[] 			= "clear the screen";
 const char 				cli_reset_help[] 			= "reboot MCU";
 const char				cli_log_help[]				= "Controls which logs are displayed."
-													  "\n\t\"log show\" to show which logs are enabled"
+													  "\n\t\"log show\" to show the level of each category"
 													  "\n\t\"log on/off all\" to enable/disable all logs"
-													  "\n\t\"log on/off [CAT1 CAT2 CAT...]\" to enable/disable the logs for categories [CAT1 CAT2 CAT...]";
+													  "\n\t\"log on/off [CAT1 CAT2 CAT...]\" to enable/disable the logs for categories [CAT1 CAT2 CAT...]"
+													  "\n\t\"log level off/error/warn/info/debug all\" to set the level of all categories"
+													  "\n\t\"log level off/error/warn/info/debug [CAT1 CAT2 CAT...]\" to set the level of categories [CAT1 CAT2 CAT...]";
+const char				cli_stdin_help[]			= "Shows the stdin ring statistics."
+													  "\n\t\"stdin\" to show the unread, lost and received bytes"
+													  "\n\t\"stdin reset\" to reset the counters";
+const char				cli_batch_help[]			= "Non-interactive mode for test fixtures: no echo, no history, no colours."
+													  "\n\t\"batch on\" to enter the batch mode"
+													  "\n\tthen one command per line: \"<seq> <command> [args]\", <seq> is a decimal number"
+													  "\n\t\".<seq> <text>\" for each output line of the command"
+													  "\n\t\"=<seq> <returned value>\" when the command is done"
+													  "\n\t\"!<seq> unknown/length/args/syntax\" when the command is not run"
+													  "\n\t\"<seq> batch off\" to leave the batch mode";
+const char				cli_stdout_help[]			= "Shows the stdout ring statistics."
+													  "\n\t\"stdout\" to show the fill level and the dropped bytes"
+													  "\n\t\"stdout reset\" to reset the counters";
 bool 					cli_password_ok 			= false;
-volatile bool			cli_tx_isr_flag				= false; /*< This flag is used internally so that _write will not write text in the console if the previous call is not over yet */
 uint8_t					shell_USART_IRQn			= 0;
+
+/*
+ * stdout ring. head and tail are free running, head is reserved by the writers (any context) with
+ * LDREX/STREX, tail is moved by the end of the DMA transfers. The DMA only starts when no write
+ * is in progress, so that it never sends a reserved but not yet copied area.
+ */
+static uint8_t			cli_tx_ring[CLI_TX_RING_SIZE];
+static volatile uint32_t cli_tx_head				= 0;
+static volatile uint32_t cli_tx_tail				= 0;
+static volatile uint32_t cli_tx_writers				= 0;		/*< writes in progress */
+static volatile uint32_t cli_tx_busy				= 0;		/*< owner of the DMA, set during a transfer */
+static volatile uint32_t cli_tx_inflight			= 0;		/*< bytes of the current transfer */
+static volatile bool	cli_tx_wait					= false;	/*< the output of a shell command waits for room */
+volatile cli_tx_stats_s	cli_tx_stats				= {0};
+
+/*
+ * Batch mode, only used from the main loop. The output of the running command is sent as records,
+ * everything else (logs, interrupts) is dropped.
+ */
+static bool				cli_batch					= false;
+static const char		*cli_batch_seq				= NULL;		/*< sequence number of the running command */
+static bool				cli_batch_bol				= true;		/*< the output is at the beginning of a line */
+static uint8_t			cli_batch_esc				= 0;		/*< position in a VT100 sequence, 0 outside */
+
+/*
+ * Stream mode, see cli_stream_start
+ */
+static size_t			(*cli_stream_rx)(const uint8_t *data, size_t len) = NULL;
+static void				(*cli_stream_stop)(void)	= NULL;
+static bool				cli_stream_exit				= true;		/*< CLI_STREAM_EXIT ends the stream */
+
+_Static_assert((CLI_TX_RING_SIZE & (CLI_TX_RING_SIZE - 1)) == 0, "CLI_TX_RING_SIZE must be a power of 2");
+
+/*
+ * stdin ring, written by the UART RX DMA in circular mode. The DMA events (half transfer, transfer
+ * complete, idle line) only move head, the main loop reads the bytes in place. head and tail are
+ * free running, head & (CLI_RX_RING_SIZE - 1) is the position of the DMA at the last event.
+ *
+ * Burst limit: the DMA may be up to half a ring past head, so only CLI_RX_RING_SIZE / 2 unread
+ * bytes (1024 with 2048) are safe. A burst is lossless as long as the main loop reads the ring
+ * before that many bytes are received: 88 ms at 115200 baud, 10 ms at 1 Mbaud. Beyond, the oldest
+ * bytes are counted as lost ("stdin" command). A longer stall needs a larger ring, the DMA counter
+ * allows up to 32 KiB.
+ */
+static uint8_t			cli_rx_ring[CLI_RX_RING_SIZE];
+static volatile uint32_t cli_rx_head				= 0;
+static uint32_t			cli_rx_tail					= 0;		/*< only used by the main loop */
+static volatile bool	cli_rx_running				= false;	/*< cleared when an error stops the DMA */
+static bool				cli_rx_cr					= false;	/*< the last byte read was a '\r' */
+volatile cli_rx_stats_s	cli_rx_stats				= {0};
+
+_Static_assert((CLI_RX_RING_SIZE & (CLI_RX_RING_SIZE - 1)) == 0, "CLI_RX_RING_SIZE must be a power of 2");
+_Static_assert(CLI_RX_RING_SIZE <= 0xFFFF, "CLI_RX_RING_SIZE is limited by the DMA counter");
 /*******************************************************************************
  *
  * 	Internal functions declaration
@@ -97,17 +154,49 @@ uint8_t					shell_USART_IRQn			= 0;
 
 static void 	cli_history_add				(char* buff);
 static uint8_t 	cli_history_show			(uint8_t mode, char** p_history);
-void 			HAL_UART_RxCpltCallback		(UART_HandleTypeDef * huart);
-static void 	cli_rx_handle				(shell_queue_s *rx_buff);
+static void 	cli_rx_handle				(void);
+static void		cli_rx_start				(void);
+static void		cli_rx_advance				(uint32_t pos);
+static bool		cli_rx_getc					(uint8_t *c);
+static uint32_t	cli_rx_peek					(const uint8_t **data);
+static void		cli_stream_handle			(void);
+static void		cli_complete				(HANDLE_TYPE_S *handle, uint8_t *echoed);
+static size_t	cli_lower_bound				(const char *prefix, size_t len);
+static const COMMAND_S *cli_find_command	(const char *command);
+static void		cli_batch_handle			(void);
+static void		cli_batch_exec				(char *line, bool overflow);
+static void		cli_batch_output			(const char *data, uint32_t len);
+static void		cli_batch_record			(const char *fmt, ...);
 static void 	cli_tx_handle				(void);
+static void		cli_tx_send					(const char *data, uint32_t len);
+static bool		cli_tx_can_wait				(void);
+static uint32_t	cli_tx_push					(const char *data, uint32_t len, bool partial);
+static void		cli_tx_kick					(void);
+static uint32_t	cli_atomic_add				(volatile uint32_t *value, uint32_t add);
 uint8_t 		cli_help					(int argc, char *argv[]);
 uint8_t 		cli_clear					(int argc, char *argv[]);
 uint8_t 		cli_reset					(int argc, char *argv[]);
 uint8_t 		cli_log						(int argc, char *argv[]);
-void 			cli_add_command				(const char *command, const char *help, uint8_t (*exec)(int argc, char *argv[]));
+uint8_t 		cli_stdout					(int argc, char *argv[]);
+uint8_t 		cli_stdin					(int argc, char *argv[]);
+uint8_t 		cli_batch_cmd				(int argc, char *argv[]);
 void 			__attribute__((weak)) greet	(void);
-void 			cli_disable_log_entry		(char *str);
-void 			cli_enable_log_entry		(char *str);
+static bool		cli_set_log_entry			(char *str, uint8_t level);
+
+/*
+ * Command table, sorted by name by the linker (.cli_commands in the linker script)
+ */
+extern const COMMAND_S	__cli_commands_start[];
+extern const COMMAND_S	__cli_commands_end[];
+#define CLI_COMMANDS_NB	((size_t)(__cli_commands_end - __cli_commands_start))
+
+CLI_COMMAND("help", cli_help_help, cli_help);
+CLI_COMMAND("cls", cli_clear_help, cli_clear);
+CLI_COMMAND("reset", cli_reset_help, cli_reset);
+CLI_COMMAND("log", cli_log_help, cli_log);
+CLI_COMMAND("stdout", cli_stdout_help, cli_stdout);
+CLI_COMMAND("stdin", cli_stdin_help, cli_stdin);
+CLI_COMMAND("batch", cli_batch_help, cli_batch_cmd);
 
 /*******************************************************************************
  *
@@ -126,38 +215,31 @@ int _write(int file, char *data, int len){
 		return len;
 	}
 
-	HAL_StatusTypeDef status = HAL_OK;
-
-	if (!(SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) ) {
-		cli_tx_isr_flag = true;
-		/* Disable interrupts to prevent UART from throwing an RX interrupt while the peripheral is locked as
-		 * this would prevent the RX interrupt from restarting HAL_UART_Receive_IT  */
-		HAL_NVIC_DisableIRQ(shell_USART_IRQn);
-
-		/* Transmits with interrupts. This must be done this way so that we can re-activate USART interrupts
-		 * before the transfer terminates so that we can continue reading from the terminal*/
-		status = HAL_UART_Transmit_IT(huart_shell, (uint8_t *)data, len);
-
-		HAL_NVIC_EnableIRQ(shell_USART_IRQn);
+	/* Only cli_stream_write is sent in stream mode */
+	if(cli_stream_rx != NULL){
+		return len;
+	}
 
-		/* Wait for the transfer to terminate*/
-		while(cli_tx_isr_flag == true){
-			/* flag will be set to false in HAL_UART_TxCpltCallback*/
+	if(cli_batch){
+		if((file == STDOUT_FILENO) && (cli_batch_seq != NULL) && cli_tx_can_wait()){
+			cli_batch_output(data, len);
 		}
-	}else{
-		/* We are called from an interrupt, using Transmit_IT would not work */
-		HAL_NVIC_DisableIRQ(shell_USART_IRQn);
-		status = HAL_UART_Transmit(huart_shell, (uint8_t *)data, len, 1000);
-		HAL_NVIC_EnableIRQ(shell_USART_IRQn);
+		return len;
 	}
 
-
-
-	if(status == HAL_OK){
-		return len;
+	/* The text is copied in the stdout ring and sent by the UART DMA, _write never waits for the UART.
+	 * Only the output of a shell command, in the main loop, waits for room in the ring: the user asked
+	 * for it. Everything else (DBG, LOG, interrupts) follows CLI_TX_POLICY when the ring is full. */
+	if(cli_tx_wait && cli_tx_can_wait()){
+		cli_tx_send(data, len);
 	}else{
-		return 0;
+		uint32_t queued = cli_tx_push(data, len, CLI_TX_POLICY == CLI_TX_TRUNCATE);
+		if(queued < (uint32_t)len){
+			cli_atomic_add(&cli_tx_stats.dropped, len - queued);
+		}
 	}
+
+	return len;
 }
 
 __attribute__((weak)) int _isatty(int file){
@@ -265,48 +347,73 @@ void cli_init(UART_HandleTypeDef *handle_uart, uint8_t USART_IRQn)
 {
 	huart_shell = handle_uart;
 	shell_USART_IRQn  = USART_IRQn;
-	shell_queue_init(&cli_rx_buff);
     memset((uint8_t *)&history, 0, sizeof(history));
 
     HAL_UART_MspInit(huart_shell);
-    HAL_UART_Receive_IT(huart_shell, &cBuffer, 1);
+    cli_rx_start();
 
-    for(size_t j = 0; j < MAX_COMMAND_NB; j++){
-    	CLI_commands[j].pCmd = "";
-    	CLI_commands[j].pFun = NULL;
+    /* Two commands with the same name are both linked, only one of them can be called */
+    for(size_t j = 1; j < CLI_COMMANDS_NB; j++){
+    	if(strcmp(__cli_commands_start[j - 1].pCmd, __cli_commands_start[j].pCmd) >= 0){
+    		ERR("Command %s is registered twice.\n", __cli_commands_start[j].pCmd);
+    	}
     }
 
 #ifndef CLI_PASSWORD
     cli_password_ok = true;
-    greet();
+#if CLI_GREET_ON_INIT
+    cli_greet();
+#endif
 #endif
-
-    CLI_ADD_CMD("help", cli_help_help, cli_help);
-    CLI_ADD_CMD("cls", cli_clear_help, cli_clear);
-    CLI_ADD_CMD("reset", cli_reset_help, cli_reset);
-    CLI_ADD_CMD("log", cli_log_help, cli_log);
-
-    if(CLI_LAST_LOG_CATEGORY > 32){
-    	ERR("Too many log categories defined. The max number of log categories that can be user defined is 31.\n");
-    }
 
     LOG(CLI_LOG_SHELL, "Command line successfully initialized.\n");
 
 }
 
 /*
- * Callback function for UART IRQ when it is done receiving a char
+ * Callback function for UART IRQ on a reception event: half or full ring received by the DMA, or
+ * idle line. Size is the position of the DMA in the ring.
  */
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef * huart){
-	shell_queue_in(&cli_rx_buff, &cBuffer);
-	HAL_UART_Receive_IT(huart, &cBuffer, 1);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size){
+	if(huart != huart_shell){
+		return;
+	}
+	cli_rx_advance(Size);
 }
 
 /*
  * Callback function for UART IRQ when it is done transmitting data
  */
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef * huart){
-	cli_tx_isr_flag = false;
+	if(huart != huart_shell){
+		return;
+	}
+	cli_tx_tail += cli_tx_inflight;
+	cli_tx_inflight = 0;
+	__DMB();
+	cli_tx_busy = 0;
+	cli_tx_kick();
+}
+
+/*
+ * Callback function for UART IRQ on error. Every reception error stops the RX DMA: the bytes
+ * received before are kept and cli_rx_handle restarts the reception once they are read. A TX DMA
+ * error ends the transfer, its bytes are lost.
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef * huart){
+	if(huart != huart_shell){
+		return;
+	}
+	if(cli_rx_running && (huart->RxState == HAL_UART_STATE_READY)){
+		cli_rx_advance(CLI_RX_RING_SIZE - __HAL_DMA_GET_COUNTER(huart->hdmarx));
+		cli_rx_running = false;
+		cli_rx_stats.errors++;
+	}
+	if((huart->ErrorCode & HAL_UART_ERROR_DMA) && (huart->gState == HAL_UART_STATE_READY)
+			&& (cli_tx_inflight != 0)){
+		cli_atomic_add(&cli_tx_stats.dropped, cli_tx_inflight);
+		HAL_UART_TxCpltCallback(huart);
+	}
 }
 
 /**
@@ -314,13 +421,21 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef * huart){
   * @param  commands
   * @retval null
   */
-static void cli_rx_handle(shell_queue_s *rx_buff)
+static void cli_rx_handle(void)
 {
     static HANDLE_TYPE_S Handle = {.len = 0, .buff = {0}};
     uint8_t i = Handle.len;
-    uint8_t cmd_match = false;
     uint8_t exec_req = false;
 
+    if(cli_stream_rx != NULL){
+    	cli_stream_handle();
+    	return;
+    }
+    if(cli_batch){
+    	cli_batch_handle();
+    	return;
+    }
+
     /*  ---------------------------------------
         Step1: save chars from the terminal
         ---------------------------------------
@@ -328,7 +443,8 @@ static void cli_rx_handle(shell_queue_s *rx_buff)
     bool newChar = true;
     while(newChar) {
         if(Handle.len < MAX_LINE_LEN) {  /* check the buffer */
-        	newChar = shell_queue_out(rx_buff, Handle.buff+Handle.len);
+        	/* One line at a time, the next ones stay in the stdin ring until this one is executed */
+        	newChar = !exec_req && cli_rx_getc(Handle.buff+Handle.len);
 
             /* new char coming from the terminal, copy it to Handle.buff */
             if(newChar) {
@@ -346,6 +462,10 @@ static void cli_rx_handle(shell_queue_s *rx_buff)
                 } else if(Handle.buff[Handle.len] == KEY_ENTER){
                 	exec_req = true;
                 	Handle.len++;
+                } else if(Handle.buff[Handle.len] == KEY_TAB){
+                	if(cli_password_ok){
+                		cli_complete(&Handle, &i);
+                	}
                 }else if(strstr((const char *)Handle.buff, KEY_DELETE) != NULL){
                 	strcpy((char *)&Handle.buff[Handle.len-3], (char *)&Handle.buff[Handle.len+1]);
                 	Handle.len -= 3;
@@ -417,12 +537,12 @@ static void cli_rx_handle(shell_queue_s *rx_buff)
     	Handle.buff[Handle.len-1] = '\0';
     	if(strcmp((char *)Handle.buff, XSTRING(CLI_PASSWORD)) == 0){
     		cli_password_ok = true;
-    		greet();
+    		cli_greet();
     	}
     	Handle.len = 0;
 #else
     	cli_password_ok = true;
-    	greet();
+    	cli_greet();
 #endif
     }else if(exec_req && (Handle.len == 1)) {
         /* KEY_ENTER -->ENTER key from terminal */
@@ -435,46 +555,43 @@ static void cli_rx_handle(shell_queue_s *rx_buff)
 		char *command = strtok((char *)Handle.buff, " \t");
 
 		/* looking for a match */
-		for(i = 0; i < MAX_COMMAND_NB; i++) {
-			if(0 == strcmp(command, CLI_commands[i].pCmd)) {
-				cmd_match = true;
-
-				//Split arguments string to argc/argv
-				uint8_t argc = 1;
-				char 	*argv[MAX_ARGC];
-				argv[0] = command;
-
-				char *token = strtok(NULL, " \t");
-				while(token != NULL){
-					if(argc >= MAX_ARGC){
-						printf(CLI_FONT_RED "Maximum number of arguments is %d. Ignoring the rest of the arguments."CLI_FONT_DEFAULT, MAX_ARGC-1);NL1();
-						break;
-					}
-					argv[argc] = token;
-					argc++;
-					token = strtok(NULL, " \t");
-				}
-
-				if(CLI_commands[i].pFun != NULL) {
-					/* call the func. */
-					TERMINAL_HIDE_CURSOR();
-					uint8_t result = CLI_commands[i].pFun(argc, argv);
-
-					if(result == EXIT_SUCCESS){
-						printf(CLI_FONT_GREEN "(%s returned %d)" CLI_FONT_DEFAULT, command, result);NL1();
-					}else{
-						printf(CLI_FONT_RED "(%s returned %d)" CLI_FONT_DEFAULT, command, result);NL1();
-					}
-					TERMINAL_SHOW_CURSOR();
+		const COMMAND_S *entry = cli_find_command(command);
+		if(entry != NULL) {
+			//Split arguments string to argc/argv
+			uint8_t argc = 1;
+			char 	*argv[MAX_ARGC];
+			argv[0] = command;
+
+			char *token = strtok(NULL, " \t");
+			while(token != NULL){
+				if(argc >= MAX_ARGC){
+					printf(CLI_FONT_RED "Maximum number of arguments is %d. Ignoring the rest of the arguments."CLI_FONT_DEFAULT, MAX_ARGC-1);NL1();
 					break;
-				} else {
-					/* func. is void */
-					printf(CLI_FONT_RED "Command %s exists but no function is associated to it.", command);NL1();
 				}
+				argv[argc] = token;
+				argc++;
+				token = strtok(NULL, " \t");
 			}
-		}
 
-		if(!cmd_match) {
+			if(entry->pFun != NULL) {
+				/* call the func. */
+				TERMINAL_HIDE_CURSOR();
+				cli_tx_wait = true;
+				uint8_t result = entry->pFun(argc, argv);
+
+				if(result == EXIT_SUCCESS){
+					printf(CLI_FONT_GREEN "(%s returned %d)" CLI_FONT_DEFAULT, command, result);NL1();
+				}else{
+					printf(CLI_FONT_RED "(%s returned %d)" CLI_FONT_DEFAULT, command, result);NL1();
+				}
+				TERMINAL_SHOW_CURSOR();
+				fflush(stdout);
+				cli_tx_wait = false;
+			} else {
+				/* func. is void */
+				printf(CLI_FONT_RED "Command %s exists but no function is associated to it.", command);NL1();
+			}
+		} else {
 			/* no matching command */
 			printf("\r\nCommand \"%s\" unknown, try: help", Handle.buff);NL1();
 		}
@@ -495,21 +612,567 @@ static void cli_rx_handle(shell_queue_s *rx_buff)
 
 
 /**
-  * @brief  tx handle, flushes stdout buffer
+  * @brief  starts the RX DMA at the beginning of the stdin ring, the unread bytes must have been read
+  * @param  null
+  * @retval null
+  */
+static void cli_rx_start(void)
+{
+	/* The channel is still running if a TX DMA error stopped the reception */
+	HAL_DMA_Abort(huart_shell->hdmarx);
+
+	cli_rx_head = (cli_rx_head + CLI_RX_RING_SIZE - 1) & ~(CLI_RX_RING_SIZE - 1);
+	cli_rx_tail = cli_rx_head;
+	cli_rx_running = true;
+	if(HAL_UARTEx_ReceiveToIdle_DMA(huart_shell, cli_rx_ring, CLI_RX_RING_SIZE) != HAL_OK){
+		/* Retried by cli_run */
+		cli_rx_running = false;
+	}
+}
+
+/**
+  * @brief          moves the head of the stdin ring to the position of the DMA, from the UART interrupts
+  * @param  pos:    position of the DMA in the ring, CLI_RX_RING_SIZE at the end of the ring
+  * @retval         null
+  */
+static void cli_rx_advance(uint32_t pos)
+{
+	/* The DMA never moves a full ring between two events, there is one every half ring */
+	uint32_t n = (pos - cli_rx_head) & (CLI_RX_RING_SIZE - 1);
+	cli_rx_head += n;
+	cli_rx_stats.received += n;
+}
+
+/**
+  * @brief          gives the unread bytes of the stdin ring, in place
+  * @param  data:   first unread byte
+  * @retval         number of contiguous unread bytes, up to the end of the ring
+  */
+static uint32_t cli_rx_peek(const uint8_t **data)
+{
+	uint32_t head = cli_rx_head;
+	uint32_t fill = head - cli_rx_tail;
+
+	/* The DMA may be up to half a ring past head, older bytes may have been overwritten */
+	if(fill > CLI_RX_RING_SIZE / 2){
+		cli_rx_stats.lost += fill - CLI_RX_RING_SIZE / 2;
+		cli_rx_tail = head - CLI_RX_RING_SIZE / 2;
+		fill = CLI_RX_RING_SIZE / 2;
+	}
+	if(fill > cli_rx_stats.max_fill){
+		cli_rx_stats.max_fill = fill;
+	}
+	if(fill == 0){
+		if(!cli_rx_running){
+			cli_rx_start();
+		}
+		return 0;
+	}
+
+	uint32_t start = cli_rx_tail & (CLI_RX_RING_SIZE - 1);
+	*data = &cli_rx_ring[start];
+	return (fill < CLI_RX_RING_SIZE - start) ? fill : CLI_RX_RING_SIZE - start;
+}
+
+/**
+  * @brief          reads a byte from the stdin ring, "\r\n" and "\n" are read as KEY_ENTER
+  * @param  c:      byte read
+  * @retval         TRUE if a byte was read
+  */
+static bool cli_rx_getc(uint8_t *c)
+{
+	for(;;){
+		const uint8_t *data;
+		if(cli_rx_peek(&data) == 0){
+			return false;
+		}
+
+		uint8_t byte = *data;
+		cli_rx_tail++;
+
+		bool after_cr = cli_rx_cr;
+		cli_rx_cr = (byte == '\r');
+		if(byte == '\n'){
+			if(after_cr){
+				continue;
+			}
+			byte = KEY_ENTER;
+		}
+		*c = byte;
+		return true;
+	}
+}
+
+/**
+  * @brief          completes the command name with the tab key
+  * @param  handle: current line, the tab key is at handle->len and is not kept
+  * @param  echoed: number of chars of the line already displayed
+  * @retval         null
+  */
+static void cli_complete(HANDLE_TYPE_S *handle, uint8_t *echoed)
+{
+	/* Only the command name is completed */
+	if(memchr(handle->buff, ' ', handle->len) != NULL){
+		return;
+	}
+
+	size_t first = cli_lower_bound((const char *)handle->buff, handle->len);
+	size_t last = first;
+	while((last < CLI_COMMANDS_NB)
+			&& (strncmp(__cli_commands_start[last].pCmd, (const char *)handle->buff, handle->len) == 0)){
+		last++;
+	}
+	if(first == last){
+		return;
+	}
+
+	/* Longest prefix shared by the matching commands, followed by a space if there is only one */
+	const char *cmd = __cli_commands_start[first].pCmd;
+	size_t common = strlen(cmd);
+	for(size_t j = first + 1; j < last; j++){
+		size_t k = handle->len;
+		while((k < common) && (__cli_commands_start[j].pCmd[k] == cmd[k])){
+			k++;
+		}
+		common = k;
+	}
+	size_t add = common - handle->len + ((last - first == 1) ? 1 : 0);
+	if(handle->len + add >= MAX_LINE_LEN){
+		return;
+	}
+
+	if(add != 0){
+		/* Displayed by cli_rx_handle with the other new chars */
+		memcpy(&handle->buff[handle->len], &cmd[handle->len], common - handle->len);
+		handle->len = common;
+		if(last - first == 1){
+			handle->buff[handle->len++] = ' ';
+		}
+	}else{
+		/* Nothing to add, the candidates are listed and the line is displayed again */
+		NL1();
+		for(size_t j = first; j < last; j++){
+			printf("%s  ", __cli_commands_start[j].pCmd);
+		}
+		PRINT_CLI_NAME();
+		printf("%.*s", handle->len, handle->buff);
+		*echoed = handle->len;
+	}
+}
+
+/**
+  * @brief          index of the first command that is not sorted before a prefix
+  * @param  prefix: beginning of the command name
+  * @param  len:    length of the prefix, strlen + 1 for a full name
+  * @retval         index in the command table, CLI_COMMANDS_NB if there is none
+  */
+static size_t cli_lower_bound(const char *prefix, size_t len)
+{
+	size_t low = 0;
+	size_t high = CLI_COMMANDS_NB;
+	while(low < high){
+		size_t mid = (low + high) / 2;
+		if(strncmp(__cli_commands_start[mid].pCmd, prefix, len) < 0){
+			low = mid + 1;
+		}else{
+			high = mid;
+		}
+	}
+	return low;
+}
+
+/**
+  * @brief          finds a command by name
+  * @param  command: command name
+  * @retval         command entry, NULL if it does not exist
+  */
+static const COMMAND_S *cli_find_command(const char *command)
+{
+	if(command == NULL){
+		return NULL;
+	}
+	size_t i = cli_lower_bound(command, strlen(command) + 1);
+	if((i < CLI_COMMANDS_NB) && (strcmp(__cli_commands_start[i].pCmd, command) == 0)){
+		return &__cli_commands_start[i];
+	}
+	return NULL;
+}
+
+/**
+  * @brief  gives the received bytes to the stream handler, in place, until CLI_STREAM_EXIT
+  * @param  null
+  * @retval null
+  */
+static void cli_stream_handle(void)
+{
+	const uint8_t *data;
+	uint32_t len;
+
+	while(cli_stream_rx != NULL && (len = cli_rx_peek(&data)) != 0){
+		const uint8_t *exit = cli_stream_exit ? memchr(data, CLI_STREAM_EXIT, len) : NULL;
+		uint32_t n = (exit != NULL) ? (uint32_t)(exit - data) : len;
+		uint32_t done = cli_stream_rx(data, n);
+		cli_rx_tail += done;
+		if(done < n){
+			/* The handler is full, the rest waits in the stdin ring */
+			return;
+		}
+		if(exit != NULL){
+			cli_rx_tail++;
+			cli_stream_end();
+		}
+	}
+}
+
+void cli_stream_start(size_t (*rx)(const uint8_t *data, size_t len), void (*stop)(void), bool exit_key)
+{
+	/* What the command printed before is sent before the stream */
+	fflush(stdout);
+	cli_stream_stop = stop;
+	cli_stream_exit = exit_key;
+	cli_stream_rx = rx;
+}
+
+void cli_stream_end(void)
+{
+	if(cli_stream_rx == NULL){
+		return;
+	}
+	cli_stream_rx = NULL;
+	if(cli_stream_stop != NULL){
+		cli_stream_stop();
+	}
+	if(!cli_batch){
+		NL1();
+		TERMINAL_SHOW_CURSOR();
+		PRINT_CLI_NAME();
+	}
+}
+
+size_t cli_stream_write(const char *data, size_t len)
+{
+	return cli_tx_push(data, len, true);
+}
+
+/**
+  * @brief  handles the commands in batch mode, one line per call so that the main loop goes on
+  * @param  null
+  * @retval null
+  */
+static void cli_batch_handle(void)
+{
+	static char line[MAX_LINE_LEN];
+	static uint8_t len = 0;
+	static bool overflow = false;
+	uint8_t c;
+
+	while(cli_rx_getc(&c)){
+		if(c == KEY_ENTER){
+			line[len] = '\0';
+			cli_batch_exec(line, overflow);
+			len = 0;
+			overflow = false;
+			return;
+		}
+		if(len < MAX_LINE_LEN - 1){
+			line[len++] = c;
+		}else{
+			overflow = true;
+		}
+	}
+}
+
+/**
+  * @brief          runs a batch line and sends its records
+  * @param  line:   "<seq> <command> [args]"
+  * @param  overflow: TRUE if the end of the line was cut
+  * @retval         null
+  */
+static void cli_batch_exec(char *line, bool overflow)
+{
+	char *seq = strtok(line, " \t");
+	if(seq == NULL){
+		return;
+	}
+	if(strspn(seq, "0123456789") != strlen(seq)){
+		cli_batch_record("!- syntax\n");
+		return;
+	}
+	if(overflow){
+		cli_batch_record("!%s length\n", seq);
+		return;
+	}
+
+	char *command = strtok(NULL, " \t");
+	const COMMAND_S *entry = cli_find_command(command);
+	if((entry == NULL) || (entry->pFun == NULL)){
+		cli_batch_record("!%s unknown\n", seq);
+		return;
+	}
+
+	uint8_t argc = 1;
+	char 	*argv[MAX_ARGC];
+	argv[0] = command;
+	for(char *token = strtok(NULL, " \t"); token != NULL; token = strtok(NULL, " \t")){
+		if(argc >= MAX_ARGC){
+			cli_batch_record("!%s args\n", seq);
+			return;
+		}
+		argv[argc++] = token;
+	}
+
+	cli_batch_seq = seq;
+	cli_batch_bol = true;
+	cli_batch_esc = 0;
+	cli_tx_wait = true;
+	uint8_t result = entry->pFun(argc, argv);
+	fflush(stdout);
+	cli_batch_seq = NULL;
+	if(!cli_batch_bol){
+		cli_tx_send("\n", 1);
+	}
+	cli_batch_record("=%s %u\n", seq, result);
+	cli_tx_wait = false;
+
+	if(!cli_batch){
+		/* "batch off" */
+		TERMINAL_SHOW_CURSOR();
+		PRINT_CLI_NAME();
+	}
+}
+
+/**
+  * @brief          sends the output of the running batch command, each line as ".<seq> <text>"
+  * @param  data:   output of the command
+  * @param  len:    number of bytes
+  * @retval         null
+  */
+static void cli_batch_output(const char *data, uint32_t len)
+{
+	char buf[64];
+	uint32_t n = 0;
+
+	for(uint32_t k = 0; k < len; k++){
+		char c = data[k];
+
+		/* VT100 sequences (colours, cursor) are removed: ESC '[' parameters final byte */
+		if(cli_batch_esc == 1){
+			cli_batch_esc = (c == '[') ? 2 : 0;
+			continue;
+		}else if(cli_batch_esc == 2){
+			if((c >= 0x40) && (c <= 0x7E)){
+				cli_batch_esc = 0;
+			}
+			continue;
+		}else if(c == '\x1b'){
+			cli_batch_esc = 1;
+			continue;
+		}else if(c == '\r'){
+			continue;
+		}
+
+		if(cli_batch_bol){
+			cli_tx_send(buf, n);
+			n = 0;
+			cli_tx_send(".", 1);
+			cli_tx_send(cli_batch_seq, strlen(cli_batch_seq));
+			cli_tx_send(" ", 1);
+			cli_batch_bol = false;
+		}
+		buf[n++] = c;
+		if(c == '\n'){
+			cli_batch_bol = true;
+		}
+		if(n == sizeof(buf)){
+			cli_tx_send(buf, n);
+			n = 0;
+		}
+	}
+	cli_tx_send(buf, n);
+}
+
+/**
+  * @brief          sends a batch record, from the main loop
+  * @param  fmt:    printf format
+  * @retval         null
+  */
+static void cli_batch_record(const char *fmt, ...)
+{
+	char buf[MAX_LINE_LEN + 16];
+	va_list args;
+
+	va_start(args, fmt);
+	int n = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	if(n > 0){
+		cli_tx_send(buf, ((size_t)n < sizeof(buf)) ? (uint32_t)n : sizeof(buf) - 1);
+	}
+}
+
+/**
+  * @brief  tx handle, flushes stdout buffer and restarts the DMA if a start was missed
   * @param  null
   * @retval null
   */
 static void cli_tx_handle(void)
 {
     fflush(stdout);
+    cli_tx_kick();
+}
+
+/**
+  * @brief          copies all the data in the stdout ring, waiting for room, see cli_tx_can_wait
+  * @param  data:   data to copy
+  * @param  len:    number of bytes
+  * @retval         null
+  */
+static void cli_tx_send(const char *data, uint32_t len)
+{
+	uint32_t done = 0;
+	while(done < len){
+		done += cli_tx_push(data + done, len - done, true);
+		cli_tx_kick();
+	}
+}
+
+/**
+  * @brief  tells if the caller can wait for room in the stdout ring: main loop, interrupts enabled
+  * @param  null
+  * @retval TRUE if it can wait
+  */
+static bool cli_tx_can_wait(void)
+{
+	return !(SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) && (__get_PRIMASK() == 0);
+}
+
+/**
+  * @brief          copies data in the stdout ring, from any context
+  * @param  data:   data to copy
+  * @param  len:    number of bytes
+  * @param  partial: TRUE to queue the part that fits, FALSE to queue all or nothing
+  * @retval         number of bytes queued
+  */
+static uint32_t cli_tx_push(const char *data, uint32_t len, bool partial)
+{
+	uint32_t head;
+	uint32_t n;
+
+	/* Counted before the reservation so that the DMA does not start on it */
+	cli_atomic_add(&cli_tx_writers, 1);
+	do {
+		head = __LDREXW(&cli_tx_head);
+		uint32_t room = CLI_TX_RING_SIZE - (head - cli_tx_tail);
+		n = (len <= room) ? len : (partial ? room : 0);
+		if(n == 0){
+			__CLREX();
+			break;
+		}
+	} while(__STREXW(head + n, &cli_tx_head) != 0U);
+
+	if(n != 0){
+		uint32_t start = head & (CLI_TX_RING_SIZE - 1);
+		uint32_t first = (n < CLI_TX_RING_SIZE - start) ? n : CLI_TX_RING_SIZE - start;
+		memcpy(&cli_tx_ring[start], data, first);
+		memcpy(cli_tx_ring, data + first, n - first);
+
+		cli_atomic_add(&cli_tx_stats.written, n);
+		uint32_t fill = head + n - cli_tx_tail;
+		uint32_t max;
+		do {
+			max = __LDREXW(&cli_tx_stats.max_fill);
+			if(fill <= max){
+				__CLREX();
+				break;
+			}
+		} while(__STREXW(fill, &cli_tx_stats.max_fill) != 0U);
+	}
+
+	__DMB();
+	if(cli_atomic_add(&cli_tx_writers, (uint32_t)-1) == 0){
+		cli_tx_kick();
+	}
+	return n;
+}
+
+/**
+  * @brief  starts a DMA transfer of the stdout ring if none is running, from any context
+  * @param  null
+  * @retval null
+  */
+static void cli_tx_kick(void)
+{
+	for(;;){
+		/* Only one context owns the DMA, the others leave the start to it */
+		if(__LDREXW(&cli_tx_busy) != 0U){
+			__CLREX();
+			return;
+		}
+		if(__STREXW(1, &cli_tx_busy) != 0U){
+			continue;
+		}
+		__DMB();
+
+		uint32_t tail = cli_tx_tail;
+		uint32_t head = (cli_tx_writers == 0) ? cli_tx_head : tail;
+		if(head != tail){
+			/* Up to the end of the ring, the rest is sent by the next transfer */
+			uint32_t start = tail & (CLI_TX_RING_SIZE - 1);
+			uint32_t n = head - tail;
+			if(n > CLI_TX_RING_SIZE - start){
+				n = CLI_TX_RING_SIZE - start;
+			}
+			cli_tx_inflight = n;
+			if(HAL_UART_Transmit_DMA(huart_shell, &cli_tx_ring[start], n) == HAL_OK){
+				/* cli_tx_busy is released by HAL_UART_TxCpltCallback */
+				return;
+			}
+			/* Retried by cli_run */
+			cli_tx_inflight = 0;
+			__DMB();
+			cli_tx_busy = 0;
+			return;
+		}
+
+		__DMB();
+		cli_tx_busy = 0;
+		/* A write may have ended while the DMA was owned here, its own start was skipped */
+		if((cli_tx_writers != 0) || (cli_tx_head == cli_tx_tail)){
+			return;
+		}
+	}
+}
+
+/**
+  * @brief          atomic addition
+  * @param  value:  value to update
+  * @param  add:    added to value
+  * @retval         new value
+  */
+static uint32_t cli_atomic_add(volatile uint32_t *value, uint32_t add)
+{
+	uint32_t result;
+	do {
+		result = __LDREXW(value) + add;
+	} while(__STREXW(result, value) != 0U);
+	return result;
 }
 
 void cli_run(void)
 {
-    cli_rx_handle(&cli_rx_buff);
+    cli_rx_handle();
     cli_tx_handle();
 }
 
+void cli_greet(void)
+{
+	if(!cli_password_ok){
+		return;
+	}
+	cli_tx_wait = true;
+	greet();
+	cli_tx_wait = false;
+}
+
 void greet(void){
     NL1();
     TERMINAL_BACK_DEFAULT(); /* set terminal background color: black */
@@ -555,22 +1218,19 @@ void greet(void){
 uint8_t cli_help(int argc, char *argv[])
 {
 	if(argc == 1){
-	    for(size_t i = 0; i < MAX_COMMAND_NB; i++) {
-	    	if(strcmp(CLI_commands[i].pCmd, "") != 0){
-		    	printf("[%s]", CLI_commands[i].pCmd);NL1();
-		        if (CLI_commands[i].pHelp) {
-		            printf(CLI_commands[i].pHelp);NL2();
-		        }
-	    	}
+	    for(size_t i = 0; i < CLI_COMMANDS_NB; i++) {
+	    	printf("[%s]", __cli_commands_start[i].pCmd);NL1();
+	        if (__cli_commands_start[i].pHelp) {
+	            printf(__cli_commands_start[i].pHelp);NL2();
+	        }
 	    }
 	    return EXIT_SUCCESS;
 	}else if(argc == 2){
-	    for(size_t i = 0; i < MAX_COMMAND_NB; i++) {
-	    	if(strcmp(CLI_commands[i].pCmd, argv[1]) == 0){
-		    	printf("[%s]", CLI_commands[i].pCmd);NL1();
-	    		printf(CLI_commands[i].pHelp);NL1();
-	    		return EXIT_SUCCESS;
-	    	}
+		const COMMAND_S *entry = cli_find_command(argv[1]);
+		if(entry != NULL){
+	    	printf("[%s]", entry->pCmd);NL1();
+    		printf(entry->pHelp);NL1();
+    		return EXIT_SUCCESS;
 	    }
 	    printf("No help found for command %s.", argv[1]);NL1();
 	    return EXIT_FAILURE;
@@ -622,92 +1282,139 @@ uint8_t cli_reset(int argc, char *argv[])
 	return EXIT_SUCCESS;
 }
 
-void cli_add_command(const char *command, const char *help, uint8_t (*exec)(int argc, char *argv[])){
-	size_t i = 0;
-	for(; i < MAX_COMMAND_NB; i++){
-		if(strcmp(CLI_commands[i].pCmd, "") == 0){
-			CLI_commands[i].pCmd = command;
-			CLI_commands[i].pFun = exec;
-			CLI_commands[i].pHelp = help;
-			break;
-		}
-	}
-	if(i == MAX_COMMAND_NB){
-		ERR("Cannot add command %s, max number of commands "
-				"reached. The maximum number of command is set to %d.\n" CLI_FONT_DEFAULT,
-				command, MAX_COMMAND_NB); NL1();
-	}
-	LOG(CLI_LOG_SHELL, "Command %s added to shell.\n", command);
-}
-
 uint8_t cli_log(int argc, char *argv[]){
 	if(argc < 2){
 		printf("Command %s takes at least one argument. Use \"help %s\" for usage.\n", argv[0], argv[0]);
 		return EXIT_FAILURE;
 	}
 
+	uint8_t level;
+	int first;
 	if(strcmp(argv[1], "on") == 0){
-		if(argc < 3){
-			printf("Command %s on takes at least 3 arguments.\n", argv[0]);
-			return EXIT_FAILURE;
-		}
-		if(strcmp(argv[2], "all") == 0){
-			cli_log_stat = 0xFFFFFFFF;
-			printf("All logs enabled.\n");
-			return EXIT_SUCCESS;
-		}else{
-			for(int i = 2; i < argc; i++){
-				cli_enable_log_entry(argv[i]);
+		level = CLI_LEVEL_DEBUG;
+		first = 2;
+	}else if(strcmp(argv[1], "off") == 0){
+		level = CLI_LEVEL_OFF;
+		first = 2;
+	}else if(strcmp(argv[1], "level") == 0 && argc >= 3){
+		for(level = CLI_LEVEL_OFF; level <= CLI_LEVEL_DEBUG; level++){
+			if(strcmp(argv[2], cli_level_names[level]) == 0){
+				break;
 			}
-			return EXIT_SUCCESS;
 		}
-
-	}else if(strcmp(argv[1], "off") == 0){
-		printf("Turning off all logs\n");
-		if(argc < 3){
-			printf("Command %s on takes at least 3 arguments.\n", argv[0]);
+		if(level > CLI_LEVEL_DEBUG){
+			printf("Unknown level %s. Use \"help %s\" for usage.\n", argv[2], argv[0]);
 			return EXIT_FAILURE;
 		}
-		if(strcmp(argv[2], "all") == 0){
-			cli_log_stat = 0;
-			printf("All logs disabled.\n");
-			return EXIT_SUCCESS;
-		}else{
-			for(int i = 2; i < argc; i++){
-				cli_disable_log_entry(argv[i]);
-			}
-			return EXIT_SUCCESS;
-		}
-
+		first = 3;
 	}else if(strcmp(argv[1], "show") == 0){
 		for(unsigned int i = 0; i < CLI_LAST_LOG_CATEGORY; i++){
 			printf("%16s:\t", cli_logs_names[i]);
-			if(cli_log_stat&(1<<i)){
-				printf(CLI_FONT_GREEN"Enabled"CLI_FONT_DEFAULT"\n");
+			if(cli_log_levels[i] != CLI_LEVEL_OFF){
+				printf(CLI_FONT_GREEN"%s"CLI_FONT_DEFAULT"\n", cli_level_names[cli_log_levels[i]]);
 			}else{
-				printf(CLI_FONT_RED"Disabled"CLI_FONT_DEFAULT"\n");
+				printf(CLI_FONT_RED"%s"CLI_FONT_DEFAULT"\n", cli_level_names[cli_log_levels[i]]);
 			}
 		}
+		printf("Compiled up to level %s.\n", cli_level_names[CLI_LOG_LEVEL]);
 		return EXIT_SUCCESS;
+	}else{
+		return EXIT_FAILURE;
 	}
 
-	return EXIT_FAILURE;
+	if(argc <= first){
+		printf("Command %s %s takes at least one category or \"all\".\n", argv[0], argv[1]);
+		return EXIT_FAILURE;
+	}
+	if(strcmp(argv[first], "all") == 0){
+		for(unsigned int i = 0; i < CLI_LAST_LOG_CATEGORY; i++){
+			cli_log_levels[i] = level;
+		}
+		printf("All logs set to level %s.\n", cli_level_names[level]);
+		return EXIT_SUCCESS;
+	}
+
+	bool found = true;
+	for(int i = first; i < argc; i++){
+		found &= cli_set_log_entry(argv[i], level);
+	}
+	return found ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
-void cli_disable_log_entry(char *str){
-	for(unsigned int i = 0; i < CLI_LAST_LOG_CATEGORY; i++){
-		if(strcmp(str, cli_logs_names[i]) == 0){
-			printf("LOG disabled for category %s.\n", str);
-			cli_log_stat &= ~(1<<i);
+uint8_t cli_stdout(int argc, char *argv[]){
+	if(argc == 2 && strcmp(argv[1], "reset") == 0){
+		cli_tx_stats.written = 0;
+		cli_tx_stats.dropped = 0;
+		cli_tx_stats.max_fill = 0;
+		printf("stdout counters reset.\n");
+		return EXIT_SUCCESS;
+	}else if(argc != 1){
+		printf("Use \"help %s\" for usage.\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	printf("Ring size:     %u bytes (%s when full)\n", CLI_TX_RING_SIZE,
+			(CLI_TX_POLICY == CLI_TX_TRUNCATE) ? "truncate" : "drop");
+	printf("Fill:          %lu bytes\n", (unsigned long)(cli_tx_head - cli_tx_tail));
+	printf("Max fill:      %lu bytes\n", (unsigned long)cli_tx_stats.max_fill);
+	printf("Written:       %lu bytes\n", (unsigned long)cli_tx_stats.written);
+	printf("Dropped:       %lu bytes\n", (unsigned long)cli_tx_stats.dropped);
+	return EXIT_SUCCESS;
+}
+
+uint8_t cli_stdin(int argc, char *argv[]){
+	if(argc == 2 && strcmp(argv[1], "reset") == 0){
+		cli_rx_stats.received = 0;
+		cli_rx_stats.lost = 0;
+		cli_rx_stats.errors = 0;
+		cli_rx_stats.max_fill = 0;
+		printf("stdin counters reset.\n");
+		return EXIT_SUCCESS;
+	}else if(argc != 1){
+		printf("Use \"help %s\" for usage.\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	printf("Ring size:     %u bytes (%u readable)\n", CLI_RX_RING_SIZE, CLI_RX_RING_SIZE / 2);
+	/* Time to receive the readable half at the current baud rate, 10 bits per byte */
+	printf("Burst window:  %lu ms\n",
+			(unsigned long)((CLI_RX_RING_SIZE / 2) * 10000UL / huart_shell->Init.BaudRate));
+	printf("Unread:        %lu bytes\n", (unsigned long)(cli_rx_head - cli_rx_tail));
+	printf("Max unread:    %lu bytes\n", (unsigned long)cli_rx_stats.max_fill);
+	printf("Received:      %lu bytes\n", (unsigned long)cli_rx_stats.received);
+	printf("Lost:          %lu bytes\n", (unsigned long)cli_rx_stats.lost);
+	printf("Errors:        %lu\n", (unsigned long)cli_rx_stats.errors);
+	return EXIT_SUCCESS;
+}
+
+uint8_t cli_batch_cmd(int argc, char *argv[]){
+	if(argc != 2){
+		printf("Use \"help %s\" for usage.\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if(strcmp(argv[1], "on") == 0){
+		if(!cli_batch){
+			printf("Batch mode, \"<seq> batch off\" to leave it.\n");
+			fflush(stdout);
+			cli_batch = true;
 		}
+		return EXIT_SUCCESS;
+	}else if(strcmp(argv[1], "off") == 0){
+		cli_batch = false;
+		return EXIT_SUCCESS;
 	}
+	printf("Use \"help %s\" for usage.\n", argv[0]);
+	return EXIT_FAILURE;
 }
 
-void cli_enable_log_entry(char *str){
+static bool cli_set_log_entry(char *str, uint8_t level){
 	for(unsigned int i = 0; i < CLI_LAST_LOG_CATEGORY; i++){
 		if(strcmp(str, cli_logs_names[i]) == 0){
-			printf("LOG enabled for category %s.\n", str);
-			cli_log_stat |= (1<<i);
+			printf("LOG level of category %s set to %s.\n", str, cli_level_names[level]);
+			cli_log_levels[i] = level;
+			return true;
 		}
 	}
+	printf("Unknown log category %s.\n", str);
+	return false;
 }
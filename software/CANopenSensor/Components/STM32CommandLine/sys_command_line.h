@@ -15,53 +15,145 @@
 
 #include "main.h"
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
-#include "sys_queue.h"
 #include "vt100.h"
+#include "sys_binlog.h"
 
 /*
  *  Macro config
  */
 #define CLI_ENABLE          true            	/* command line enable/disable */
 #define HISTORY_MAX         10                  /* maximum number of history command */
-#define MAX_COMMAND_NB		32
 #define MAX_ARGC			8
 #define MAX_LINE_LEN 		80
+#define CLI_TX_RING_SIZE	2048				/* stdout ring drained by the UART DMA, must be a power of 2 */
+#define CLI_TX_POLICY		CLI_TX_DROP			/* what a write does when the stdout ring is full */
+#define CLI_RX_RING_SIZE	2048				/* stdin ring written by the UART DMA, must be a power of 2, half of it is the burst limit */
+#define CLI_GREET_ON_INIT	false				/* false: the banner waits for cli_greet() (fast boot) */
 
+/*
+ *  stdout full ring policies. The oldest bytes can not be overwritten, the DMA may be reading them.
+ */
+#define CLI_TX_DROP			0					/* the whole write is dropped */
+#define CLI_TX_TRUNCATE		1					/* the beginning of the write is kept, the rest is dropped */
+
+/*
+ * Command entry
+ */
+typedef struct {
+    const char *pCmd;
+    const char *pHelp;
+    uint8_t (*pFun)(int argc, char *argv[]);
+} COMMAND_S;
+
+#define CLI_CONCAT(a, b)	CLI_CONCAT_(a, b)
+#define CLI_CONCAT_(a, b)	a##b
+
+/*
+ *  Registers a command at build time, at file scope: CLI_COMMAND("name", help, function);
+ *  The entry is placed in the .cli_cmd.<name> section, the linker sorts these sections by name in
+ *  flash so that the commands are found by binary search.
+ */
 #ifndef CLI_DISABLE
     #define CLI_INIT(...)       cli_init(__VA_ARGS__)
     #define CLI_RUN(...)        cli_run(__VA_ARGS__)
-	#define CLI_ADD_CMD(...)	cli_add_command(__VA_ARGS__)
+	#define CLI_COMMAND(name, help, exec)										\
+				static const COMMAND_S CLI_CONCAT(cli_command_, __LINE__)		\
+					__attribute__((section(".cli_cmd." name), used, aligned(4)))	\
+					= {name, help, exec}
 #else
     #define CLI_INIT(...)       ;
     #define CLI_RUN(...)        ;
-	#define CLI_ADD_CMD(...)	;
+	#define CLI_COMMAND(name, help, exec)	_Static_assert(1, name)
 #endif /* CLI_DISABLE */
 
-#define ERR(fmt, ...)  do {												\
+/*
+ *  Log levels. A call is compiled only if its level is at most CLI_LOG_LEVEL, and printed only if
+ *  its level is at most the runtime level of its category ("log" command, OD 0x2150). The
+ *  arguments of a filtered call are not evaluated.
+ */
+#define CLI_LEVEL_OFF		0
+#define CLI_LEVEL_ERROR		1
+#define CLI_LEVEL_WARN		2
+#define CLI_LEVEL_INFO		3
+#define CLI_LEVEL_DEBUG		4
+
+#ifndef CLI_LOG_LEVEL
+#define CLI_LOG_LEVEL		CLI_LEVEL_DEBUG		/* most verbose level compiled in */
+#endif
+
+/*
+ *  Category of ERR, WRN and DBG. A source file selects its own by defining CLI_LOG_MODULE
+ *  before including this file.
+ */
+#ifndef CLI_LOG_MODULE
+#define CLI_LOG_MODULE		CLI_LOG_SHELL
+#endif
+
+#define CLI_LOG_ENABLED(LOG_CAT, level)	(((level) <= CLI_LOG_LEVEL) && ((level) <= cli_log_levels[LOG_CAT]))
+
+#define ERR(fmt, ...)	do {											\
+							if(CLI_LOG_ENABLED(CLI_LOG_MODULE, CLI_LEVEL_ERROR)) {	\
+								CLI_PRINT_ERR(fmt, ##__VA_ARGS__);		\
+							}											\
+						} while(0)
+
+#define WRN(fmt, ...)	do {											\
+							if(CLI_LOG_ENABLED(CLI_LOG_MODULE, CLI_LEVEL_WARN)) {	\
+								CLI_PRINT_WRN(fmt, ##__VA_ARGS__);		\
+							}											\
+						} while(0)
+
+#define LOG(LOG_CAT, fmt, ...)	do {									\
+							if(CLI_LOG_ENABLED(LOG_CAT, CLI_LEVEL_INFO)) {	\
+								CLI_PRINT_LOG(LOG_CAT, fmt, ##__VA_ARGS__);	\
+							}											\
+						} while(0)
+
+#define DBG(fmt, ...)	do {											\
+							if(CLI_LOG_ENABLED(CLI_LOG_MODULE, CLI_LEVEL_DEBUG)) {	\
+								CLI_PRINT_DBG(fmt, ##__VA_ARGS__);		\
+							}											\
+						} while(0)
+
+/*
+ *  With CLI_BINARY_LOG, the logs are sent as binary records (sys_binlog.h) formatted on the host
+ *  by Tools/binlog_decode: no printf on the MCU and about 10 times fewer bytes on the UART.
+ */
+#ifdef CLI_BINARY_LOG
+#define CLI_PRINT_ERR(fmt, ...)				BINLOG("E", fmt, ##__VA_ARGS__)
+#define CLI_PRINT_WRN(fmt, ...)				BINLOG("W", fmt, ##__VA_ARGS__)
+#define CLI_PRINT_LOG(LOG_CAT, fmt, ...)	BINLOG("L" #LOG_CAT, fmt, ##__VA_ARGS__)
+#define CLI_PRINT_DBG(fmt, ...)				BINLOG("D", fmt, ##__VA_ARGS__)
+#else
+#define CLI_PRINT_ERR(fmt, ...)											\
                             fprintf(stderr,								\
 								CLI_FONT_RED							\
 								"[ERROR] %s:%d: "fmt"\n"				\
 								CLI_FONT_DEFAULT,						\
-                                __FILE__, __LINE__, ##__VA_ARGS__);		\
-                        }while(0)
+                                __FILE__, __LINE__, ##__VA_ARGS__)
 
-#define LOG(LOG_CAT, fmt, ...)											\
-						if((1<<LOG_CAT)&cli_log_stat) {					\
+#define CLI_PRINT_WRN(fmt, ...)											\
+                            printf(CLI_FONT_PURPLE						\
+								"[Warning] %s:%d: "fmt"\n"				\
+								CLI_FONT_DEFAULT,						\
+                                __FILE__, __LINE__, ##__VA_ARGS__)
+
+#define CLI_PRINT_LOG(LOG_CAT, fmt, ...)								\
                             printf(CLI_FONT_CYAN						\
 								"[%s]: "fmt"\n"							\
 								CLI_FONT_DEFAULT,						\
 								cli_logs_names[LOG_CAT],				\
-								##__VA_ARGS__);							\
-                        }
+								##__VA_ARGS__)
 
-#define DBG(fmt, ...)  do {												\
+#define CLI_PRINT_DBG(fmt, ...)											\
                             printf(CLI_FONT_YELLOW						\
 							"[Debug] %s:%d: "fmt"\n"					\
 							CLI_FONT_DEFAULT,							\
-                                __FILE__, __LINE__, ##__VA_ARGS__);		\
-                        } while(0)
+                                __FILE__, __LINE__, ##__VA_ARGS__)
+#endif /* CLI_BINARY_LOG */
 
 #define DIE(fmt, ...)   do {											\
                             TERMINAL_FONT_RED();						\
@@ -83,11 +175,15 @@
 #else
 #define PRINT_CLI_NAME()	do { printf(CLI_FONT_DEFAULT"\n#$ "); } while(0)
 #endif
+/*
+ *  Log categories. More can be defined with CLI_ADDITIONAL_LOG_CATEGORIES, a list of
+ *  X(name, default level) entries.
+ */
 enum cli_log_categories {
 	CLI_LOG_SHELL = 0,
 
 #ifdef CLI_ADDITIONAL_LOG_CATEGORIES
-#define X(name, b) CLI_LOG_##name,
+#define X(name, level) CLI_LOG_##name,
 CLI_ADDITIONAL_LOG_CATEGORIES
 #undef X
 #endif
@@ -97,7 +193,30 @@ CLI_ADDITIONAL_LOG_CATEGORIES
 
 extern char *cli_logs_names[];
 
-extern uint32_t cli_log_stat;
+extern uint8_t cli_log_levels[];		/* runtime level of each category */
+
+/*
+ * stdout ring statistics, shown by the "stdout" command
+ */
+typedef struct {
+	uint32_t written;		/* bytes queued in the ring */
+	uint32_t dropped;		/* bytes dropped because the ring was full */
+	uint32_t max_fill;		/* highest fill level of the ring, in bytes */
+} cli_tx_stats_s;
+
+extern volatile cli_tx_stats_s cli_tx_stats;
+
+/*
+ * stdin ring statistics, shown by the "stdin" command
+ */
+typedef struct {
+	uint32_t received;		/* bytes written in the ring by the DMA */
+	uint32_t lost;			/* bytes overwritten by the DMA before being read */
+	uint32_t errors;		/* reception errors (overrun, framing, noise, DMA) */
+	uint32_t max_fill;		/* highest number of unread bytes, in bytes */
+} cli_rx_stats_s;
+
+extern volatile cli_rx_stats_s cli_rx_stats;
 
 
 /**
@@ -115,7 +234,48 @@ void 		cli_init(UART_HandleTypeDef *handle_uart, uint8_t USART_IRQn);
   */
 void 		cli_run(void);
 
-void 		cli_add_command(const char *command, const char *help, uint8_t (*exec)(int argc, char *argv[]));
+/**
+  * @brief  prints the banner and the prompt, waits for room in the stdout ring. Done by cli_init
+  *			if CLI_GREET_ON_INIT is true, else to be called once the slow part of the boot is over.
+  *			With CLI_PASSWORD, the banner waits for the password.
+  * @param  null
+  * @retval null
+  */
+void 		cli_greet(void);
+
+/*
+ *  Stream mode, for a protocol that uses the shell UART (CiA 309 gateway): the shell stops reading
+ *  command lines and gives the received bytes to rx, in place, until CLI_STREAM_EXIT is received
+ *  or cli_stream_end is called. Meanwhile only cli_stream_write is sent, the other outputs and the
+ *  logs are dropped.
+ */
+#define CLI_STREAM_EXIT		'\x04'				/* Ctrl-D */
+
+/**
+  * @brief  starts the stream mode, usually from a shell command
+  * @param  rx		called from cli_run with the received bytes, returns the number of bytes used,
+  *					the others are given again at the next call
+  * @param  stop	called when the stream ends, can be NULL
+  * @param  exit_key	CLI_STREAM_EXIT ends the stream, false for a binary protocol
+  * @retval null
+  */
+void 		cli_stream_start(size_t (*rx)(const uint8_t *data, size_t len), void (*stop)(void),
+							 bool exit_key);
+
+/**
+  * @brief  ends the stream mode and shows the prompt again, from the main loop (rx included)
+  * @param  null
+  * @retval null
+  */
+void 		cli_stream_end(void);
+
+/**
+  * @brief  copies data in the stdout ring, from the main loop, never waits
+  * @param  data	data to send
+  * @param  len		number of bytes
+  * @retval number of bytes copied, the others must be sent again later
+  */
+size_t 		cli_stream_write(const char *data, size_t len);
 
 #endif /* __SYS_COMMAND_LINE_H */
 
@@ -79,7 +79,14 @@ void Error_Handler(void);
 #define LD3_GPIO_Port GPIOB
 
 /* USER CODE BEGIN Private defines */
-
+/* Log categories of the shell in addition to SHELL: X(name, default level), see sys_command_line.h.
+ * The levels are also in OD 0x2150, one sub-index per category in this order. */
+#define CLI_ADDITIONAL_LOG_CATEGORIES	\
+	X(APP, CLI_LEVEL_INFO)				\
+	X(SENSORS, CLI_LEVEL_INFO)			\
+	X(PATTERN, CLI_LEVEL_INFO)			\
+	X(STORE, CLI_LEVEL_INFO)			\
+	X(JOURNAL, CLI_LEVEL_INFO)
 /* USER CODE END Private defines */
 
 #ifdef __cplusplus
@@ -0,0 +1,354 @@
+/**
+ ************************************************************************************************************
+ *  \file               binlog_decode.c
+ *  \brief              Host decoder of the binary log records (CLI_BINARY_LOG, sys_binlog.h)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ *
+ *  Build and run from this directory:
+ *      gcc -O2 -o binlog_decode binlog_decode.c
+ *      stty -F /dev/ttyACM0 115200 raw
+ *      ./binlog_decode ../../Release/CANopenSensor.elf < /dev/ttyACM0
+ *
+ *  The call sites are read from the .logfmt section of the ELF file, it must be the one flashed in
+ *  the board. The text output of the shell is copied as is, the records are formatted like the
+ *  text ERR, WRN, LOG and DBG macros with the time of the board in front.
+ */
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+/************************************************************************************************************
+ * Local define
+ ************************************************************************************************************/
+// Same values as sys_binlog.h
+#define BINLOG_SYNC              (0x01)
+#define BINLOG_HEADER_LEN        (8)
+
+#define DECODE_MAX_MESSAGE       (512)
+#define DECODE_MAX_SPEC          (32)
+
+#define FONT_RED                 "\033[1;31m"
+#define FONT_YELLOW              "\033[1;33m"
+#define FONT_PURPLE              "\033[1;35m"
+#define FONT_CYAN                "\033[1;36m"
+#define FONT_DEFAULT             "\033[0m"
+/************************************************************************************************************
+ * Local Types
+ ************************************************************************************************************/
+typedef struct {
+	const uint8_t *pu8Data;
+	size_t uLen;
+	size_t uOffset;
+} Args_t;
+/************************************************************************************************************
+ * Local data
+ ************************************************************************************************************/
+static char *g_pcSites = NULL;
+static size_t g_uSitesSize = 0;
+static int g_iColor = 0;
+/************************************************************************************************************
+ * Local function prototypes
+ ************************************************************************************************************/
+static int LoadSites(const char *pcElf);
+static void PrintRecord(uint16_t u16Id, uint32_t u32Tick, const uint8_t *pu8Args,
+		size_t uLen);
+static void Format(char *pcOut, size_t uSize, const char *pcFormat, Args_t *pxArgs);
+static int TakeArg(Args_t *pxArgs, void *pvValue, size_t uSize);
+static void Usage(const char *pcName);
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+int main(int argc, char *argv[]) {
+	int iOption;
+
+	g_iColor = isatty(STDOUT_FILENO);
+	while ((iOption = getopt(argc, argv, "nh")) != -1) {
+		switch (iOption) {
+		case 'n':
+			g_iColor = 0;
+			break;
+		default:
+			Usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind >= argc) {
+		Usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (LoadSites(argv[optind]) != 0) {
+		return EXIT_FAILURE;
+	}
+
+	FILE *pxInput = stdin;
+	if (optind + 1 < argc) {
+		pxInput = fopen(argv[optind + 1], "rb");
+		if (pxInput == NULL) {
+			perror(argv[optind + 1]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	int iByte;
+	while ((iByte = getc(pxInput)) != EOF) {
+		if (iByte != BINLOG_SYNC) {
+			// Text output of the shell
+			putchar(iByte);
+			if (iByte == '\n') {
+				fflush(stdout);
+			}
+			continue;
+		}
+
+		uint8_t au8Record[256];
+		int iLen = getc(pxInput);
+		if (iLen == EOF || fread(au8Record, 1, iLen, pxInput) != (size_t) iLen) {
+			break;
+		}
+		if (iLen < BINLOG_HEADER_LEN - 2) {
+			printf("<invalid record>\n");
+			continue;
+		}
+		uint16_t u16Id = au8Record[0] | (au8Record[1] << 8);
+		uint32_t u32Tick = au8Record[2] | (au8Record[3] << 8) | (au8Record[4] << 16)
+				| ((uint32_t) au8Record[5] << 24);
+		PrintRecord(u16Id, u32Tick, &au8Record[BINLOG_HEADER_LEN - 2],
+				iLen - (BINLOG_HEADER_LEN - 2));
+		fflush(stdout);
+	}
+	return EXIT_SUCCESS;
+}
+/************************************************************************************************************
+ * Local functions declaration
+ ************************************************************************************************************/
+static int LoadSites(const char *pcElf) {
+	FILE *pxFile = fopen(pcElf, "rb");
+	if (pxFile == NULL) {
+		perror(pcElf);
+		return -1;
+	}
+
+	Elf32_Ehdr xHeader;
+	if (fread(&xHeader, sizeof(xHeader), 1, pxFile) != 1
+			|| memcmp(xHeader.e_ident, ELFMAG, SELFMAG) != 0
+			|| xHeader.e_ident[EI_CLASS] != ELFCLASS32
+			|| xHeader.e_ident[EI_DATA] != ELFDATA2LSB
+			|| xHeader.e_shentsize != sizeof(Elf32_Shdr)) {
+		fprintf(stderr, "%s: not a 32 bits little endian ELF file\n", pcElf);
+		fclose(pxFile);
+		return -1;
+	}
+
+	Elf32_Shdr *pxSections = calloc(xHeader.e_shnum, sizeof(Elf32_Shdr));
+	if (pxSections == NULL || fseek(pxFile, xHeader.e_shoff, SEEK_SET) != 0
+			|| fread(pxSections, sizeof(Elf32_Shdr), xHeader.e_shnum, pxFile)
+					!= xHeader.e_shnum || xHeader.e_shstrndx >= xHeader.e_shnum) {
+		fprintf(stderr, "%s: invalid section table\n", pcElf);
+		fclose(pxFile);
+		return -1;
+	}
+
+	const Elf32_Shdr *pxNames = &pxSections[xHeader.e_shstrndx];
+	char *pcNames = malloc(pxNames->sh_size + 1);
+	if (pcNames == NULL || fseek(pxFile, pxNames->sh_offset, SEEK_SET) != 0
+			|| fread(pcNames, 1, pxNames->sh_size, pxFile) != pxNames->sh_size) {
+		fprintf(stderr, "%s: invalid section names\n", pcElf);
+		fclose(pxFile);
+		return -1;
+	}
+	pcNames[pxNames->sh_size] = '\0';
+
+	int iResult = -1;
+	for (unsigned i = 0; i < xHeader.e_shnum; i++) {
+		if (pxSections[i].sh_name >= pxNames->sh_size
+				|| strcmp(&pcNames[pxSections[i].sh_name], ".logfmt") != 0) {
+			continue;
+		}
+		g_uSitesSize = pxSections[i].sh_size;
+		g_pcSites = malloc(g_uSitesSize + 1);
+		if (g_pcSites != NULL && fseek(pxFile, pxSections[i].sh_offset, SEEK_SET) == 0
+				&& fread(g_pcSites, 1, g_uSitesSize, pxFile) == g_uSitesSize) {
+			g_pcSites[g_uSitesSize] = '\0';
+			iResult = 0;
+		}
+		break;
+	}
+	if (iResult != 0) {
+		fprintf(stderr, "%s: no .logfmt section, built without CLI_BINARY_LOG?\n", pcElf);
+	}
+
+	free(pcNames);
+	free(pxSections);
+	fclose(pxFile);
+	return iResult;
+}
+
+static void PrintRecord(uint16_t u16Id, uint32_t u32Tick, const uint8_t *pu8Args,
+		size_t uLen) {
+	printf("[%6u.%03u] ", u32Tick / 1000, u32Tick % 1000);
+	if (u16Id >= g_uSitesSize) {
+		printf("<unknown call site 0x%04x, wrong ELF file?>\n", u16Id);
+		return;
+	}
+
+	// "<kind>|<file>|<line>|<format>"
+	char acSite[DECODE_MAX_MESSAGE];
+	snprintf(acSite, sizeof(acSite), "%s", &g_pcSites[u16Id]);
+	char *pcKind = acSite;
+	char *pcFile = strchr(pcKind, '|');
+	char *pcLine = (pcFile != NULL) ? strchr(pcFile + 1, '|') : NULL;
+	char *pcFormat = (pcLine != NULL) ? strchr(pcLine + 1, '|') : NULL;
+	if (pcFormat == NULL) {
+		printf("<invalid call site 0x%04x>\n", u16Id);
+		return;
+	}
+	*pcFile++ = '\0';
+	*pcLine++ = '\0';
+	*pcFormat++ = '\0';
+
+	char acMessage[DECODE_MAX_MESSAGE];
+	Args_t xArgs = { .pu8Data = pu8Args, .uLen = uLen, .uOffset = 0 };
+	Format(acMessage, sizeof(acMessage), pcFormat, &xArgs);
+	size_t uMessageLen = strlen(acMessage);
+	while (uMessageLen > 0 && acMessage[uMessageLen - 1] == '\n') {
+		acMessage[--uMessageLen] = '\0';
+	}
+
+	const char *pcColor = "";
+	if (pcKind[0] == 'E') {
+		pcColor = FONT_RED;
+		printf("%s[ERROR] %s:%s: %s", g_iColor ? pcColor : "", pcFile, pcLine, acMessage);
+	} else if (pcKind[0] == 'W') {
+		pcColor = FONT_PURPLE;
+		printf("%s[Warning] %s:%s: %s", g_iColor ? pcColor : "", pcFile, pcLine, acMessage);
+	} else if (pcKind[0] == 'D') {
+		pcColor = FONT_YELLOW;
+		printf("%s[Debug] %s:%s: %s", g_iColor ? pcColor : "", pcFile, pcLine, acMessage);
+	} else {
+		// "L" followed by the log category, e.g. "LCLI_LOG_SHELL"
+		const char *pcCategory = pcKind + 1;
+		if (strncmp(pcCategory, "CLI_LOG_", 8) == 0) {
+			pcCategory += 8;
+		}
+		pcColor = FONT_CYAN;
+		printf("%s[%s]: %s", g_iColor ? pcColor : "", pcCategory, acMessage);
+	}
+	printf("%s\n", g_iColor ? FONT_DEFAULT : "");
+}
+
+// printf on the host with the arguments of the record, in their target sizes
+static void Format(char *pcOut, size_t uSize, const char *pcFormat, Args_t *pxArgs) {
+	size_t uOut = 0;
+	pcOut[0] = '\0';
+
+	while (*pcFormat != '\0' && uOut + 1 < uSize) {
+		if (*pcFormat != '%') {
+			pcOut[uOut++] = *pcFormat++;
+			pcOut[uOut] = '\0';
+			continue;
+		}
+		if (pcFormat[1] == '%') {
+			pcOut[uOut++] = '%';
+			pcOut[uOut] = '\0';
+			pcFormat += 2;
+			continue;
+		}
+
+		// Conversion specification, the length modifiers are removed: the size is known
+		char acSpec[DECODE_MAX_SPEC];
+		size_t uSpec = 0;
+		int iLongLong = 0;
+		acSpec[uSpec++] = *pcFormat++;
+		while (*pcFormat != '\0' && strchr("-+ #0123456789.", *pcFormat) != NULL
+				&& uSpec < DECODE_MAX_SPEC - 4) {
+			acSpec[uSpec++] = *pcFormat++;
+		}
+		while (*pcFormat != '\0' && strchr("hlLqjzt", *pcFormat) != NULL) {
+			if (pcFormat[0] == 'l' && pcFormat[1] == 'l') {
+				iLongLong = 1;
+			}
+			pcFormat++;
+		}
+		char cConversion = *pcFormat;
+		if (cConversion == '\0') {
+			break;
+		}
+		pcFormat++;
+
+		char acValue[DECODE_MAX_MESSAGE];
+		int iOk;
+		if (cConversion == 's') {
+			uint8_t u8Len = 0;
+			char acString[256];
+			iOk = TakeArg(pxArgs, &u8Len, 1) == 0
+					&& TakeArg(pxArgs, acString, u8Len) == 0;
+			acString[iOk ? u8Len : 0] = '\0';
+			acSpec[uSpec++] = 's';
+			acSpec[uSpec] = '\0';
+			snprintf(acValue, sizeof(acValue), acSpec, acString);
+		} else if (strchr("fFeEgGaA", cConversion) != NULL) {
+			float fValue = 0;
+			iOk = TakeArg(pxArgs, &fValue, sizeof(fValue)) == 0;
+			acSpec[uSpec++] = cConversion;
+			acSpec[uSpec] = '\0';
+			snprintf(acValue, sizeof(acValue), acSpec, (double) fValue);
+		} else if (iLongLong) {
+			uint64_t u64Value = 0;
+			iOk = TakeArg(pxArgs, &u64Value, sizeof(u64Value)) == 0;
+			acSpec[uSpec++] = 'l';
+			acSpec[uSpec++] = 'l';
+			acSpec[uSpec++] = cConversion;
+			acSpec[uSpec] = '\0';
+			snprintf(acValue, sizeof(acValue), acSpec, (unsigned long long) u64Value);
+		} else if (cConversion == 'p') {
+			uint32_t u32Value = 0;
+			iOk = TakeArg(pxArgs, &u32Value, sizeof(u32Value)) == 0;
+			snprintf(acValue, sizeof(acValue), "0x%08x", u32Value);
+		} else {
+			// d, i, u, x, X, o, c: 4 bytes on the target
+			uint32_t u32Value = 0;
+			iOk = TakeArg(pxArgs, &u32Value, sizeof(u32Value)) == 0;
+			acSpec[uSpec++] = cConversion;
+			acSpec[uSpec] = '\0';
+			if (cConversion == 'd' || cConversion == 'i') {
+				snprintf(acValue, sizeof(acValue), acSpec, (int32_t) u32Value);
+			} else {
+				snprintf(acValue, sizeof(acValue), acSpec, u32Value);
+			}
+		}
+		if (!iOk) {
+			// Argument not sent, the record was full
+			snprintf(acValue, sizeof(acValue), "<?>");
+		}
+		uOut += snprintf(&pcOut[uOut], uSize - uOut, "%s", acValue);
+		if (uOut >= uSize) {
+			uOut = uSize - 1;
+		}
+	}
+}
+
+static int TakeArg(Args_t *pxArgs, void *pvValue, size_t uSize) {
+	if (pxArgs->uOffset + uSize > pxArgs->uLen) {
+		pxArgs->uOffset = pxArgs->uLen;
+		return -1;
+	}
+	// The host is little endian as the target
+	memcpy(pvValue, &pxArgs->pu8Data[pxArgs->uOffset], uSize);
+	pxArgs->uOffset += uSize;
+	return 0;
+}
+
+static void Usage(const char *pcName) {
+	fprintf(stderr, "Usage: %s [-n] firmware.elf [capture]\n"
+			"  -n  no colors\n"
+			"  Reads the UART output on stdin or in the capture file\n", pcName);
+}
@@ -0,0 +1,239 @@
+/**
+ ************************************************************************************************************
+ *  \file               fusion_replay.c
+ *  \brief              Host replay of an event trace: state TPDOs without and with the fusion (0x2110)
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ *
+ *  Build and run from this directory:
+ *      gcc -O2 -I../../Components/App -o fusion_replay fusion_replay.c ../../Components/App/Src/fusion.c
+ *      ./fusion_replay traces/sample.csv
+ *
+ *  Trace format, one event per line, sorted by time ('#' starts a comment):
+ *      <ms>,motion          motion sensor edge
+ *      <ms>,vibration       vibration sensor edge (first edge or chained counting window)
+ *      <ms>,rate,<n>        vibration pulse rate (0x2100 sub 1), in pulses/s
+ *
+ *  Without the fusion, a TPDO is sent every time a channel is triggered or released (the hold
+ *  time is emulated, the input level is not). With the fusion, a TPDO is sent every time the
+ *  fused state changes. The main loop is emulated with a 10ms period.
+ */
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+#include "Inc/fusion.h"
+/************************************************************************************************************
+ * Local define
+ ************************************************************************************************************/
+#define REPLAY_LOOP_MS           (10)
+#define REPLAY_HOLD_MS           (5000)
+#define REPLAY_MAX_EVENTS        (100000)
+/************************************************************************************************************
+ * Local Types
+ ************************************************************************************************************/
+typedef enum {
+	EVENT_MOTION,
+	EVENT_VIBRATION,
+	EVENT_RATE,
+} EventType_t;
+
+typedef struct {
+	uint32_t u32Ms;
+	EventType_t eType;
+	uint16_t u16Rate;
+} Event_t;
+/************************************************************************************************************
+ * Local data
+ ************************************************************************************************************/
+static Event_t g_axEvents[REPLAY_MAX_EVENTS];
+static size_t g_uEventCount = 0;
+/************************************************************************************************************
+ * Local function prototypes
+ ************************************************************************************************************/
+static int LoadTrace(FILE *pxFile);
+static void Usage(const char *pcName);
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+int main(int argc, char *argv[]) {
+	// Default values of 0x2110
+	FusionParameters_t xParameters = {
+		.u8Enable = 1,
+		.u16WindowMs = 3000,
+		.u8MinEvidence = 2,
+		.u8SuspectConfidence = 30,
+		.u8ConfirmConfidence = 80,
+		.u16VibrationRate = 20,
+	};
+	uint32_t u32HoldMs = REPLAY_HOLD_MS;
+	int iVerbose = 0;
+	int iOption;
+
+	while ((iOption = getopt(argc, argv, "w:e:s:c:r:H:vh")) != -1) {
+		switch (iOption) {
+		case 'w':
+			xParameters.u16WindowMs = atoi(optarg);
+			break;
+		case 'e':
+			xParameters.u8MinEvidence = atoi(optarg);
+			break;
+		case 's':
+			xParameters.u8SuspectConfidence = atoi(optarg);
+			break;
+		case 'c':
+			xParameters.u8ConfirmConfidence = atoi(optarg);
+			break;
+		case 'r':
+			xParameters.u16VibrationRate = atoi(optarg);
+			break;
+		case 'H':
+			u32HoldMs = atoi(optarg);
+			break;
+		case 'v':
+			iVerbose = 1;
+			break;
+		default:
+			Usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE *pxFile = stdin;
+	if (optind < argc) {
+		pxFile = fopen(argv[optind], "r");
+		if (pxFile == NULL) {
+			perror(argv[optind]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (LoadTrace(pxFile) != 0) {
+		return EXIT_FAILURE;
+	}
+	if (g_uEventCount == 0) {
+		fprintf(stderr, "Empty trace\n");
+		return EXIT_FAILURE;
+	}
+
+	// Channel 0 is the motion sensor, channel 1 the vibration sensor
+	uint32_t au32LastEdge[2] = { 0, 0 };
+	uint8_t u8RawState = 0;
+	uint16_t u16Rate = 0;
+	unsigned uRawFrames = 0;
+	unsigned uFusedFrames = 0;
+	unsigned uEdges = 0;
+	size_t uNext = 0;
+	uint32_t u32End = g_axEvents[g_uEventCount - 1].u32Ms + u32HoldMs
+			+ xParameters.u16WindowMs + REPLAY_LOOP_MS;
+
+	FUSION_Init();
+	for (uint32_t t = g_axEvents[0].u32Ms; t <= u32End; t += REPLAY_LOOP_MS) {
+		uint8_t u8NewState = u8RawState;
+		while (uNext < g_uEventCount && g_axEvents[uNext].u32Ms <= t) {
+			const Event_t *pxEvent = &g_axEvents[uNext++];
+			if (pxEvent->eType == EVENT_RATE) {
+				u16Rate = pxEvent->u16Rate;
+				continue;
+			}
+			uint8_t u8Channel = (pxEvent->eType == EVENT_MOTION) ? 0 : 1;
+			au32LastEdge[u8Channel] = pxEvent->u32Ms;
+			u8NewState |= 1U << u8Channel;
+			uEdges++;
+			FUSION_AddEvidence(pxEvent->u32Ms,
+					(pxEvent->eType == EVENT_MOTION) ?
+							FUSION_SOURCE_MOTION : FUSION_SOURCE_VIBRATION);
+		}
+		for (uint8_t i = 0; i < 2; i++) {
+			if ((u8NewState & (1U << i)) && (t - au32LastEdge[i] >= u32HoldMs)) {
+				u8NewState &= ~(1U << i);
+			}
+		}
+		if (u8NewState != u8RawState) {
+			u8RawState = u8NewState;
+			uRawFrames++;
+		}
+
+		FusionStatus_t xStatus;
+		if (FUSION_Process(t, &xParameters, u16Rate, &xStatus)) {
+			uFusedFrames++;
+			if (iVerbose) {
+				printf("%10u ms: fused state %u (confidence %u%%)\n", t,
+						xStatus.u8State, xStatus.u8Confidence);
+			}
+		}
+	}
+
+	printf("Sensor edges:        %u\n", uEdges);
+	printf("TPDOs without fusion: %u\n", uRawFrames);
+	printf("TPDOs with fusion:    %u\n", uFusedFrames);
+	if (uRawFrames != 0) {
+		printf("Reduction:           %.1f %%\n",
+				100.0 * (double) ((int) uRawFrames - (int) uFusedFrames)
+						/ uRawFrames);
+	}
+	return EXIT_SUCCESS;
+}
+/************************************************************************************************************
+ * Local functions declaration
+ ************************************************************************************************************/
+static int LoadTrace(FILE *pxFile) {
+	char acLine[128];
+	unsigned uLine = 0;
+
+	while (fgets(acLine, sizeof(acLine), pxFile) != NULL) {
+		uLine++;
+		char *pcComment = strchr(acLine, '#');
+		if (pcComment != NULL) {
+			*pcComment = '\0';
+		}
+		char *pcTime = strtok(acLine, ", \t\r\n");
+		if (pcTime == NULL) {
+			continue;
+		}
+		char *pcType = strtok(NULL, ", \t\r\n");
+		char *pcValue = strtok(NULL, ", \t\r\n");
+		if (pcType == NULL || g_uEventCount >= REPLAY_MAX_EVENTS) {
+			fprintf(stderr, "Line %u: invalid event\n", uLine);
+			return -1;
+		}
+
+		Event_t *pxEvent = &g_axEvents[g_uEventCount];
+		pxEvent->u32Ms = strtoul(pcTime, NULL, 0);
+		pxEvent->u16Rate = 0;
+		if (strcmp(pcType, "motion") == 0) {
+			pxEvent->eType = EVENT_MOTION;
+		} else if (strcmp(pcType, "vibration") == 0) {
+			pxEvent->eType = EVENT_VIBRATION;
+		} else if (strcmp(pcType, "rate") == 0 && pcValue != NULL) {
+			pxEvent->eType = EVENT_RATE;
+			pxEvent->u16Rate = strtoul(pcValue, NULL, 0);
+		} else {
+			fprintf(stderr, "Line %u: unknown event '%s'\n", uLine, pcType);
+			return -1;
+		}
+		if (g_uEventCount > 0
+				&& pxEvent->u32Ms < g_axEvents[g_uEventCount - 1].u32Ms) {
+			fprintf(stderr, "Line %u: events are not sorted\n", uLine);
+			return -1;
+		}
+		g_uEventCount++;
+	}
+	return 0;
+}
+
+static void Usage(const char *pcName) {
+	fprintf(stderr,
+			"Usage: %s [-w window_ms] [-e min_evidence] [-s suspect_%%] "
+					"[-c confirm_%%] [-r vibration_rate] [-H hold_ms] [-v] [trace.csv]\n",
+			pcName);
+}
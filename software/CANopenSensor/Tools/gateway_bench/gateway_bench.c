@@ -0,0 +1,458 @@
+/**
+ ************************************************************************************************************
+ *  \file               gateway_bench.c
+ *  \brief              Host benchmark of the SDO uploads through the ASCII and the binary gateways
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ *
+ *  Build and run from this directory, with the shell of the board on /dev/ttyACM0:
+ *      gcc -O2 -o gateway_bench gateway_bench.c
+ *      ./gateway_bench -n 5 -i 0x1018 -s 1 -c 1000 -w 8 /dev/ttyACM0
+ *
+ *  The same upload is read count times through the "gateway" command (CiA 309-3 ASCII) and through
+ *  the "gateway-bin" command (CO_gatewayBin_STM32.h), with up to window requests in flight in both
+ *  cases. The shell must be in interactive mode and the logs should be off ("log level all 0"), the
+ *  gateways drop them but they use the UART until the command is run.
+ */
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+/************************************************************************************************************
+ * Local define
+ ************************************************************************************************************/
+// Same values as CO_gatewayBin_STM32.h
+#define GWB_SDO                  (0x03)
+#define GWB_STATUS               (0x04)
+#define GWB_CLOSE                (0x05)
+#define GWB_RESULTS              (0x83)
+#define GWB_NACK                 (0x8F)
+#define GWB_FRAME_MAX            (255)
+
+#define BENCH_TIMEOUT_MS         (2000)
+#define BENCH_MAX_WINDOW         (64)
+#define BENCH_LINE_MAX           (256)
+#define ASCII_EXIT               (0x04)
+/************************************************************************************************************
+ * Local Types
+ ************************************************************************************************************/
+typedef struct {
+	unsigned uDone;
+	unsigned uAborts;
+	unsigned long ulTx;
+	unsigned long ulRx;
+	double dSeconds;
+} Result_t;
+/************************************************************************************************************
+ * Local data
+ ************************************************************************************************************/
+static int g_iFd = -1;
+static unsigned long g_ulTx = 0;
+static unsigned long g_ulRx = 0;
+// Binary frame being decoded
+static uint8_t g_au8Frame[GWB_FRAME_MAX + 2];
+static size_t g_uFrameLen = 0;
+static uint8_t g_u8Code = 0;
+static uint8_t g_u8Block = 0;
+static int g_iFrameError = 0;
+static uint8_t g_u8Credits = 0;
+/************************************************************************************************************
+ * Local function prototypes
+ ************************************************************************************************************/
+static int OpenPort(const char *pcPath, speed_t xSpeed);
+static double Now(void);
+static void Send(const void *pvData, size_t uLen);
+static int Receive(uint8_t *pu8Byte, int iTimeoutMs);
+static void Drain(int iTimeoutMs);
+static uint16_t Crc16(const uint8_t *pu8Data, size_t uLen);
+static void SendFrame(const uint8_t *pu8Data, size_t uLen);
+static int ReceiveFrame(int iTimeoutMs);
+static int BenchAscii(unsigned uNode, unsigned uIndex, unsigned uSub,
+		unsigned uCount, unsigned uWindow, Result_t *pxResult);
+static int BenchBinary(unsigned uNode, unsigned uIndex, unsigned uSub,
+		unsigned uCount, unsigned uWindow, Result_t *pxResult);
+static void Print(const char *pcName, const Result_t *pxResult);
+static void Usage(const char *pcName);
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+int main(int argc, char *argv[]) {
+	unsigned uNode = 5;
+	unsigned uIndex = 0x1018;
+	unsigned uSub = 1;
+	unsigned uCount = 1000;
+	unsigned uWindow = 8;
+	speed_t xSpeed = B115200;
+	int iOption;
+
+	while ((iOption = getopt(argc, argv, "n:i:s:c:w:h")) != -1) {
+		switch (iOption) {
+		case 'n':
+			uNode = strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			uIndex = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			uSub = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			uCount = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			uWindow = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			Usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind >= argc || uWindow == 0 || uWindow > BENCH_MAX_WINDOW
+			|| uCount == 0) {
+		Usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (OpenPort(argv[optind], xSpeed) != 0) {
+		return EXIT_FAILURE;
+	}
+
+	Result_t xAscii;
+	Result_t xBinary;
+	if (BenchAscii(uNode, uIndex, uSub, uCount, uWindow, &xAscii) != 0) {
+		return EXIT_FAILURE;
+	}
+	Print("ASCII gateway", &xAscii);
+	if (BenchBinary(uNode, uIndex, uSub, uCount, uWindow, &xBinary) != 0) {
+		return EXIT_FAILURE;
+	}
+	Print("Binary gateway", &xBinary);
+	if (xAscii.dSeconds > 0 && xBinary.dSeconds > 0) {
+		printf("Speed-up:        %.1f x\n",
+				(xBinary.uDone / xBinary.dSeconds)
+						/ (xAscii.uDone / xAscii.dSeconds));
+	}
+	close(g_iFd);
+	return EXIT_SUCCESS;
+}
+/************************************************************************************************************
+ * Local functions declaration
+ ************************************************************************************************************/
+static int OpenPort(const char *pcPath, speed_t xSpeed) {
+	struct termios xTerm;
+
+	g_iFd = open(pcPath, O_RDWR | O_NOCTTY);
+	if (g_iFd < 0) {
+		perror(pcPath);
+		return -1;
+	}
+	if (tcgetattr(g_iFd, &xTerm) != 0) {
+		perror(pcPath);
+		return -1;
+	}
+	cfmakeraw(&xTerm);
+	cfsetispeed(&xTerm, xSpeed);
+	cfsetospeed(&xTerm, xSpeed);
+	if (tcsetattr(g_iFd, TCSANOW, &xTerm) != 0) {
+		perror(pcPath);
+		return -1;
+	}
+	tcflush(g_iFd, TCIOFLUSH);
+	return 0;
+}
+
+static double Now(void) {
+	struct timespec xTime;
+	clock_gettime(CLOCK_MONOTONIC, &xTime);
+	return xTime.tv_sec + xTime.tv_nsec / 1e9;
+}
+
+static void Send(const void *pvData, size_t uLen) {
+	const uint8_t *pu8Data = pvData;
+	while (uLen > 0) {
+		ssize_t iWritten = write(g_iFd, pu8Data, uLen);
+		if (iWritten < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("write");
+			exit(EXIT_FAILURE);
+		}
+		pu8Data += iWritten;
+		uLen -= iWritten;
+		g_ulTx += iWritten;
+	}
+}
+
+// Returns 1 with a byte, 0 on timeout
+static int Receive(uint8_t *pu8Byte, int iTimeoutMs) {
+	fd_set xSet;
+	struct timeval xTimeout = { iTimeoutMs / 1000, (iTimeoutMs % 1000) * 1000 };
+
+	FD_ZERO(&xSet);
+	FD_SET(g_iFd, &xSet);
+	if (select(g_iFd + 1, &xSet, NULL, NULL, &xTimeout) <= 0) {
+		return 0;
+	}
+	if (read(g_iFd, pu8Byte, 1) != 1) {
+		return 0;
+	}
+	g_ulRx++;
+	return 1;
+}
+
+// Skips the echo and the text of the shell
+static void Drain(int iTimeoutMs) {
+	uint8_t u8Byte;
+	while (Receive(&u8Byte, iTimeoutMs)) {
+	}
+}
+
+// crc16_ccitt of CANopenNode, initial value 0
+static uint16_t Crc16(const uint8_t *pu8Data, size_t uLen) {
+	uint16_t u16Crc = 0;
+	for (size_t i = 0; i < uLen; i++) {
+		u16Crc ^= (uint16_t) pu8Data[i] << 8;
+		for (int b = 0; b < 8; b++) {
+			u16Crc = (u16Crc & 0x8000) ? (u16Crc << 1) ^ 0x1021 : u16Crc << 1;
+		}
+	}
+	return u16Crc;
+}
+
+static void SendFrame(const uint8_t *pu8Data, size_t uLen) {
+	uint8_t au8Raw[GWB_FRAME_MAX + 2];
+	uint8_t au8Encoded[GWB_FRAME_MAX + 8];
+	size_t uCode = 0;
+	size_t uOut = 1;
+	uint8_t u8Run = 1;
+
+	memcpy(au8Raw, pu8Data, uLen);
+	uint16_t u16Crc = Crc16(pu8Data, uLen);
+	au8Raw[uLen++] = u16Crc & 0xFF;
+	au8Raw[uLen++] = u16Crc >> 8;
+
+	for (size_t i = 0; i < uLen; i++) {
+		if (au8Raw[i] != 0) {
+			au8Encoded[uOut++] = au8Raw[i];
+			u8Run++;
+		}
+		if (au8Raw[i] == 0 || u8Run == 0xFF) {
+			au8Encoded[uCode] = u8Run;
+			uCode = uOut++;
+			u8Run = 1;
+		}
+	}
+	au8Encoded[uCode] = u8Run;
+	au8Encoded[uOut++] = 0;
+	Send(au8Encoded, uOut);
+}
+
+// Decodes the next valid frame in g_au8Frame (without the CRC), returns its length or -1 on timeout
+static int ReceiveFrame(int iTimeoutMs) {
+	uint8_t u8Byte;
+
+	while (Receive(&u8Byte, iTimeoutMs)) {
+		if (u8Byte == 0) {
+			int iValid = !g_iFrameError && g_u8Block == 0 && g_uFrameLen >= 4
+					&& Crc16(g_au8Frame, g_uFrameLen - 2)
+							== (g_au8Frame[g_uFrameLen - 2]
+									| (g_au8Frame[g_uFrameLen - 1] << 8));
+			size_t uLen = g_uFrameLen - 2;
+			g_uFrameLen = 0;
+			g_u8Code = 0;
+			g_u8Block = 0;
+			g_iFrameError = 0;
+			if (iValid) {
+				g_u8Credits = g_au8Frame[1];
+				return (int) uLen;
+			}
+		} else if (g_u8Block == 0) {
+			if (g_u8Code != 0 && g_u8Code != 0xFF) {
+				if (g_uFrameLen < sizeof(g_au8Frame)) {
+					g_au8Frame[g_uFrameLen++] = 0;
+				} else {
+					g_iFrameError = 1;
+				}
+			}
+			g_u8Code = u8Byte;
+			g_u8Block = u8Byte - 1;
+		} else {
+			if (g_uFrameLen < sizeof(g_au8Frame)) {
+				g_au8Frame[g_uFrameLen++] = u8Byte;
+			} else {
+				g_iFrameError = 1;
+			}
+			g_u8Block--;
+		}
+	}
+	return -1;
+}
+
+static int BenchAscii(unsigned uNode, unsigned uIndex, unsigned uSub,
+		unsigned uCount, unsigned uWindow, Result_t *pxResult) {
+	char acLine[BENCH_LINE_MAX];
+	size_t uLineLen = 0;
+	unsigned uSent = 0;
+	uint8_t u8Byte;
+
+	memset(pxResult, 0, sizeof(*pxResult));
+	Send("gateway\r", 8);
+	Drain(200);
+	g_ulTx = 0;
+	g_ulRx = 0;
+
+	double dStart = Now();
+	while (pxResult->uDone < uCount) {
+		while (uSent < uCount && (uSent - pxResult->uDone) < uWindow) {
+			int iLen = snprintf(acLine, sizeof(acLine),
+					"[%u] %u read 0x%04X %u u32\r\n", uSent + 1, uNode, uIndex,
+					uSub);
+			Send(acLine, iLen);
+			uSent++;
+		}
+		uLineLen = 0;
+		do {
+			if (!Receive(&u8Byte, BENCH_TIMEOUT_MS)) {
+				fprintf(stderr, "ASCII gateway: no response after %u reads\n",
+						pxResult->uDone);
+				return -1;
+			}
+			if (uLineLen < sizeof(acLine) - 1) {
+				acLine[uLineLen++] = u8Byte;
+			}
+		} while (u8Byte != '\n');
+		acLine[uLineLen] = '\0';
+		if (acLine[0] == '[') {
+			pxResult->uDone++;
+			if (strstr(acLine, "ERROR") != NULL) {
+				pxResult->uAborts++;
+			}
+		}
+	}
+	pxResult->dSeconds = Now() - dStart;
+	pxResult->ulTx = g_ulTx;
+	pxResult->ulRx = g_ulRx;
+
+	u8Byte = ASCII_EXIT;
+	Send(&u8Byte, 1);
+	Drain(200);
+	return 0;
+}
+
+static int BenchBinary(unsigned uNode, unsigned uIndex, unsigned uSub,
+		unsigned uCount, unsigned uWindow, Result_t *pxResult) {
+	uint8_t au8Request[GWB_FRAME_MAX];
+	unsigned uSent = 0;
+	int iLen;
+
+	memset(pxResult, 0, sizeof(*pxResult));
+	Send("gateway-bin\r", 12);
+	Drain(200);
+	// A delimiter ends what the decoder of the board may hold, then the status gives the credits
+	au8Request[0] = 0;
+	Send(au8Request, 1);
+	au8Request[0] = GWB_STATUS;
+	SendFrame(au8Request, 1);
+	while ((iLen = ReceiveFrame(BENCH_TIMEOUT_MS)) >= 0
+			&& g_au8Frame[0] != GWB_STATUS) {
+	}
+	if (iLen < 0) {
+		fprintf(stderr, "Binary gateway: no status\n");
+		return -1;
+	}
+	g_ulTx = 0;
+	g_ulRx = 0;
+
+	double dStart = Now();
+	while (pxResult->uDone < uCount) {
+		// One frame with all the requests the credits and the window allow
+		unsigned uInFlight = uSent - pxResult->uDone;
+		unsigned uBatch = uWindow - uInFlight;
+		if (uBatch > g_u8Credits) {
+			uBatch = g_u8Credits;
+		}
+		if (uBatch > uCount - uSent) {
+			uBatch = uCount - uSent;
+		}
+		if (uBatch > 0) {
+			size_t uPos = 0;
+			au8Request[uPos++] = GWB_SDO;
+			for (unsigned i = 0; i < uBatch; i++) {
+				au8Request[uPos++] = (uint8_t) (uSent + i);
+				au8Request[uPos++] = uNode;
+				au8Request[uPos++] = uIndex & 0xFF;
+				au8Request[uPos++] = uIndex >> 8;
+				au8Request[uPos++] = uSub;
+				au8Request[uPos++] = 0;
+			}
+			SendFrame(au8Request, uPos);
+			uSent += uBatch;
+			g_u8Credits -= uBatch;
+		}
+
+		iLen = ReceiveFrame(BENCH_TIMEOUT_MS);
+		if (iLen < 0) {
+			fprintf(stderr, "Binary gateway: no response after %u reads\n",
+					pxResult->uDone);
+			return -1;
+		}
+		if (g_au8Frame[0] == GWB_NACK) {
+			fprintf(stderr, "Binary gateway: frame 0x%02X rejected (%u)\n",
+					g_au8Frame[2], g_au8Frame[3]);
+			return -1;
+		}
+		if (g_au8Frame[0] != GWB_RESULTS) {
+			continue;
+		}
+		for (int iPos = 2; iPos + 6 <= iLen;
+				iPos += 6 + g_au8Frame[iPos + 5]) {
+			uint32_t u32Abort = g_au8Frame[iPos + 1]
+					| (g_au8Frame[iPos + 2] << 8) | (g_au8Frame[iPos + 3] << 16)
+					| ((uint32_t) g_au8Frame[iPos + 4] << 24);
+			pxResult->uDone++;
+			if (u32Abort != 0) {
+				pxResult->uAborts++;
+			}
+		}
+	}
+	pxResult->dSeconds = Now() - dStart;
+	pxResult->ulTx = g_ulTx;
+	pxResult->ulRx = g_ulRx;
+
+	au8Request[0] = GWB_CLOSE;
+	SendFrame(au8Request, 1);
+	while ((iLen = ReceiveFrame(BENCH_TIMEOUT_MS)) >= 0
+			&& g_au8Frame[0] != GWB_STATUS) {
+	}
+	Drain(200);
+	return 0;
+}
+
+static void Print(const char *pcName, const Result_t *pxResult) {
+	printf("%s:\n", pcName);
+	printf("  Uploads:       %u (%u aborted)\n", pxResult->uDone,
+			pxResult->uAborts);
+	printf("  Time:          %.3f s\n", pxResult->dSeconds);
+	printf("  Uploads/s:     %.1f\n", pxResult->uDone / pxResult->dSeconds);
+	printf("  UART bytes:    %lu sent, %lu received (%.1f per upload)\n",
+			pxResult->ulTx, pxResult->ulRx,
+			(double) (pxResult->ulTx + pxResult->ulRx) / pxResult->uDone);
+}
+
+static void Usage(const char *pcName) {
+	fprintf(stderr,
+			"Usage: %s [-n node] [-i index] [-s sub-index] [-c count] [-w window] device\n",
+			pcName);
+}
@@ -0,0 +1,422 @@
+/**
+ ************************************************************************************************************
+ *  \file               gateway_test.c
+ *  \brief              Host test of the binary gateway framing: COBS and CRC, firmware against gateway_bench
+ *  \author             caipiblack
+ *  \version            1.0
+ *  \date               01/06/2024
+ *  \copyright
+ ************************************************************************************************************
+ *
+ *  Build and run from this directory:
+ *      gcc -O2 -DCO_CONFIG_STM32_PROFILE=0 -Ihost -I../../CANopenNode_STM32 -I../../CANopenNode \
+ *          -o gateway_test gateway_test.c ../../CANopenNode/301/crc16-ccitt.c
+ *      ./gateway_test
+ *
+ *  The firmware gateway (CO_gatewayBin_STM32.c) and the host side of the benchmark (gateway_bench.c) are
+ *  built together, connected by a socket pair. The SDO client and the CAN driver are replaced by stubs:
+ *  an upload returns a known pattern, a download records its data. Checked:
+ *  - the CRC of the benchmark against crc16_ccitt of CANopenNode;
+ *  - frames encoded by the firmware and decoded by the benchmark, every length and data pattern;
+ *  - frames encoded by the benchmark and decoded by the firmware, through SDO downloads;
+ *  - corrupted frames (CRC, truncated COBS block) are answered with a NACK.
+ *  The exit code is 0 when every check passed.
+ */
+/************************************************************************************************************
+ * Project included files
+ ************************************************************************************************************/
+// The firmware file is included for its static COBS encoder, the benchmark for its frame functions
+#include "CO_gatewayBin_STM32.c"
+#define main GatewayBenchMain
+#include "gateway_bench.c"
+#undef main
+/************************************************************************************************************
+ * Standard included files
+ ************************************************************************************************************/
+#include <sys/socket.h>
+/************************************************************************************************************
+ * Local define
+ ************************************************************************************************************/
+#define TEST_NODE                (5)
+#define TEST_INDEX               (0x2131)
+#define TEST_TIMEOUT_MS          (100)
+#define TEST_DOWNLOAD_MAX        (1024)
+/************************************************************************************************************
+ * Local Types
+ ************************************************************************************************************/
+typedef enum {
+	PATTERN_ZERO = 0,        // Only zeros, one COBS block per byte
+	PATTERN_NON_ZERO,        // No zero, full blocks of 254 bytes
+	PATTERN_RANDOM,          // Zeros at random places
+	PATTERN_BLOCK_EDGE,      // Zeros around the 254 bytes block boundaries
+	PATTERN_COUNT
+} Pattern_t;
+/************************************************************************************************************
+ * Local data
+ ************************************************************************************************************/
+static int g_iGatewayFd = -1;
+static CO_GWB_t g_xGateway;
+static CO_CANmodule_t g_xCanModule;
+static CO_SDOclient_t g_xSdoClient;
+static unsigned g_uFailures = 0;
+
+// SDO client stub
+static uint16_t g_u16SdoIndex = 0;
+static uint8_t g_u8SdoSub = 0;
+static uint8_t g_u8SdoStep = 0;
+static uint8_t g_au8Download[TEST_DOWNLOAD_MAX];
+static size_t g_uDownloadLen = 0;
+/************************************************************************************************************
+ * Local macros
+ ************************************************************************************************************/
+#define CHECK(cond, fmt, ...)	do {											\
+									if (!(cond)) {								\
+										printf("  FAIL %s:%d: " fmt "\n",		\
+												__FILE__, __LINE__, ##__VA_ARGS__);	\
+										g_uFailures++;							\
+									}											\
+								} while (0)
+/************************************************************************************************************
+ * Local function prototypes
+ ************************************************************************************************************/
+static uint8_t PatternByte(Pattern_t ePattern, size_t uPos);
+static uint8_t UploadByte(uint8_t u8Sub, size_t uPos);
+static size_t GatewayWrite(void *pvObject, const uint8_t *pu8Buf, size_t uCount);
+static void GatewayClose(void *pvObject);
+static void Pump(void);
+static void TestCrc(void);
+static void TestEncode(void);
+static void TestDecode(void);
+static void TestUpload(void);
+static void TestCorrupted(void);
+/************************************************************************************************************
+ * Exported functions declaration
+ ************************************************************************************************************/
+int main(void) {
+	int aiSockets[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockets) != 0) {
+		perror("socketpair");
+		return EXIT_FAILURE;
+	}
+	g_iFd = aiSockets[0];
+	g_iGatewayFd = aiSockets[1];
+	srand(1);
+
+	CO_GWB_init(&g_xGateway, GatewayWrite, GatewayClose, NULL);
+	CO_GWB_initCANopen(&g_xGateway, &g_xCanModule, &g_xSdoClient);
+
+	TestCrc();
+	TestEncode();
+	TestDecode();
+	TestUpload();
+	TestCorrupted();
+
+	printf("%s: %u failure(s)\n", (g_uFailures == 0) ? "PASS" : "FAIL",
+			g_uFailures);
+	return (g_uFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// SDO client and CAN driver stubs, called by the firmware gateway
+CO_SDO_return_t CO_SDOclient_setup(CO_SDOclient_t *SDO_C,
+		uint32_t COB_IDClientToServer, uint32_t COB_IDServerToClient,
+		uint8_t nodeIDOfTheSDOServer) {
+	return CO_SDO_RT_ok_communicationEnd;
+}
+
+CO_SDO_return_t CO_SDOclientUploadInitiate(CO_SDOclient_t *SDO_C,
+		uint16_t index, uint8_t subIndex, uint16_t SDOtimeoutTime_ms,
+		bool_t blockEnable) {
+	g_u16SdoIndex = index;
+	g_u8SdoSub = subIndex;
+	g_u8SdoStep = 0;
+	return CO_SDO_RT_ok_communicationEnd;
+}
+
+CO_SDO_return_t CO_SDOclientDownloadInitiate(CO_SDOclient_t *SDO_C,
+		uint16_t index, uint8_t subIndex, size_t sizeIndicated,
+		uint16_t SDOtimeoutTime_ms, bool_t blockEnable) {
+	g_u16SdoIndex = index;
+	g_u8SdoSub = subIndex;
+	return CO_SDO_RT_ok_communicationEnd;
+}
+
+// The upload answers on the second call, with the size in the sub-index
+CO_SDO_return_t CO_SDOclientUpload(CO_SDOclient_t *SDO_C,
+		uint32_t timeDifference_us, bool_t abort,
+		CO_SDO_abortCode_t *SDOabortCode, size_t *sizeIndicated,
+		size_t *sizeTransferred, uint32_t *timerNext_us) {
+	if (abort) {
+		return CO_SDO_RT_endedWithClientAbort;
+	}
+	if (g_u8SdoStep++ == 0) {
+		return CO_SDO_RT_waitingResponse;
+	}
+	return CO_SDO_RT_ok_communicationEnd;
+}
+
+size_t CO_SDOclientUploadBufRead(CO_SDOclient_t *SDO_C, uint8_t *buf,
+		size_t count) {
+	size_t uSize = (g_u8SdoSub < count) ? g_u8SdoSub : count;
+	for (size_t i = 0; i < uSize; i++) {
+		buf[i] = UploadByte(g_u8SdoSub, i);
+	}
+	return uSize;
+}
+
+size_t CO_SDOclientDownloadBufWrite(CO_SDOclient_t *SDO_C, const uint8_t *buf,
+		size_t count) {
+	if (g_uDownloadLen + count > sizeof(g_au8Download)) {
+		count = sizeof(g_au8Download) - g_uDownloadLen;
+	}
+	memcpy(&g_au8Download[g_uDownloadLen], buf, count);
+	g_uDownloadLen += count;
+	return count;
+}
+
+CO_SDO_return_t CO_SDOclientDownload(CO_SDOclient_t *SDO_C,
+		uint32_t timeDifference_us, bool_t abort, bool_t bufferPartial,
+		CO_SDO_abortCode_t *SDOabortCode, size_t *sizeTransferred,
+		uint32_t *timerNext_us) {
+	return bufferPartial ?
+			CO_SDO_RT_waitingResponse : CO_SDO_RT_ok_communicationEnd;
+}
+
+bool_t CO_CANsendNow(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer) {
+	return true;
+}
+/************************************************************************************************************
+ * Local functions declaration
+ ************************************************************************************************************/
+static uint8_t PatternByte(Pattern_t ePattern, size_t uPos) {
+	switch (ePattern) {
+	case PATTERN_ZERO:
+		return 0;
+	case PATTERN_NON_ZERO:
+		return (uint8_t) (1 + uPos % 255);
+	case PATTERN_RANDOM:
+		return ((rand() & 3) == 0) ? 0 : (uint8_t) rand();
+	case PATTERN_BLOCK_EDGE:
+	default:
+		return ((uPos % 254) == 253 || (uPos % 254) == 0) ? 0 : 0xA5;
+	}
+}
+
+static uint8_t UploadByte(uint8_t u8Sub, size_t uPos) {
+	return (uint8_t) ((uPos * 37 + u8Sub) & ((uPos & 1) ? 0xFF : 0x0F));
+}
+
+// Output of the firmware gateway, to the benchmark side of the socket
+static size_t GatewayWrite(void *pvObject, const uint8_t *pu8Buf, size_t uCount) {
+	ssize_t iWritten = write(g_iGatewayFd, pu8Buf, uCount);
+	return (iWritten > 0) ? (size_t) iWritten : 0;
+}
+
+static void GatewayClose(void *pvObject) {
+}
+
+// Gives the bytes sent by the benchmark to the firmware gateway, then runs it
+static void Pump(void) {
+	uint8_t au8Buf[4096];
+	ssize_t iRead;
+	size_t uLen = 0;
+
+	while ((iRead = recv(g_iGatewayFd, &au8Buf[uLen], sizeof(au8Buf) - uLen,
+			MSG_DONTWAIT)) > 0) {
+		uLen += iRead;
+	}
+	size_t uPos = 0;
+	for (unsigned uLoop = 0; uLoop < 1000; uLoop++) {
+		if (uPos < uLen) {
+			uPos += CO_GWB_write(&g_xGateway, &au8Buf[uPos], uLen - uPos);
+		}
+		CO_GWB_process(&g_xGateway, 1000, NULL);
+		if (uPos >= uLen && g_xGateway.reqRun == g_xGateway.reqHead
+				&& g_xGateway.reqTail == g_xGateway.reqRun
+				&& g_xGateway.txSent == g_xGateway.txLen) {
+			break;
+		}
+	}
+}
+
+static void TestCrc(void) {
+	static const uint8_t au8Check[] = "123456789";
+	uint8_t au8Buf[300];
+
+	printf("CRC\n");
+	CHECK(Crc16(au8Check, 9) == 0x31C3, "check value 0x%04X",
+			Crc16(au8Check, 9));
+	CHECK(crc16_ccitt(au8Check, 9, 0) == 0x31C3, "firmware check value 0x%04X",
+			crc16_ccitt(au8Check, 9, 0));
+	for (size_t uLen = 0; uLen <= sizeof(au8Buf); uLen++) {
+		for (size_t i = 0; i < uLen; i++) {
+			au8Buf[i] = (uint8_t) rand();
+		}
+		CHECK(Crc16(au8Buf, uLen) == crc16_ccitt(au8Buf, uLen, 0),
+				"length %zu", uLen);
+	}
+}
+
+// Every frame length and pattern, encoded by the firmware, decoded by the benchmark
+static void TestEncode(void) {
+	uint8_t au8Frame[CO_GWB_FRAME_MAX + 2];
+	uint8_t au8Encoded[sizeof(g_xGateway.txBuf)];
+
+	printf("Firmware encoder, benchmark decoder\n");
+	for (int iPattern = 0; iPattern < PATTERN_COUNT; iPattern++) {
+		for (uint16_t u16Len = 2; u16Len <= CO_GWB_FRAME_MAX; u16Len++) {
+			for (uint16_t i = 0; i < u16Len; i++) {
+				au8Frame[i] = PatternByte((Pattern_t) iPattern, i);
+			}
+			uint16_t u16Crc = crc16_ccitt(au8Frame, u16Len, 0);
+			au8Frame[u16Len] = u16Crc & 0xFF;
+			au8Frame[u16Len + 1] = u16Crc >> 8;
+
+			uint16_t u16Encoded = prv_cobs_encode(au8Frame, u16Len + 2,
+					au8Encoded);
+			CHECK(u16Encoded <= sizeof(au8Encoded),
+					"pattern %d length %u: %u bytes encoded", iPattern, u16Len,
+					u16Encoded);
+			CHECK(memchr(au8Encoded, 0, u16Encoded - 1) == NULL,
+					"pattern %d length %u: zero before the delimiter", iPattern,
+					u16Len);
+			GatewayWrite(NULL, au8Encoded, u16Encoded);
+			int iLen = ReceiveFrame(TEST_TIMEOUT_MS);
+			CHECK(iLen == u16Len && memcmp(g_au8Frame, au8Frame, u16Len) == 0,
+					"pattern %d length %u: decoded %d", iPattern, u16Len, iLen);
+		}
+	}
+}
+
+// Frames of the benchmark decoded by the firmware: SDO downloads, their data are recorded by the stub
+static void TestDecode(void) {
+	uint8_t au8Frame[CO_GWB_FRAME_MAX];
+	uint8_t au8Expected[CO_GWB_FRAME_MAX];
+
+	printf("Benchmark encoder, firmware decoder\n");
+	for (int iPattern = 0; iPattern < PATTERN_COUNT; iPattern++) {
+		// Largest frame: 3 downloads of CO_GWB_SDO_DATA_MAX bytes and one filling the frame
+		for (size_t uTotal = 1; uTotal <= CO_GWB_FRAME_MAX; uTotal++) {
+			size_t uLen = 1;
+			size_t uExpected = 0;
+			uint8_t u8Tag = 1;
+			au8Frame[0] = GWB_SDO;
+			while (uLen + SDO_HEAD_LEN < uTotal
+					&& u8Tag <= CO_GWB_SDO_SLOTS) {
+				size_t uSize = uTotal - uLen - SDO_HEAD_LEN;
+				if (uSize > CO_GWB_SDO_DATA_MAX) {
+					uSize = CO_GWB_SDO_DATA_MAX;
+				}
+				au8Frame[uLen++] = u8Tag++;
+				au8Frame[uLen++] = TEST_NODE;
+				au8Frame[uLen++] = TEST_INDEX & 0xFF;
+				au8Frame[uLen++] = TEST_INDEX >> 8;
+				au8Frame[uLen++] = 1;
+				au8Frame[uLen++] = (uint8_t) uSize;
+				for (size_t i = 0; i < uSize; i++) {
+					uint8_t u8Byte = PatternByte((Pattern_t) iPattern, uLen);
+					au8Frame[uLen++] = u8Byte;
+					au8Expected[uExpected++] = u8Byte;
+				}
+			}
+			if (uExpected == 0) {
+				continue;
+			}
+
+			g_uDownloadLen = 0;
+			SendFrame(au8Frame, uLen);
+			Pump();
+			CHECK(g_uDownloadLen == uExpected
+					&& memcmp(g_au8Download, au8Expected, uExpected) == 0,
+					"pattern %d frame %zu: %zu of %zu bytes downloaded",
+					iPattern, uLen, g_uDownloadLen, uExpected);
+			int iLen = ReceiveFrame(TEST_TIMEOUT_MS);
+			CHECK(iLen >= 2 && g_au8Frame[0] == GWB_RESULTS
+					&& iLen == (int) (2 + (u8Tag - 1) * RESULT_LEN),
+					"pattern %d frame %zu: results type 0x%02X length %d",
+					iPattern, uLen, g_au8Frame[0], iLen);
+		}
+	}
+}
+
+// Results carrying data, every upload size in one batch of requests
+static void TestUpload(void) {
+	uint8_t au8Frame[1 + CO_GWB_SDO_SLOTS * SDO_HEAD_LEN];
+
+	printf("Upload results\n");
+	for (unsigned uSize = 0; uSize <= CO_GWB_SDO_DATA_MAX; uSize += 8) {
+		size_t uLen = 1;
+		au8Frame[0] = GWB_SDO;
+		for (uint8_t u8Tag = 0; u8Tag < CO_GWB_SDO_SLOTS; u8Tag++) {
+			au8Frame[uLen++] = u8Tag;
+			au8Frame[uLen++] = TEST_NODE;
+			au8Frame[uLen++] = TEST_INDEX & 0xFF;
+			au8Frame[uLen++] = TEST_INDEX >> 8;
+			au8Frame[uLen++] = (uint8_t) (uSize + u8Tag % 8);
+			au8Frame[uLen++] = 0;
+		}
+		SendFrame(au8Frame, uLen);
+		Pump();
+
+		uint8_t u8Next = 0;
+		int iLen;
+		while (u8Next < CO_GWB_SDO_SLOTS
+				&& (iLen = ReceiveFrame(TEST_TIMEOUT_MS)) >= 0) {
+			CHECK(g_au8Frame[0] == GWB_RESULTS, "size %u: type 0x%02X", uSize,
+					g_au8Frame[0]);
+			for (int iPos = 2; iPos + (int) RESULT_LEN <= iLen;) {
+				uint8_t u8Tag = g_au8Frame[iPos];
+				uint8_t u8Sub = (uint8_t) (uSize + u8Tag % 8);
+				uint8_t u8Got = g_au8Frame[iPos + 5];
+				uint8_t u8Want = (u8Sub > CO_GWB_SDO_DATA_MAX) ?
+						CO_GWB_SDO_DATA_MAX : u8Sub;
+				CHECK(u8Tag == u8Next && u8Got == u8Want,
+						"size %u: tag %u (%u expected) size %u (%u expected)",
+						uSize, u8Tag, u8Next, u8Got, u8Want);
+				for (uint8_t i = 0; i < u8Got && i < u8Want; i++) {
+					CHECK(g_au8Frame[iPos + RESULT_LEN + i] == UploadByte(u8Sub, i),
+							"size %u tag %u byte %u", uSize, u8Tag, i);
+				}
+				iPos += RESULT_LEN + u8Got;
+				u8Next++;
+			}
+		}
+		CHECK(u8Next == CO_GWB_SDO_SLOTS, "size %u: %u results", uSize, u8Next);
+	}
+}
+
+// A wrong CRC and a truncated COBS block are rejected, the next frame is read
+static void TestCorrupted(void) {
+	uint8_t au8Frame[8];
+	uint8_t au8Encoded[16];
+
+	printf("Corrupted frames\n");
+	au8Frame[0] = GWB_STATUS;
+	uint16_t u16Crc = crc16_ccitt(au8Frame, 1, 0) ^ 0x0100;
+	au8Frame[1] = u16Crc & 0xFF;
+	au8Frame[2] = u16Crc >> 8;
+	uint16_t u16Encoded = prv_cobs_encode(au8Frame, 3, au8Encoded);
+	Send(au8Encoded, u16Encoded);
+	Pump();
+	int iLen = ReceiveFrame(TEST_TIMEOUT_MS);
+	CHECK(iLen == 4 && g_au8Frame[0] == GWB_NACK
+			&& g_au8Frame[3] == CO_GWB_NACK_FRAME,
+			"wrong CRC: type 0x%02X length %d", g_au8Frame[0], iLen);
+
+	// Block announced longer than the frame
+	static const uint8_t au8Truncated[] = { 0x05, GWB_STATUS, 0x12, 0x00 };
+	Send(au8Truncated, sizeof(au8Truncated));
+	Pump();
+	iLen = ReceiveFrame(TEST_TIMEOUT_MS);
+	CHECK(iLen == 4 && g_au8Frame[0] == GWB_NACK
+			&& g_au8Frame[3] == CO_GWB_NACK_FRAME,
+			"truncated block: type 0x%02X length %d", g_au8Frame[0], iLen);
+
+	au8Frame[0] = GWB_STATUS;
+	SendFrame(au8Frame, 1);
+	Pump();
+	iLen = ReceiveFrame(TEST_TIMEOUT_MS);
+	CHECK(iLen == 6 && g_au8Frame[0] == GWB_STATUS
+			&& (g_au8Frame[4] | (g_au8Frame[5] << 8)) == 2,
+			"status after the errors: type 0x%02X length %d", g_au8Frame[0],
+			iLen);
+}
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in of the CubeMX main.h, only what CO_driver_target.h and CO_gatewayBin_STM32.c use
+ */
+#ifndef GATEWAY_TEST_MAIN_H
+#define GATEWAY_TEST_MAIN_H
+
+#include <stdint.h>
+
+typedef int IRQn_Type;
+#define CAN 1
+#define __DMB() __sync_synchronize()
+
+#endif /* GATEWAY_TEST_MAIN_H */